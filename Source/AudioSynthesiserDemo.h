@@ -52,6 +52,7 @@ linux_make, androidstudio, xcode_iphone
 
 #pragma once
 
+#include "Common/SphereSPSCQueue.h"
 #include "DemoUtilities.h"
 #include "SphereSynthAudio.h"
 #include "SphereSynthResources.h"
@@ -141,7 +142,7 @@ public:
 
     audioDeviceManager.addAudioCallback(&callback);
     audioDeviceManager.addMidiInputDeviceCallback(
-        {}, &(synthAudioSource.midiCollector));
+        {}, &(synthAudioSource.midiInput));
     // NOTE: Removed duplicate MIDI callback registration that was causing
     // double note processing
     keyboardState.addListener(this);
@@ -154,13 +155,22 @@ public:
   ~AudioSynthesiserDemo() override {
     audioSourcePlayer.setSource(nullptr);
     audioDeviceManager.removeMidiInputDeviceCallback(
-        {}, &(synthAudioSource.midiCollector));
+        {}, &(synthAudioSource.midiInput));
     audioDeviceManager.removeAudioCallback(&callback);
     keyboardState.removeListener(this);
     stopTimer();
   }
 
   void timerCallback() override {
+    synthAudioSource.updateMidiLearn();
+
+    // Notes the audio thread played since the last tick
+    NoteEvent event;
+    while (noteEvents.pop(event))
+      webView.evaluateJavascript(
+          String(event.isNoteOn ? "visualizeNoteOn(" : "visualizeNoteOff(") +
+          String(event.midiNoteNumber) + ")");
+
     float levelL =
         std::min(1.0f, synthAudioSource.currentRMSLeft.load() * 6.0f);
     float levelR =
@@ -209,6 +219,15 @@ public:
   void sendDevicesToUI();
 
 private:
+  // Keyboard state listeners run on the audio thread; the timer forwards
+  // their notes to the page
+  struct NoteEvent {
+    int midiNoteNumber;
+    bool isNoteOn;
+  };
+
+  Sphere::SPSCQueue<NoteEvent, 256> noteEvents;
+
 #ifndef JUCE_DEMO_RUNNER
   AudioDeviceManager audioDeviceManager;
 #else
@@ -238,20 +257,15 @@ inline void AudioSynthesiserDemo::handleNoteOn(MidiKeyboardState *,
                                                int midiChannel,
                                                int midiNoteNumber,
                                                float velocity) {
-  MessageManager::callAsync([this, midiNoteNumber, velocity]() {
-    webView.evaluateJavascript("visualizeNoteOn(" + String(midiNoteNumber) +
-                               ")");
-  });
+  // A full queue only costs a key highlight
+  noteEvents.push({midiNoteNumber, true});
 }
 
 inline void AudioSynthesiserDemo::handleNoteOff(MidiKeyboardState *,
                                                 int midiChannel,
                                                 int midiNoteNumber,
                                                 float velocity) {
-  MessageManager::callAsync([this, midiNoteNumber]() {
-    webView.evaluateJavascript("visualizeNoteOff(" + String(midiNoteNumber) +
-                               ")");
-  });
+  noteEvents.push({midiNoteNumber, false});
 }
 
 inline void AudioSynthesiserDemo::handleSphereCommand(const String &url) {
@@ -263,10 +277,13 @@ inline void AudioSynthesiserDemo::handleSphereCommand(const String &url) {
   if (parts[0] == "noteOn") {
     int note = parts[1].getIntValue();
     int velocity = parts[2].getIntValue();
-    keyboardState.noteOn(1, note, (float)velocity / 127.0f);
+    synthAudioSource.midiInput.post(
+        MidiMessage::noteOn(1, note, (float)velocity / 127.0f),
+        Sphere::LatencyPath::UI);
   } else if (parts[0] == "noteOff") {
     int note = parts[1].getIntValue();
-    keyboardState.noteOff(1, note, 0.0f);
+    synthAudioSource.midiInput.post(MidiMessage::noteOff(1, note, 0.0f),
+                                    Sphere::LatencyPath::UI);
   } else if (parts[0] == "sound") {
     if (parts[1] == "sine") {
       synthAudioSource.setUsingSineWaveSound();
@@ -274,8 +291,270 @@ inline void AudioSynthesiserDemo::handleSphereCommand(const String &url) {
       synthAudioSource.setUsingSawWaveSound();
     } else if (parts[1] == "square") {
       synthAudioSource.setUsingSquareWaveSound();
+    } else if (parts[1] == "triangle") {
+      synthAudioSource.setUsingTriangleWaveSound();
+    } else if (parts[1] == "wavetable") {
+      synthAudioSource.setUsingWavetableSound();
     } else if (parts[1] == "sampled") {
       synthAudioSource.setUsingSampledSound();
+    } else if (parts[1] == "stream") {
+      // Format: sound/stream/<absolute file path>
+      auto path = URL::removeEscapeChars(
+          cmd.fromFirstOccurrenceOf("sound/stream/", false, false));
+      synthAudioSource.setUsingStreamedSound(File(path));
+    } else if (parts[1] == "fm") {
+      // Format: sound/fm/<algorithm 0..7>
+      const int algorithm = juce::jlimit(
+          0, static_cast<int>(Sphere::Synth::FMAlgorithm::NumAlgorithms) - 1,
+          parts[2].getIntValue());
+      synthAudioSource.setUsingFMSound(
+          static_cast<Sphere::Synth::FMAlgorithm>(algorithm));
+    } else if (parts[1] == "granular") {
+      // Format: sound/granular[/position/density/grainMs/spread]
+      Sphere::Synth::GranularParams params;
+      if (parts.size() >= 6) {
+        params.position = juce::jlimit(0.0f, 1.0f, parts[2].getFloatValue());
+        params.density = juce::jlimit(1.0f, 400.0f, parts[3].getFloatValue());
+        params.grainLength =
+            juce::jlimit(1.0f, 1000.0f, parts[4].getFloatValue()) * 0.001f;
+        params.spread = juce::jlimit(0.0f, 1.0f, parts[5].getFloatValue());
+      }
+      synthAudioSource.setUsingGranularSound(params);
+    } else if (parts[1] == "additive") {
+      // Format: sound/additive[/partials/rolloff/evolveRateHz]
+      Sphere::Synth::AdditivePatch patch;
+      if (parts.size() >= 5) {
+        patch.numPartials = juce::jlimit(1, Sphere::Synth::MAX_PARTIALS,
+                                         parts[2].getIntValue());
+        patch.rolloff = juce::jlimit(0.0f, 4.0f, parts[3].getFloatValue());
+        patch.evolveRate = juce::jlimit(0.0f, 20.0f, parts[4].getFloatValue());
+      }
+      synthAudioSource.setUsingAdditiveSound(patch);
+    } else if (parts[1] == "string") {
+      // Format: sound/string/pluck|bow[/decaySeconds/brightness]
+      Sphere::Synth::WaveguidePatch patch;
+      if (parts[2] == "bow")
+        patch.excitation = Sphere::Synth::StringExcitation::Bow;
+      if (parts.size() >= 5) {
+        patch.decay = juce::jlimit(0.05f, 30.0f, parts[3].getFloatValue());
+        patch.brightness = juce::jlimit(0.0f, 1.0f, parts[4].getFloatValue());
+      }
+      synthAudioSource.setUsingWaveguideSound(patch);
+    }
+  } else if (parts[0] == "sample") {
+    if (parts[1] == "storage") {
+      // Format: sample/storage/float|int16|int24
+      if (parts[2] == "int16")
+        synthAudioSource.setSampleStorage(Sphere::Synth::SampleEncoding::Int16);
+      else if (parts[2] == "int24")
+        synthAudioSource.setSampleStorage(Sphere::Synth::SampleEncoding::Int24);
+      else
+        synthAudioSource.setSampleStorage(
+            Sphere::Synth::SampleEncoding::Float32);
+    } else if (parts[1] == "quality") {
+      // Format: sample/quality/low|medium|high (8/16/32 sinc taps)
+      if (parts[2] == "high")
+        synthAudioSource.setSampleInterpolationQuality(
+            Sphere::SincQuality::High);
+      else if (parts[2] == "medium")
+        synthAudioSource.setSampleInterpolationQuality(
+            Sphere::SincQuality::Medium);
+      else
+        synthAudioSource.setSampleInterpolationQuality(
+            Sphere::SincQuality::Low);
+    }
+  } else if (parts[0] == "osc") {
+    if (parts[1] == "pulsewidth") {
+      // Format: osc/pulsewidth/0..1
+      synthAudioSource.setOscillatorPulseWidth(parts[2].getFloatValue());
+    } else if (parts[1] == "sync") {
+      // Format: osc/sync/ratio (1 = off)
+      synthAudioSource.setOscillatorSyncRatio(parts[2].getFloatValue());
+    } else if (parts[1] == "unison" && parts.size() >= 5) {
+      // Format: osc/unison/voices/detuneCents/spread (voices 1..16)
+      synthAudioSource.setOscillatorUnison(parts[2].getIntValue(),
+                                           parts[3].getFloatValue(),
+                                           parts[4].getFloatValue());
+    } else if (parts[1] == "filter") {
+      // Format: osc/filter/off|lowpass|bandpass|highpass|notch
+      //   [/cutoffHz[/resonance[/keytrack]]] (resonance as Q, keytrack 0..1)
+      auto mode = Sphere::Synth::FilterMode::Off;
+      if (parts[2] == "lowpass")
+        mode = Sphere::Synth::FilterMode::LowPass;
+      else if (parts[2] == "bandpass")
+        mode = Sphere::Synth::FilterMode::BandPass;
+      else if (parts[2] == "highpass")
+        mode = Sphere::Synth::FilterMode::HighPass;
+      else if (parts[2] == "notch")
+        mode = Sphere::Synth::FilterMode::Notch;
+
+      synthAudioSource.setOscillatorFilter(
+          mode, parts.size() >= 4 ? parts[3].getFloatValue() : 2000.0f,
+          parts.size() >= 5 ? parts[4].getFloatValue()
+                            : Sphere::Synth::VoiceFilter::DEFAULT_RESONANCE,
+          parts.size() >= 6 ? parts[5].getFloatValue() : 0.0f);
+    }
+  } else if (parts[0] == "mod") {
+    auto settings = synthAudioSource.getModulation();
+    if (parts[1] == "route" && parts.size() >= 5) {
+      // Format: mod/route/source/destination/amount[/via]
+      // e.g. mod/route/lfo1/pitch/0.5/modwheel, mod/route/env1/amplitude/1,
+      // mod/route/env2/cutoff/36 (semitones)
+      Sphere::Synth::ModRoute route;
+      route.source = Sphere::Synth::findModSource(parts[2]);
+      route.destination = Sphere::Synth::findModDestination(parts[3]);
+      route.amount = parts[4].getFloatValue();
+      if (parts.size() >= 6)
+        route.via = Sphere::Synth::findModSource(parts[5]);
+      if (settings.routes.size() <
+          static_cast<size_t>(Sphere::Synth::MAX_MOD_ROUTES))
+        settings.routes.push_back(route);
+    } else if (parts[1] == "clear") {
+      // Format: mod/clear (removes every route)
+      settings.routes.clear();
+    } else if (parts[1] == "lfo" && parts.size() >= 5) {
+      // Format: mod/lfo/1|2|global1|global2/sine|triangle|saw|square|random
+      //   /rateHz
+      const int index = parts[2].getTrailingIntValue() == 2 ? 1 : 0;
+      auto &lfo = parts[2].startsWith("global") ? settings.globalLFOs[index]
+                                                : settings.voiceLFOs[index];
+      if (parts[3] == "triangle")
+        lfo.shape = Sphere::Synth::LFOShape::Triangle;
+      else if (parts[3] == "saw")
+        lfo.shape = Sphere::Synth::LFOShape::Saw;
+      else if (parts[3] == "square")
+        lfo.shape = Sphere::Synth::LFOShape::Square;
+      else if (parts[3] == "random")
+        lfo.shape = Sphere::Synth::LFOShape::SampleAndHold;
+      else
+        lfo.shape = Sphere::Synth::LFOShape::Sine;
+      lfo.rateHz = juce::jlimit(0.01f, 100.0f, parts[4].getFloatValue());
+    } else if (parts[1] == "env" && parts.size() >= 7) {
+      // Format: mod/env/1|2/attack/decay/sustain/release (seconds, 0..1)
+      auto &env = settings.envelopes[parts[2].getIntValue() == 2 ? 1 : 0];
+      env.attack = juce::jlimit(0.0f, 30.0f, parts[3].getFloatValue());
+      env.decay = juce::jlimit(0.0f, 30.0f, parts[4].getFloatValue());
+      env.sustain = juce::jlimit(0.0f, 1.0f, parts[5].getFloatValue());
+      env.release = juce::jlimit(0.0f, 30.0f, parts[6].getFloatValue());
+    } else if (parts[1] == "rate") {
+      // Format: mod/rate/samplesPerTick (8..256)
+      settings.controlInterval = parts[2].getIntValue();
+    }
+    synthAudioSource.setModulation(settings);
+  } else if (parts[0] == "learn") {
+    auto settings = synthAudioSource.getMidiLearn();
+    const auto target = Sphere::Synth::findControlTarget(parts[2]);
+    const bool known = target != Sphere::Synth::ControlTarget::NumTargets;
+    if ((parts[1] == "cc" || parts[1] == "nrpn") && known &&
+        parts.size() >= 5) {
+      // Format: learn/cc|nrpn/target/channel/number
+      // e.g. learn/cc/cutoff/1/74, learn/nrpn/mastergain/1/1024
+      Sphere::Synth::MidiLearnBinding binding;
+      binding.target = target;
+      binding.channel = parts[3].getIntValue();
+      binding.number = parts[4].getIntValue();
+      binding.nrpn = parts[1] == "nrpn";
+      settings.bind(binding);
+    } else if (parts[1] == "start" && known) {
+      // Format: learn/start/target (the next controller moved is bound)
+      synthAudioSource.learnController(target);
+      return;
+    } else if (parts[1] == "clear") {
+      // Format: learn/clear[/target]
+      if (known)
+        settings.unbindTarget(target);
+      else
+        settings.bindings.clear();
+    } else if (parts[1] == "smoothing" && known && parts.size() >= 4) {
+      // Format: learn/smoothing/target/milliseconds
+      settings.smoothingSeconds[static_cast<size_t>(target)] =
+          juce::jlimit(0.0f, 2000.0f, parts[3].getFloatValue()) * 0.001f;
+    }
+    synthAudioSource.setMidiLearn(settings);
+  } else if (parts[0] == "latency") {
+    auto &probe = synthAudioSource.latencyProbe;
+    if (parts[1] == "reset") {
+      // Format: latency/reset
+      probe.reset();
+    } else if (parts[1] == "report") {
+      // Format: latency/report (milliseconds, to updateLatency())
+      auto toJson = [](const Sphere::LatencyHistogram::Summary &summary) {
+        return "{ \"count\": " + String(summary.count) +
+               ", \"p50\": " + String(summary.p50, 3) +
+               ", \"p99\": " + String(summary.p99, 3) +
+               ", \"max\": " + String(summary.max, 3) + " }";
+      };
+
+      String json = "{ ";
+      for (int p = 0; p < Sphere::NUM_LATENCY_PATHS; ++p) {
+        const auto path = static_cast<Sphere::LatencyPath>(p);
+        json += "\"" + String(Sphere::getLatencyPathName(path)) +
+                "\": " + toJson(probe.getTotal(path)) + ", ";
+      }
+      json += "\"queued\": " + toJson(probe.getQueued()) +
+              ", \"render\": " + toJson(probe.getRendered()) + " }";
+
+      webView.evaluateJavascript("updateLatency(" + json + ")");
+    }
+  } else if (parts[0] == "midi") {
+    auto &player = synthAudioSource.getMidiFilePlayer();
+    if (parts[1] == "load") {
+      // Format: midi/load/<absolute file path> (loads stopped)
+      auto path = URL::removeEscapeChars(
+          cmd.fromFirstOccurrenceOf("midi/load/", false, false));
+      synthAudioSource.loadMidiFile(File(path));
+    } else if (parts[1] == "play") {
+      player.play();
+    } else if (parts[1] == "stop") {
+      player.stop();
+    } else if (parts[1] == "loop") {
+      // Format: midi/loop/on|off
+      player.setLooping(parts[2] == "on");
+    } else if (parts[1] == "seek") {
+      // Format: midi/seek/seconds
+      player.seek(parts[2].getDoubleValue());
+    }
+  } else if (parts[0] == "voices") {
+    if (parts[1] == "count" && parts.size() >= 5) {
+      // Format:
+      // voices/count/oscillator/sampler/streaming
+      //   [/fm[/granular[/additive[/string]]]]
+      auto counts = SynthAudioSource::getDefaultVoiceCounts();
+      counts.oscillator = parts[2].getIntValue();
+      counts.sampler = parts[3].getIntValue();
+      counts.streaming = parts[4].getIntValue();
+      if (parts.size() >= 6)
+        counts.fm = parts[5].getIntValue();
+      if (parts.size() >= 7)
+        counts.granular = parts[6].getIntValue();
+      if (parts.size() >= 8)
+        counts.additive = parts[7].getIntValue();
+      if (parts.size() >= 9)
+        counts.waveguide = parts[8].getIntValue();
+      synthAudioSource.setVoiceCounts(counts);
+    } else if (parts[1] == "threads") {
+      // Format: voices/threads/n (0 = audio thread only)
+      synthAudioSource.setNumRenderThreads(parts[2].getIntValue());
+    } else if (parts[1] == "steal") {
+      // Format: voices/steal/oldest|quietest|samenote
+      if (parts[2] == "quietest")
+        synthAudioSource.setVoiceStealingMode(
+            Sphere::Synth::VoiceStealingMode::Quietest);
+      else if (parts[2] == "samenote")
+        synthAudioSource.setVoiceStealingMode(
+            Sphere::Synth::VoiceStealingMode::SameNote);
+      else
+        synthAudioSource.setVoiceStealingMode(
+            Sphere::Synth::VoiceStealingMode::Oldest);
+    }
+  } else if (parts[0] == "wavetable") {
+    if (parts[1] == "load") {
+      // Format: wavetable/load/assetName.wav
+      synthAudioSource.loadWavetable(parts[2].toRawUTF8());
+      synthAudioSource.setUsingWavetableSound();
+    } else if (parts[1] == "position") {
+      // Format: wavetable/position/0..1
+      synthAudioSource.setWavetablePosition(parts[2].getFloatValue());
     }
   } else if (parts[0] == "getDevices") {
     sendDevicesToUI();
@@ -302,7 +581,7 @@ inline void AudioSynthesiserDemo::handleSphereCommand(const String &url) {
       if (!audioDeviceManager.isMidiInputDeviceEnabled(newId)) {
         audioDeviceManager.setMidiInputDeviceEnabled(newId, true);
         audioDeviceManager.addMidiInputDeviceCallback(
-            newId, &(synthAudioSource.midiCollector));
+            newId, &(synthAudioSource.midiInput));
       }
       sendDevicesToUI();
     }
@@ -312,7 +591,8 @@ inline void AudioSynthesiserDemo::handleSphereCommand(const String &url) {
       bool enable = parts[2].getIntValue() != 0;
       synthAudioSource.setEQEnabled(enable);
     } else if (parts[1] == "band") {
-      // Format: eq/band/index/active/type/freq/gain/q
+      // Format: eq/band/index/active/type/freq/gain/q (the band's other
+      // settings - slope, dynamics, topology, modulation - are kept)
       int bandIndex = parts[2].getIntValue();
       bool active = parts[3].getIntValue() != 0;
       String typeStr = parts[4];
@@ -320,7 +600,7 @@ inline void AudioSynthesiserDemo::handleSphereCommand(const String &url) {
       double gain = parts[6].getDoubleValue();
       double q = parts[7].getDoubleValue();
 
-      Sphere::EQBandParams params;
+      auto params = synthAudioSource.getEQBandParameters(bandIndex);
       params.bypass = !active;
       params.frequency = freq;
       params.gainDb = gain;
@@ -424,6 +704,22 @@ inline void AudioSynthesiserDemo::handleSphereCommand(const String &url) {
         mode = Sphere::EQCharacterMode::Warm;
 
       synthAudioSource.setEQCharacterMode(mode);
+    } else if (parts[1] == "modulation") {
+      // Format: eq/modulation/bandIndex/topology/rate/depth/envelope
+      int bandIndex = parts[2].getIntValue();
+      String topologyStr = parts[3];
+      double rate = parts[4].getDoubleValue();
+      double depth = parts[5].getDoubleValue();
+      double envelope = parts[6].getDoubleValue();
+
+      synthAudioSource.setEQBandTopology(
+          bandIndex, topologyStr == "svf" ? Sphere::EQBandTopology::SVF
+                                          : Sphere::EQBandTopology::Biquad);
+      synthAudioSource.setEQBandModulation(bandIndex, rate, depth, envelope);
+    } else if (parts[1] == "smoothing") {
+      // Format: eq/smoothing/ms
+      double ms = juce::jlimit(0.0, 500.0, parts[2].getDoubleValue());
+      synthAudioSource.setEQSmoothingTime(ms * 0.001);
     }
   }
 }
@@ -0,0 +1,149 @@
+/*
+  ==============================================================================
+    SphereFFT.h
+    Radix-2 FFT with precomputed twiddles, shared by the EQ and the synth
+
+    One instance holds the twiddle table for a size and is immutable after
+    construction, so any number of users (and threads) can run transforms
+    on their own buffers through it. Real transforms run as a half-size
+    complex transform plus one packing pass, roughly halving their cost.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <complex>
+#include <vector>
+
+namespace Sphere {
+
+// ============================================================================
+// FFT
+// ============================================================================
+template <typename FloatType> class FFT {
+public:
+  using Complex = std::complex<FloatType>;
+
+  explicit FFT(int fftOrder) : order(fftOrder), size(1 << fftOrder) {
+    jassert(fftOrder >= 1);
+    twiddles.resize(static_cast<size_t>(size / 2));
+    inverseTwiddles.resize(twiddles.size());
+
+    for (int k = 0; k < size / 2; ++k) {
+      const double angle =
+          -2.0 * juce::MathConstants<double>::pi * k / size;
+      twiddles[k] = Complex(static_cast<FloatType>(std::cos(angle)),
+                            static_cast<FloatType>(std::sin(angle)));
+      inverseTwiddles[k] = std::conj(twiddles[k]);
+    }
+  }
+
+  int getOrder() const { return order; }
+  int getSize() const { return size; }
+
+  // In place on getSize() values; the forward transform is unscaled and
+  // the inverse is scaled by 1 / getSize()
+  void forward(Complex *data) const { transform(data, size, twiddles); }
+
+  void inverse(Complex *data) const {
+    transform(data, size, inverseTwiddles);
+    const auto scale = static_cast<FloatType>(1.0 / size);
+    for (int i = 0; i < size; ++i)
+      data[i] *= scale;
+  }
+
+  // getSize() real samples to bins 0..getSize() / 2 (getSize() / 2 + 1
+  // values)
+  void forwardReal(const FloatType *input, Complex *spectrum) const {
+    const int half = size / 2;
+    for (int n = 0; n < half; ++n)
+      spectrum[n] = Complex(input[2 * n], input[2 * n + 1]);
+
+    transform(spectrum, half, twiddles);
+
+    // Split the packed transform into the even and odd samples' spectra
+    const Complex z0 = spectrum[0];
+    spectrum[0] = Complex(z0.real() + z0.imag(), 0);
+    spectrum[half] = Complex(z0.real() - z0.imag(), 0);
+
+    const Complex minusHalfI(0, static_cast<FloatType>(-0.5));
+    for (int k = 1; k <= half / 2; ++k) {
+      const Complex zk = spectrum[k];
+      const Complex zmk = std::conj(spectrum[half - k]);
+      const Complex even = (zk + zmk) * static_cast<FloatType>(0.5);
+      const Complex odd = (zk - zmk) * minusHalfI * twiddles[k];
+
+      spectrum[k] = even + odd;
+      spectrum[half - k] = std::conj(even - odd);
+    }
+  }
+
+  // Bins 0..getSize() / 2 to getSize() real samples, scaled by
+  // 1 / getSize(). The spectrum is used as scratch; output may alias it.
+  void inverseReal(Complex *spectrum, FloatType *output) const {
+    const int half = size / 2;
+    const Complex halfI(0, static_cast<FloatType>(0.5));
+
+    // Pack the even and odd samples' spectra into one half-size transform
+    {
+      const Complex x0 = spectrum[0];
+      const Complex xm = std::conj(spectrum[half]);
+      spectrum[0] = (x0 + xm) * static_cast<FloatType>(0.5) + (x0 - xm) * halfI;
+    }
+
+    for (int k = 1; k <= half / 2; ++k) {
+      const Complex xk = spectrum[k];
+      const Complex xmk = std::conj(spectrum[half - k]);
+      const Complex even = (xk + xmk) * static_cast<FloatType>(0.5);
+      const Complex odd = (xk - xmk) * halfI * inverseTwiddles[k];
+
+      spectrum[k] = even + odd;
+      spectrum[half - k] = std::conj(even - odd);
+    }
+
+    transform(spectrum, half, inverseTwiddles);
+
+    const auto scale = static_cast<FloatType>(1.0 / half);
+    const auto *packed = reinterpret_cast<const FloatType *>(spectrum);
+    for (int i = 0; i < size; ++i)
+      output[i] = packed[i] * scale;
+  }
+
+private:
+  // n-point transform (n divides size) using every (size / n)th twiddle
+  void transform(Complex *data, int n,
+                 const std::vector<Complex> &table) const {
+    for (int i = 1, j = 0; i < n; ++i) {
+      int bit = n >> 1;
+      for (; (j & bit) != 0; bit >>= 1)
+        j ^= bit;
+      j ^= bit;
+      if (i < j)
+        std::swap(data[i], data[j]);
+    }
+
+    const int stride = size / n;
+    for (int length = 2; length <= n; length <<= 1) {
+      const int halfLength = length / 2;
+      const int step = stride * (n / length);
+
+      for (int i = 0; i < n; i += length) {
+        Complex *a = data + i;
+        Complex *b = a + halfLength;
+        for (int j = 0; j < halfLength; ++j) {
+          const Complex v = b[j] * table[static_cast<size_t>(j * step)];
+          b[j] = a[j] - v;
+          a[j] += v;
+        }
+      }
+    }
+  }
+
+  int order;
+  int size;
+  std::vector<Complex> twiddles;        // e^(-2 pi i k / size)
+  std::vector<Complex> inverseTwiddles; // conjugates
+};
+
+} // namespace Sphere
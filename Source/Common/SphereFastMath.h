@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+    SphereFastMath.h
+    Branch-free polynomial approximations shared by the synth and EQ engines
+
+    All functions are written so that a loop over a fixed number of lanes
+    auto-vectorizes (no table lookups, no library calls, selects instead of
+    branches).
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cmath>
+
+namespace Sphere {
+namespace FastMath {
+
+// ============================================================================
+// sin(pi * z) for z in [-0.5, 0.5]
+// 9th order odd polynomial, max error ~4e-6
+// ============================================================================
+inline float sinPi(float z) {
+  const float z2 = z * z;
+  return z *
+         (3.14159265f +
+          z2 * (-5.16771278f +
+                z2 * (2.55016404f + z2 * (-0.59926453f + z2 * 0.08214589f))));
+}
+
+// ============================================================================
+// sin(2 * pi * phase) for a normalized phase in [0, 1), range-reduced to
+// sinPi()
+// ============================================================================
+inline float sinCycle(float phase) {
+  // sin(2*pi*p) = -sin(pi*u) with u = 2p - 1 in [-1, 1)
+  const float u = 2.0f * phase - 1.0f;
+  const float a = std::abs(u);
+
+  // Fold into [-0.5, 0.5] using sin(pi*u) = sin(pi*(sign(u) - u))
+  const float z = (a > 0.5f) ? std::copysign(1.0f - a, u) : u;
+  return -sinPi(z);
+}
+
+// cos(2 * pi * phase) for a normalized phase in [0, 1)
+inline float cosCycle(float phase) {
+  const float shifted = phase + 0.25f;
+  return sinCycle(shifted - (shifted >= 1.0f ? 1.0f : 0.0f));
+}
+
+// ============================================================================
+// tan(pi * x) for x in [0, 0.5), e.g. the prewarped gain tan(pi * fc / fs)
+// of a TPT filter. Sine over cosine without range reduction keeps the
+// relative error small from DC up to close to the pole at 0.5.
+// ============================================================================
+inline float tanPi(float x) { return sinPi(x) / sinPi(0.5f - x); }
+
+// ============================================================================
+// Phase wrapping helpers
+// ============================================================================
+inline float wrapPhase(float phase) {
+  return phase - (phase >= 1.0f ? 1.0f : 0.0f);
+}
+
+// Any phase (e.g. a modulated one) into [0, 1]; 1 only for tiny negative
+// inputs, where both sinCycle and cosCycle are still exact
+inline float wrapPhaseFull(float phase) { return phase - std::floor(phase); }
+
+} // namespace FastMath
+} // namespace Sphere
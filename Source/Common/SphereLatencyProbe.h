@@ -0,0 +1,223 @@
+/*
+  ==============================================================================
+    SphereLatencyProbe.h
+    Note-on to output latency histograms, written by the audio thread
+
+    Every note-on that enters through the MIDI input queue carries the time
+    it arrived (driver timestamp for devices, the moment of posting for the
+    UI and other producers). When the audio thread drains it, the probe
+    remembers the note together with its ingress and drain times; when the
+    synth actually starts a voice for it the note is marked as sounding,
+    and when the block leaves getNextAudioBlock() the probe records
+
+      total   = block finished - ingress   (per input path)
+      queued  = drained        - ingress   (waiting for the next block)
+      render  = block finished - drained   (rendering the block)
+
+    Notes that started no voice are dropped. All times use the same clock
+    as juce::MidiInput timestamps.
+
+    Histograms have logarithmic bins (eight per octave from 10 us), so a
+    percentile is exact to within about 9%. The audio thread is the only
+    writer; counters are atomics, so any thread can read a summary or
+    reset them while audio runs.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <cmath>
+
+namespace Sphere {
+
+// Where a message entered the engine
+enum class LatencyPath : uint8_t { Device, UI, Remote, NumPaths };
+
+constexpr int NUM_LATENCY_PATHS = static_cast<int>(LatencyPath::NumPaths);
+
+// Names used by the IPC commands
+inline const char *getLatencyPathName(LatencyPath path) {
+  static constexpr const char *names[NUM_LATENCY_PATHS] = {"device", "ui",
+                                                           "remote"};
+  return names[static_cast<int>(path)];
+}
+
+// ============================================================================
+// Lock-free latency histogram (single writer, any number of readers)
+// ============================================================================
+class LatencyHistogram {
+public:
+  static constexpr int BINS_PER_OCTAVE = 8;
+  static constexpr int NUM_BINS = 1 + 17 * BINS_PER_OCTAVE; // 10 us .. 1.3 s
+  static constexpr double FIRST_BIN_SECONDS = 1.0e-5;
+
+  // Milliseconds; percentiles are the upper edge of their bin
+  struct Summary {
+    uint32_t count = 0;
+    double p50 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+  };
+
+  // Writer thread only
+  void add(double seconds) {
+    seconds = juce::jmax(0.0, seconds);
+    bins[static_cast<size_t>(getBin(seconds))].fetch_add(
+        1, std::memory_order_relaxed);
+
+    const auto micros = static_cast<uint32_t>(
+        juce::jmin(seconds * 1.0e6, 4.0e9));
+    if (micros > maxMicros.load(std::memory_order_relaxed))
+      maxMicros.store(micros, std::memory_order_relaxed);
+  }
+
+  // Any thread; a snapshot taken while the writer runs may be off by the
+  // notes recorded during the scan
+  Summary getSummary() const {
+    std::array<uint32_t, NUM_BINS> snapshot;
+    uint32_t total = 0;
+    for (int b = 0; b < NUM_BINS; ++b) {
+      snapshot[static_cast<size_t>(b)] =
+          bins[static_cast<size_t>(b)].load(std::memory_order_relaxed);
+      total += snapshot[static_cast<size_t>(b)];
+    }
+
+    Summary summary;
+    summary.count = total;
+    summary.max = maxMicros.load(std::memory_order_relaxed) * 1.0e-3;
+    if (total == 0)
+      return summary;
+
+    summary.p50 = getPercentile(snapshot, total, 0.50);
+    summary.p99 = getPercentile(snapshot, total, 0.99);
+    return summary;
+  }
+
+  // Any thread
+  void reset() {
+    for (auto &bin : bins)
+      bin.store(0, std::memory_order_relaxed);
+    maxMicros.store(0, std::memory_order_relaxed);
+  }
+
+private:
+  static int getBin(double seconds) {
+    if (seconds < FIRST_BIN_SECONDS)
+      return 0;
+    const double octaves = std::log2(seconds / FIRST_BIN_SECONDS);
+    const int bin = 1 + static_cast<int>(octaves * BINS_PER_OCTAVE);
+    return juce::jmin(bin, NUM_BINS - 1);
+  }
+
+  // Milliseconds
+  static double getBinUpperEdge(int bin) {
+    return FIRST_BIN_SECONDS *
+           std::exp2(static_cast<double>(bin) / BINS_PER_OCTAVE) * 1.0e3;
+  }
+
+  static double getPercentile(const std::array<uint32_t, NUM_BINS> &snapshot,
+                              uint32_t total, double fraction) {
+    const auto rank = static_cast<uint32_t>(std::ceil(total * fraction));
+    uint32_t seen = 0;
+    for (int b = 0; b < NUM_BINS; ++b) {
+      seen += snapshot[static_cast<size_t>(b)];
+      if (seen >= juce::jmax(1u, rank))
+        return getBinUpperEdge(b);
+    }
+    return getBinUpperEdge(NUM_BINS - 1);
+  }
+
+  std::array<std::atomic<uint32_t>, NUM_BINS> bins{};
+  std::atomic<uint32_t> maxMicros{0};
+};
+
+// ============================================================================
+// Note latency probe
+// ============================================================================
+class NoteLatencyProbe {
+public:
+  // Note-ons tracked per block; more are not measured
+  static constexpr int MAX_PENDING_NOTES = 256;
+
+  // ========================================================================
+  // Audio thread
+  // ========================================================================
+  // A note-on taken off the input queue at drainTime
+  void noteReceived(int midiChannel, int midiNoteNumber, LatencyPath path,
+                    double ingressTime, double drainTime) {
+    if (numPending == MAX_PENDING_NOTES)
+      return;
+
+    pending[static_cast<size_t>(numPending++)] = {
+        ingressTime, drainTime, static_cast<uint8_t>(midiChannel),
+        static_cast<uint8_t>(midiNoteNumber), path, false};
+  }
+
+  // A voice started for the note; the oldest waiting one is matched
+  void noteStarted(int midiChannel, int midiNoteNumber) {
+    for (int i = 0; i < numPending; ++i) {
+      auto &note = pending[static_cast<size_t>(i)];
+      if (!note.started && note.channel == midiChannel &&
+          note.noteNumber == midiNoteNumber) {
+        note.started = true;
+        return;
+      }
+    }
+  }
+
+  // The block holding the notes' first samples is leaving the engine
+  void blockFinished(double time) {
+    for (int i = 0; i < numPending; ++i) {
+      const auto &note = pending[static_cast<size_t>(i)];
+      if (!note.started)
+        continue;
+
+      totals[static_cast<size_t>(note.path)].add(time - note.ingressTime);
+      queued.add(note.drainTime - note.ingressTime);
+      rendered.add(time - note.drainTime);
+    }
+    numPending = 0;
+  }
+
+  // ========================================================================
+  // Any thread
+  // ========================================================================
+  LatencyHistogram::Summary getTotal(LatencyPath path) const {
+    return totals[static_cast<size_t>(path)].getSummary();
+  }
+
+  LatencyHistogram::Summary getQueued() const { return queued.getSummary(); }
+  LatencyHistogram::Summary getRendered() const {
+    return rendered.getSummary();
+  }
+
+  void reset() {
+    for (auto &histogram : totals)
+      histogram.reset();
+    queued.reset();
+    rendered.reset();
+  }
+
+private:
+  struct PendingNote {
+    double ingressTime;
+    double drainTime;
+    uint8_t channel;
+    uint8_t noteNumber;
+    LatencyPath path;
+    bool started;
+  };
+
+  // Audio thread only
+  std::array<PendingNote, MAX_PENDING_NOTES> pending{};
+  int numPending = 0;
+
+  std::array<LatencyHistogram, NUM_LATENCY_PATHS> totals;
+  LatencyHistogram queued;
+  LatencyHistogram rendered;
+};
+
+} // namespace Sphere
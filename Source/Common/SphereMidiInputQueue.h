@@ -0,0 +1,177 @@
+/*
+  ==============================================================================
+    SphereMidiInputQueue.h
+    Lock-free, timestamped MIDI input shared by every producer thread
+
+    MIDI device callbacks, the UI and any other control source post short
+    messages stamped with the high-resolution millisecond clock that JUCE
+    device input already uses. Posting never blocks: each slot carries a
+    sequence number saying which position it is free for, a producer
+    claims the next position with a compare-and-swap (retrying only if
+    another producer took it at the same moment) and publishes the slot
+    with a release store. A full queue drops the message and counts it
+    rather than waiting for the audio thread.
+
+    The audio thread is the only consumer. Once per block it drains the
+    published slots and places each message at the sample offset its
+    timestamp falls on within the block that has just elapsed, so input
+    arrives with a constant one-block delay instead of being quantized to
+    the next block boundary. Each message is tagged with its input path,
+    so a NoteLatencyProbe can follow its note-ons through to the output.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "SphereLatencyProbe.h"
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+
+namespace Sphere {
+
+// ============================================================================
+// MIDI Input Queue (multiple producers, audio thread consumer)
+// ============================================================================
+class MidiInputQueue : public juce::MidiInputCallback {
+public:
+  static constexpr int CAPACITY = 4096; // power of two
+
+  MidiInputQueue() {
+    for (size_t i = 0; i < slots.size(); ++i)
+      slots[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  // Same clock as juce::MidiInput timestamps, in seconds
+  static double getCurrentTime() {
+    return juce::Time::getMillisecondCounterHiRes() * 0.001;
+  }
+
+  // ========================================================================
+  // Producers (any thread). Only short channel messages are queued; system
+  // exclusive and meta events are ignored; a message without a timestamp
+  // is stamped now. Returns false if the message was dropped.
+  // ========================================================================
+  bool post(const juce::MidiMessage &message,
+            LatencyPath path = LatencyPath::Remote) {
+    const double stamp = message.getTimeStamp();
+    return post(message.getRawData(), message.getRawDataSize(),
+                stamp > 0.0 ? stamp : getCurrentTime(), path);
+  }
+
+  bool post(const uint8_t *data, int numBytes, double timeInSeconds,
+            LatencyPath path = LatencyPath::Remote) {
+    if (numBytes < 1 || numBytes > 3 || data[0] < 0x80 || data[0] == 0xf0)
+      return false;
+
+    uint64_t index = writeIndex.load(std::memory_order_relaxed);
+    for (;;) {
+      const auto &candidate = slots[static_cast<size_t>(index & MASK)];
+      const auto lap = static_cast<int64_t>(
+          candidate.sequence.load(std::memory_order_acquire) - index);
+      if (lap == 0) {
+        if (writeIndex.compare_exchange_weak(index, index + 1,
+                                             std::memory_order_relaxed))
+          break;
+      } else if (lap < 0) {
+        // Still holds the message from one lap ago: the queue is full
+        numDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      } else {
+        index = writeIndex.load(std::memory_order_relaxed);
+      }
+    }
+
+    auto &slot = slots[static_cast<size_t>(index & MASK)];
+    slot.timeInSeconds = timeInSeconds;
+    slot.numBytes = static_cast<uint8_t>(numBytes);
+    slot.path = path;
+    for (int b = 0; b < 3; ++b)
+      slot.bytes[b] = b < numBytes ? data[b] : 0;
+    slot.sequence.store(index + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Device input (MIDI thread), stamped by the driver
+  void handleIncomingMidiMessage(juce::MidiInput *,
+                                 const juce::MidiMessage &message) override {
+    post(message, LatencyPath::Device);
+  }
+
+  int getNumDropped() const {
+    return numDropped.load(std::memory_order_relaxed);
+  }
+
+  // ========================================================================
+  // Consumer (audio thread, or while no block is being rendered)
+  // ========================================================================
+  // Discards anything queued so far
+  void prepare(double newSampleRate) {
+    sampleRate = newSampleRate;
+    drain([](const Slot &) {});
+  }
+
+  // Adds everything published so far to the buffer. The block is taken to
+  // cover the numSamples leading up to now; late messages land on its
+  // first sample, early ones on its last. Note-ons are reported to the
+  // probe, if there is one.
+  void removeNextBlockOfMessages(juce::MidiBuffer &midi, int numSamples,
+                                 NoteLatencyProbe *probe = nullptr) {
+    if (numSamples <= 0)
+      return;
+
+    const double now = getCurrentTime();
+    const double blockStart =
+        now - static_cast<double>(numSamples) / sampleRate;
+
+    drain([&](const Slot &slot) {
+      const auto offset = static_cast<int>(
+          (slot.timeInSeconds - blockStart) * sampleRate);
+      midi.addEvent(slot.bytes, slot.numBytes,
+                    juce::jlimit(0, numSamples - 1, offset));
+
+      if (probe != nullptr && slot.numBytes == 3 &&
+          (slot.bytes[0] & 0xf0) == 0x90 && slot.bytes[2] != 0)
+        probe->noteReceived((slot.bytes[0] & 0x0f) + 1, slot.bytes[1],
+                            slot.path, slot.timeInSeconds, now);
+    });
+  }
+
+private:
+  static constexpr uint64_t MASK = CAPACITY - 1;
+  static_assert((CAPACITY & MASK) == 0, "CAPACITY must be a power of two");
+
+  struct Slot {
+    // The position a producer may claim this slot for, or that position
+    // + 1 once its message is published
+    std::atomic<uint64_t> sequence{0};
+    double timeInSeconds = 0.0;
+    uint8_t bytes[3] = {};
+    uint8_t numBytes = 0;
+    LatencyPath path = LatencyPath::Remote;
+  };
+
+  // Stops at the first slot that is claimed but not yet published; it is
+  // picked up by the next block
+  template <typename Callback> void drain(Callback &&callback) {
+    for (;;) {
+      auto &slot = slots[static_cast<size_t>(readIndex & MASK)];
+      if (slot.sequence.load(std::memory_order_acquire) != readIndex + 1)
+        break;
+
+      callback(slot);
+      slot.sequence.store(readIndex + CAPACITY, std::memory_order_release);
+      ++readIndex;
+    }
+  }
+
+  std::array<Slot, CAPACITY> slots;
+  alignas(64) std::atomic<uint64_t> writeIndex{0};
+  std::atomic<int> numDropped{0};
+
+  // Consumer only
+  alignas(64) uint64_t readIndex = 0;
+  double sampleRate = 44100.0;
+};
+
+} // namespace Sphere
@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+    SphereReleasePool.h
+    Deferred deletion of objects shared with the audio thread
+
+    Anything the audio thread might still be holding is added to the pool
+    when it is published. The pool keeps one reference to it, so the audio
+    thread can drop its own references without ever deleting, and a
+    low-priority background thread frees each object once the pool's
+    reference is the only one left.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+namespace Sphere {
+
+// ============================================================================
+// Release Pool
+// ============================================================================
+class ReleasePool final : private juce::Thread {
+public:
+  ReleasePool() : juce::Thread("Sphere Release Pool") {
+    startThread(juce::Thread::Priority::background);
+  }
+
+  ~ReleasePool() override { stopThread(2000); }
+
+  // Message thread (or any non-audio thread)
+  void add(juce::ReferenceCountedObject *object) {
+    if (object == nullptr)
+      return;
+
+    const juce::ScopedLock sl(poolLock);
+    for (auto &existing : pool) {
+      if (existing.get() == object)
+        return;
+    }
+    pool.emplace_back(object);
+  }
+
+private:
+  void run() override {
+    while (!threadShouldExit()) {
+      wait(COLLECT_INTERVAL_MS);
+      collect();
+    }
+  }
+
+  // Objects are released outside the lock so add() never waits on a
+  // destructor
+  void collect() {
+    std::vector<juce::ReferenceCountedObjectPtr<juce::ReferenceCountedObject>>
+        unused;
+    {
+      const juce::ScopedLock sl(poolLock);
+      for (auto it = pool.begin(); it != pool.end();) {
+        if ((*it)->getReferenceCount() == 1) {
+          unused.push_back(std::move(*it));
+          it = pool.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+  }
+
+  static constexpr int COLLECT_INTERVAL_MS = 500;
+
+  juce::CriticalSection poolLock;
+  std::vector<juce::ReferenceCountedObjectPtr<juce::ReferenceCountedObject>>
+      pool;
+};
+
+} // namespace Sphere
@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+    SphereSPSCQueue.h
+    Bounded single-producer, single-consumer queue of fixed-size commands
+
+    The producer (typically the message thread) copies a command into the
+    next free slot and publishes it with a release store of the write
+    index; the consumer (the audio thread) copies it out and frees the
+    slot the same way. Neither side ever waits or allocates. A full queue
+    rejects the command and counts it - commands are expected to carry
+    complete state, so the next one for the same target resynchronizes.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+namespace Sphere {
+
+template <typename Command, int Capacity> class SPSCQueue {
+public:
+  static_assert(std::is_trivially_copyable<Command>::value,
+                "Commands are copied in and out of the queue");
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                "Capacity must be a power of two");
+
+  // Producer thread only; false if the queue is full
+  bool push(const Command &command) {
+    const uint32_t write = writeIndex.load(std::memory_order_relaxed);
+    if (write - readIndex.load(std::memory_order_acquire) == Capacity) {
+      numDropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    slots[write & MASK] = command;
+    writeIndex.store(write + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer thread only; false if there is nothing to take
+  bool pop(Command &command) {
+    const uint32_t read = readIndex.load(std::memory_order_relaxed);
+    if (read == writeIndex.load(std::memory_order_acquire))
+      return false;
+
+    command = slots[read & MASK];
+    readIndex.store(read + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Any thread
+  int getNumDropped() const {
+    return numDropped.load(std::memory_order_relaxed);
+  }
+
+private:
+  static constexpr uint32_t MASK = Capacity - 1;
+
+  std::array<Command, Capacity> slots{};
+  alignas(64) std::atomic<uint32_t> writeIndex{0};
+  alignas(64) std::atomic<uint32_t> readIndex{0};
+  std::atomic<int> numDropped{0};
+};
+
+} // namespace Sphere
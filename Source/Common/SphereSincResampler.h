@@ -0,0 +1,201 @@
+/*
+  ==============================================================================
+    SphereSincResampler.h
+    Kaiser-windowed sinc interpolation from precomputed polyphase tables
+
+    Shared by the sampler voices (pitch shifting) and the sample cache
+    (converting assets to the engine rate). Each quality tier has a fixed
+    number of taps; the kernel for a fractional position is interpolated
+    between the two nearest of PHASES precomputed phases.
+
+    Reading faster than the source rate needs a lower cutoff to avoid
+    aliasing, so every tier also has tables for half-octave steps of
+    decimation, picked once per note from the playback ratio. The tap loop
+    keeps LANES independent partial sums so it vectorizes without relaxed
+    floating point.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <cmath>
+#include <vector>
+
+namespace Sphere {
+
+// Taps per output sample: 8 (full polyphony), 16, 32 (offline conversion)
+enum class SincQuality { Low, Medium, High };
+
+// ============================================================================
+// Sinc Resampler
+// ============================================================================
+class SincResampler {
+public:
+  static constexpr int MAX_TAPS = 32;
+  static constexpr int PHASES = 256;
+  static constexpr int NUM_BANDS = 7; // up to three octaves of decimation
+  static constexpr int LANES = 8;
+
+  // Frames an interpolator reads before / after the integer position
+  static constexpr int getFramesBefore(int taps) { return taps / 2 - 1; }
+  static constexpr int getFramesAfter(int taps) { return taps / 2; }
+
+  static int getNumTaps(SincQuality quality) {
+    return quality == SincQuality::High     ? 32
+           : quality == SincQuality::Medium ? 16
+                                            : 8;
+  }
+
+  // --------------------------------------------------------------------------
+  // One tier at one cutoff
+  // --------------------------------------------------------------------------
+  class Kernel {
+  public:
+    int getNumTaps() const { return taps; }
+
+    // Value at x[0] + frac, frac in [0, 1). Reads x[-getFramesBefore()]
+    // to x[getFramesAfter()].
+    float interpolate(const float *x, float frac) const {
+      const float scaled = frac * static_cast<float>(PHASES);
+      const int phase = static_cast<int>(scaled);
+      const float blend = scaled - static_cast<float>(phase);
+
+      const float *c = coefficients.data() + phase * taps;
+      const float *d = deltas.data() + phase * taps;
+      const float *in = x - getFramesBefore(taps);
+
+      std::array<float, LANES> acc{};
+      for (int t = 0; t < taps; t += LANES)
+        for (int l = 0; l < LANES; ++l)
+          acc[l] += in[t + l] * (c[t + l] + blend * d[t + l]);
+
+      float sum = 0.0f;
+      for (int l = 0; l < LANES; ++l)
+        sum += acc[l];
+      return sum;
+    }
+
+  private:
+    friend class SincResampler;
+
+    void build(int numTaps, double cutoff, double beta) {
+      taps = numTaps;
+      const int half = taps / 2;
+
+      // PHASES + 1 rows so the last phase has a neighbour to blend with
+      coefficients.assign(static_cast<size_t>(PHASES + 1) * taps, 0.0f);
+      deltas.assign(coefficients.size(), 0.0f);
+
+      for (int p = 0; p <= PHASES; ++p) {
+        const double frac = static_cast<double>(p) / PHASES;
+        double sum = 0.0;
+        std::array<double, MAX_TAPS> row{};
+
+        for (int t = 0; t < taps; ++t) {
+          const double distance = (t - (half - 1)) - frac;
+          const double w = distance / half;
+          const double window =
+              std::abs(w) >= 1.0
+                  ? 0.0
+                  : besselI0(beta * std::sqrt(1.0 - w * w)) / besselI0(beta);
+          row[t] = cutoff * sinc(cutoff * distance) * window;
+          sum += row[t];
+        }
+
+        // Unity gain at DC for every phase
+        for (int t = 0; t < taps; ++t)
+          coefficients[p * taps + t] = static_cast<float>(row[t] / sum);
+      }
+
+      for (int p = 0; p < PHASES; ++p)
+        for (int t = 0; t < taps; ++t)
+          deltas[p * taps + t] = coefficients[(p + 1) * taps + t] -
+                                 coefficients[p * taps + t];
+    }
+
+    int taps = 8;
+    std::vector<float> coefficients;
+    std::vector<float> deltas;
+  };
+
+  // Tables are built on first use; call once from a non-realtime thread
+  static const SincResampler &getInstance() {
+    static const SincResampler instance;
+    return instance;
+  }
+
+  // ratio = source frames advanced per output frame
+  const Kernel &getKernel(SincQuality quality, double ratio) const {
+    // Smallest half-octave step whose cutoff is at or below 1 / ratio; the
+    // base band already sits below Nyquist, so small ratios keep it
+    const int q = static_cast<int>(quality);
+    const double excess = BASE_CUTOFF[q] * ratio;
+    const int band =
+        excess <= 1.0 ? 0
+                      : juce::jmin(NUM_BANDS - 1,
+                                   static_cast<int>(std::ceil(
+                                       2.0 * std::log2(excess) - 1.0e-9)));
+    return kernels[q][band];
+  }
+
+  // Offline conversion: output[i] is the input at startPosition + i * ratio.
+  // The input must be readable (e.g. zero padded) getFramesBefore() frames
+  // before the first and getFramesAfter() frames after the last position.
+  void process(const float *input, double startPosition, double ratio,
+               float *output, int numOutput, SincQuality quality) const {
+    const Kernel &kernel = getKernel(quality, ratio);
+
+    for (int i = 0; i < numOutput; ++i) {
+      const double position = startPosition + i * ratio;
+      const auto index = static_cast<int>(position);
+      output[i] = kernel.interpolate(input + index,
+                                     static_cast<float>(position - index));
+    }
+  }
+
+private:
+  // Wider kernels afford a cutoff closer to Nyquist and a steeper window
+  static constexpr double BASE_CUTOFF[] = {0.84, 0.91, 0.95};
+
+  SincResampler() {
+    static constexpr double beta[] = {5.0, 7.0, 9.0};
+
+    for (int q = 0; q < 3; ++q) {
+      const int taps = getNumTaps(static_cast<SincQuality>(q));
+      for (int band = 0; band < NUM_BANDS; ++band)
+        kernels[q][band].build(taps,
+                               BASE_CUTOFF[q] * std::pow(2.0, -0.5 * band),
+                               beta[q]);
+
+      // A slight pitch-up still fits under the full-bandwidth cutoff
+      jassert(&getKernel(static_cast<SincQuality>(q), 1.01) ==
+              &kernels[q][0]);
+    }
+  }
+
+  static double sinc(double x) {
+    if (std::abs(x) < 1.0e-9)
+      return 1.0;
+    const double px = juce::MathConstants<double>::pi * x;
+    return std::sin(px) / px;
+  }
+
+  // Zeroth order modified Bessel function of the first kind
+  static double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; ++k) {
+      term *= (x * 0.5 / k) * (x * 0.5 / k);
+      sum += term;
+      if (term < sum * 1.0e-12)
+        break;
+    }
+    return sum;
+  }
+
+  std::array<std::array<Kernel, NUM_BANDS>, 3> kernels;
+};
+
+} // namespace Sphere
@@ -0,0 +1,189 @@
+/*
+  ==============================================================================
+    SphereWorkerPool.h
+    Fixed set of realtime worker threads that help the audio thread
+
+    The audio thread hands out a batch of independent tasks, takes part in
+    running them itself and returns once all of them are done. Tasks are
+    claimed with an atomic counter, so which thread runs which task varies
+    from block to block - callers must write each task's output to its own
+    buffer and combine the results in a fixed order afterwards.
+
+    No locks or allocations on the audio thread: idle workers spin for a
+    short while and then park on an event, which is only signalled when a
+    worker has actually gone to sleep.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <memory>
+
+#if JUCE_INTEL
+#include <immintrin.h>
+#elif JUCE_ARM && JUCE_MSVC
+#include <intrin.h>
+#endif
+
+namespace Sphere {
+
+// ============================================================================
+// Realtime Worker Pool
+// ============================================================================
+class RealtimeWorkerPool {
+public:
+  // workerIndex is 0 for the calling (audio) thread, 1..numWorkers otherwise
+  using TaskFunction = void (*)(void *context, int taskIndex, int workerIndex);
+
+  static constexpr int MAX_WORKERS = 15;
+
+  ~RealtimeWorkerPool() { stop(); }
+
+  // ========================================================================
+  // Lifecycle (message thread, never while run() is in progress)
+  // ========================================================================
+  void start(int numWorkersToUse, double sampleRate, int blockSize) {
+    stop();
+
+    numWorkers = juce::jlimit(0, MAX_WORKERS, numWorkersToUse);
+    for (int i = 0; i < numWorkers; ++i) {
+      workers[i] = std::make_unique<Worker>(*this, i + 1);
+      workers[i]->startRealtimeThread(
+          juce::Thread::RealtimeOptions{}.withApproximateAudioProcessingTime(
+              juce::jmax(1, blockSize), sampleRate));
+    }
+  }
+
+  void stop() {
+    for (int i = 0; i < numWorkers; ++i)
+      workers[i]->signalThreadShouldExit();
+
+    for (int i = 0; i < numWorkers; ++i) {
+      workers[i]->wakeEvent.signal();
+      workers[i]->stopThread(1000);
+      workers[i].reset();
+    }
+
+    numWorkers = 0;
+  }
+
+  int getNumWorkers() const { return numWorkers; }
+
+  // Number of distinct workerIndex values a task can see
+  static constexpr int getMaxThreads() { return MAX_WORKERS + 1; }
+
+  // ========================================================================
+  // Run tasks 0..numTasks-1 and wait for all of them (audio thread)
+  // ========================================================================
+  void run(int numTasks, TaskFunction function, void *context) {
+    if (numWorkers == 0 || numTasks <= 1) {
+      for (int t = 0; t < numTasks; ++t)
+        function(context, t, 0);
+      return;
+    }
+
+    taskFunction = function;
+    taskContext = context;
+    tasksRemaining.store(numTasks, std::memory_order_relaxed);
+
+    // Publishes the task fields above to any worker that claims a task
+    taskState.store(static_cast<uint64_t>(numTasks) << 32,
+                    std::memory_order_release);
+    generation.fetch_add(1, std::memory_order_seq_cst);
+
+    for (int i = 0; i < numWorkers; ++i) {
+      if (workers[i]->sleeping.load(std::memory_order_seq_cst))
+        workers[i]->wakeEvent.signal();
+    }
+
+    runTasks(0);
+
+    while (tasksRemaining.load(std::memory_order_acquire) > 0)
+      pauseHint();
+  }
+
+private:
+  // Tells the core it is spinning, which saves power and leaves issue slots
+  // to a hyperthread sibling that may be running one of the tasks
+  static void pauseHint() {
+#if JUCE_INTEL
+    _mm_pause();
+#elif JUCE_ARM && JUCE_MSVC
+    __yield();
+#elif JUCE_ARM
+    asm volatile("yield");
+#endif
+  }
+
+  struct Worker final : public juce::Thread {
+    Worker(RealtimeWorkerPool &ownerPool, int index)
+        : juce::Thread("Sphere Render Worker " + juce::String(index)),
+          pool(ownerPool), workerIndex(index) {}
+
+    void run() override {
+      uint32_t seenGeneration = pool.generation.load();
+
+      while (!threadShouldExit()) {
+        // Spin briefly: the next block usually arrives within microseconds
+        for (int spin = 0; spin < SPIN_COUNT; ++spin) {
+          if (pool.generation.load(std::memory_order_acquire) !=
+              seenGeneration)
+            break;
+          pauseHint();
+        }
+
+        if (pool.generation.load(std::memory_order_seq_cst) ==
+            seenGeneration) {
+          sleeping.store(true, std::memory_order_seq_cst);
+          if (pool.generation.load(std::memory_order_seq_cst) ==
+              seenGeneration)
+            wakeEvent.wait(100);
+          sleeping.store(false, std::memory_order_relaxed);
+          continue;
+        }
+
+        seenGeneration = pool.generation.load(std::memory_order_acquire);
+        pool.runTasks(workerIndex);
+      }
+    }
+
+    static constexpr int SPIN_COUNT = 4096;
+
+    RealtimeWorkerPool &pool;
+    const int workerIndex;
+    std::atomic<bool> sleeping{false};
+    juce::WaitableEvent wakeEvent;
+  };
+
+  // taskState packs the batch's task count (high word) with the next task
+  // index (low word), so a claim always sees the count of the batch it
+  // claimed from. A worker that is late for one batch can therefore only
+  // take tasks of the current batch, and the acquire makes that batch's
+  // function/context visible.
+  void runTasks(int workerIndex) {
+    for (;;) {
+      const uint64_t state =
+          taskState.fetch_add(1, std::memory_order_acq_rel);
+      const int task = static_cast<int>(state & 0xffffffffu);
+      if (task >= static_cast<int>(state >> 32))
+        return;
+
+      taskFunction(taskContext, task, workerIndex);
+      tasksRemaining.fetch_sub(1, std::memory_order_release);
+    }
+  }
+
+  std::array<std::unique_ptr<Worker>, MAX_WORKERS> workers;
+  int numWorkers = 0;
+
+  std::atomic<uint32_t> generation{0};
+  std::atomic<uint64_t> taskState{0};
+  std::atomic<int> tasksRemaining{0};
+  TaskFunction taskFunction = nullptr;
+  void *taskContext = nullptr;
+};
+
+} // namespace Sphere
@@ -1,6 +1,7 @@
 #pragma once
 #include "SphereEQBiquad.h"
 #include "SphereEQDynamic.h"
+#include "SphereEQSVF.h"
 
 namespace Sphere {
 
@@ -51,6 +52,9 @@ public:
     // Prepare dynamic processor
     dynamicProcessor.prepare(sampleRate, maxBlockSize);
 
+    svf.prepare(sampleRate);
+    fadingSvf.prepare(sampleRate);
+
     // Prepare work buffers
     workBufferL.resize(maxBlockSize);
     workBufferR.resize(maxBlockSize);
@@ -59,34 +63,67 @@ public:
     gainSmoother.reset(sampleRate, 0.02);
 
     reset();
-    updateFilters();
+    setParameters(params, 0);
   }
 
   void reset() {
-    filterL.reset();
-    filterR.reset();
+    filter.reset();
+    svf.reset();
+    fadeRemaining = 0;
     dynamicProcessor.reset();
     gainSmoother.setCurrentAndTargetValue(1.0f);
   }
 
-  void setParametersFromSnapshot(const EQBandParams &newParams) {
+  // Audio thread (or before playback). An edit that keeps the filter's
+  // shape ramps its coefficients over rampSamples (an SVF band glides its
+  // frequency, gain and Q instead); a new type, slope, topology or bypass
+  // state crossfades from the old filter. Zero samples switches at once.
+  void setParameters(const EQBandParams &newParams, int rampSamples) {
+    const EQBandParams previous = params;
     params = newParams;
-    updateFilters();
     dynamicProcessor.setParameters(params);
 
-    DBG(juce::String("Band updated: type=") +
-        juce::String(static_cast<int>(params.type)) +
-        " freq=" + juce::String(params.frequency) +
-        " gain=" + juce::String(params.gainDb) +
-        " dynamic=" + juce::String(static_cast<int>(params.dynamicMode)) +
-        " bypass=" + juce::String(params.bypass ? 1 : 0) +
-        " numStages=" + juce::String(filterL.getNumStages()));
-  }
+    std::array<BiquadCoeffs, MAX_BIQUADS_PER_BAND> design;
+    const int numStages =
+        params.bypass ? 0 : designFilter(params, sampleRate, design);
+    const bool sameShape =
+        previous.topology == params.topology &&
+        (usesSvf() ? SVFBandFilter::hasSameLayout(previous, params)
+                   : numStages == filter.getNumStages() &&
+                         previous.type == params.type &&
+                         previous.bypass == params.bypass);
+
+    if (sameShape) {
+      // The biquads only follow along while the SVF runs
+      filter.rampTo(design, usesSvf() ? 0 : rampSamples);
+      svf.setParameters(params, rampSamples);
+      return;
+    }
+
+    if (rampSamples > 0 && maxBlockSize > 0) {
+      fadingFromSvf = previous.topology == EQBandTopology::SVF;
+      if (fadingFromSvf)
+        fadingSvf = svf;
+      else
+        fadingFilter = filter;
+      fadeLength = rampSamples;
+      fadeRemaining = rampSamples;
+    } else {
+      fadeRemaining = 0;
+    }
 
-  void updateIfNeeded() {
-    // Currently all updates happen immediately in setParametersFromSnapshot
+    filter.setNumStages(numStages);
+    filter.rampTo(design, 0);
+    svf.setParameters(params, 0);
+    svf.reset();
   }
 
+  // True while a coefficient ramp or crossfade is running
+  bool isSmoothing() const { return filter.isRamping() || fadeRemaining > 0; }
+
+  // State hand-over with the fused cascade
+  BiquadLaneCascade<double, 2> &getFilter() { return filter; }
+
   const EQBandParams &getParameters() const { return params; }
   bool isBypassed() const { return params.bypass; }
   EQStereoMode getStereoMode() const { return params.stereoMode; }
@@ -98,11 +135,9 @@ public:
 
   // Optimized stereo processing
   void processBlock(float *leftChannel, float *rightChannel, int numSamples) {
-    if (params.bypass || numSamples == 0)
+    if (isSilent() || numSamples == 0)
       return;
 
-    juce::ScopedNoDenormals noDenormals;
-
     switch (params.stereoMode) {
     case EQStereoMode::Stereo:
       processStandardStereo(leftChannel, rightChannel, numSamples);
@@ -121,11 +156,13 @@ public:
   }
 
   void processMidBuffer(float *mid, int numSamples) {
-    if (params.bypass || numSamples == 0)
+    if (isSilent() || numSamples == 0)
       return;
 
     // Apply static EQ filter
-    filterL.processBlock(mid, numSamples);
+    filterLane(0, mid, numSamples);
+    if (params.bypass)
+      return;
 
     // Apply dynamic processing if enabled
     if (params.dynamicMode != EQDynamicMode::Off) {
@@ -138,10 +175,12 @@ public:
   }
 
   void processSideBuffer(float *side, int numSamples) {
-    if (params.bypass || numSamples == 0)
+    if (isSilent() || numSamples == 0)
       return;
 
-    filterR.processBlock(side, numSamples);
+    filterLane(1, side, numSamples);
+    if (params.bypass)
+      return;
 
     if (params.dynamicMode != EQDynamicMode::Off) {
       dynamicProcessor.processMono(side, numSamples);
@@ -152,17 +191,30 @@ public:
     }
   }
 
-  double getMagnitudeResponse(double frequency) const {
+  // Response of a band's static filter, from its parameters alone (any
+  // thread); SVF bands at their unswept frequency
+  static double getMagnitudeResponse(const EQBandParams &params,
+                                     double frequency, double sampleRate) {
     if (params.bypass)
       return 1.0;
-    return filterL.getMagnitudeResponse(frequency, sampleRate);
+    if (params.topology == EQBandTopology::SVF)
+      return SVFBandFilter::getMagnitudeResponse(params, frequency,
+                                                 sampleRate);
+
+    std::array<BiquadCoeffs, MAX_BIQUADS_PER_BAND> design;
+    const int numStages = designFilter(params, sampleRate, design);
+    double magnitude = 1.0;
+    for (int i = 0; i < numStages; ++i)
+      magnitude *= Biquad::getMagnitudeResponse(design[i], frequency,
+                                                sampleRate);
+    return magnitude;
   }
 
-private:
-  void updateFilters() {
-    if (sampleRate <= 0.0)
-      return;
-
+  // Static filter of a band as a cascade of sections; returns the number of
+  // sections. The fused cascade compiles bands with the same design.
+  static int designFilter(
+      const EQBandParams &params, double sampleRate,
+      std::array<BiquadCoeffs, MAX_BIQUADS_PER_BAND> &design) {
     int order = 2;
 
     if (params.type == EQFilterType::LowCut ||
@@ -193,30 +245,101 @@ private:
         order = 16;
         break;
       }
-      filterL.configureButterworth(params.type, sampleRate, params.frequency,
-                                   order);
-      filterR.configureButterworth(params.type, sampleRate, params.frequency,
-                                   order);
-    } else {
-      filterL.setNumStages(1);
-      filterR.setNumStages(1);
-
-      // For dynamic EQ, the static gain is applied through the filter
-      // Dynamic gain modulation happens in the dynamic processor
-      double staticGain =
-          (params.dynamicMode == EQDynamicMode::Off) ? params.gainDb : 0.0;
-
-      BiquadCoeffs coeffs = RBJCookbook::calculate(
-          params.type, sampleRate, params.frequency, params.q, staticGain);
-      filterL.setStageCoefficients(0, coeffs);
-      filterR.setStageCoefficients(0, coeffs);
+      return CascadedBiquad::designButterworth(params.type, sampleRate,
+                                               params.frequency, order, design);
+    }
+
+    // For dynamic EQ, the static gain is applied through the filter
+    // Dynamic gain modulation happens in the dynamic processor
+    double staticGain =
+        (params.dynamicMode == EQDynamicMode::Off) ? params.gainDb : 0.0;
+
+    design[0] = RBJCookbook::calculate(params.type, sampleRate,
+                                       params.frequency, params.q, staticGain);
+    return 1;
+  }
+
+private:
+  // Bypassed, with nothing left to fade out
+  bool isSilent() const { return params.bypass && fadeRemaining == 0; }
+
+  bool usesSvf() const { return params.topology == EQBandTopology::SVF; }
+
+  // ========================================================================
+  // Static filter, crossfading from the replaced one while a fade runs
+  // ========================================================================
+  void filterStereo(float *left, float *right, int numSamples) {
+    const int numFading = beginFade(numSamples);
+    if (numFading > 0) {
+      std::copy(left, left + numFading, workBufferL.begin());
+      std::copy(right, right + numFading, workBufferR.begin());
+      float *const work[2] = {workBufferL.data(), workBufferR.data()};
+      if (fadingFromSvf)
+        fadingSvf.processBlock(work, numFading);
+      else
+        fadingFilter.processBlock(work, numFading);
+    }
+
+    // Both channels in one pass
+    float *const channels[2] = {left, right};
+    if (usesSvf())
+      svf.processBlock(channels, numSamples);
+    else
+      filter.processBlock(channels, numSamples);
+
+    if (numFading > 0) {
+      mixFade(left, workBufferL.data(), numFading);
+      if (right != left)
+        mixFade(right, workBufferR.data(), numFading);
+      fadeRemaining -= numFading;
+    }
+  }
+
+  void filterLane(int lane, float *samples, int numSamples) {
+    const int numFading = beginFade(numSamples);
+    if (numFading > 0) {
+      std::copy(samples, samples + numFading, workBufferL.begin());
+      if (fadingFromSvf)
+        fadingSvf.processLane(lane, workBufferL.data(), numFading);
+      else
+        fadingFilter.processLane(lane, workBufferL.data(), numFading);
+    }
+
+    if (usesSvf())
+      svf.processLane(lane, samples, numSamples);
+    else
+      filter.processLane(lane, samples, numSamples);
+
+    if (numFading > 0) {
+      mixFade(samples, workBufferL.data(), numFading);
+      fadeRemaining -= numFading;
+    }
+  }
+
+  // Samples of this block still in the fade; a block longer than the work
+  // buffers ends it
+  int beginFade(int numSamples) {
+    if (fadeRemaining > 0 &&
+        numSamples > static_cast<int>(workBufferL.size()))
+      fadeRemaining = 0;
+    return juce::jmin(numSamples, fadeRemaining);
+  }
+
+  // New filter's output in samples, the old one's in faded
+  void mixFade(float *samples, const float *faded, int numFading) const {
+    const float step = 1.0f / static_cast<float>(fadeLength);
+    float position = static_cast<float>(fadeLength - fadeRemaining + 1) * step;
+    for (int i = 0; i < numFading; ++i) {
+      samples[i] = faded[i] + (samples[i] - faded[i]) * position;
+      position += step;
     }
   }
 
   void processStandardStereo(float *left, float *right, int numSamples) {
     // Step 1: Apply static EQ filtering
-    filterL.processBlock(left, numSamples);
-    filterR.processBlock(right, numSamples);
+    filterStereo(left, right, numSamples);
+    if (params.bypass)
+      return;
 
     // Step 2: Apply dynamic processing if enabled
     if (params.dynamicMode != EQDynamicMode::Off) {
@@ -231,7 +354,9 @@ private:
   }
 
   void processLeftOnly(float *left, int numSamples) {
-    filterL.processBlock(left, numSamples);
+    filterLane(0, left, numSamples);
+    if (params.bypass)
+      return;
 
     if (params.dynamicMode != EQDynamicMode::Off) {
       dynamicProcessor.processMono(left, numSamples);
@@ -243,7 +368,9 @@ private:
   }
 
   void processRightOnly(float *right, int numSamples) {
-    filterR.processBlock(right, numSamples);
+    filterLane(1, right, numSamples);
+    if (params.bypass)
+      return;
 
     if (params.dynamicMode != EQDynamicMode::Off) {
       dynamicProcessor.processMono(right, numSamples);
@@ -283,9 +410,19 @@ private:
   double sampleRate = 44100.0;
   int maxBlockSize = 0;
 
-  // Static EQ filters
-  CascadedBiquad filterL;
-  CascadedBiquad filterR;
+  // Static EQ filter; lane 0 is left (or mid), lane 1 right (or side).
+  // Denormal mode is set once per block by the engine.
+  BiquadLaneCascade<double, 2> filter;
+
+  // Modulatable version of the same filter, run instead of it by SVF bands
+  SVFBandFilter svf;
+
+  // The filter being faded out after a change of shape
+  BiquadLaneCascade<double, 2> fadingFilter;
+  SVFBandFilter fadingSvf;
+  bool fadingFromSvf = false;
+  int fadeLength = 1;
+  int fadeRemaining = 0;
 
   // Dynamic EQ processor
   DynamicEQProcessor dynamicProcessor;
@@ -293,7 +430,7 @@ private:
   // Gain smoother
   juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> gainSmoother;
 
-  // Work buffers
+  // Work buffers (the fading filter's output)
   std::vector<float> workBufferL;
   std::vector<float> workBufferR;
 };
@@ -41,11 +41,10 @@ public:
     
     // ========================================================================
     // Process single sample (Direct Form II Transposed)
+    // Denormals are handled per block, not here: run under
+    // juce::ScopedNoDenormals and call flushDenormals() after the block.
     // ========================================================================
     inline double processSample(double input) {
-        // JUCE denormal handling
-        juce::ScopedNoDenormals noDenormals;
-        
         // Direct Form II Transposed:
         // y[n] = b0*x[n] + z1[n-1]
         // z1[n] = b1*x[n] - a1*y[n] + z2[n-1]
@@ -55,11 +54,14 @@ public:
         z1 = coeffs.b1 * input - coeffs.a1 * output + z2;
         z2 = coeffs.b2 * input - coeffs.a2 * output;
         
-        // Flush denormals
+        return output;
+    }
+    
+    // Keeps a decaying tail from sitting in the denormal range between
+    // blocks
+    void flushDenormals() {
         z1 = flushDenormal(z1);
         z2 = flushDenormal(z2);
-        
-        return output;
     }
     
     // ========================================================================
@@ -71,6 +73,7 @@ public:
         for (int i = 0; i < numSamples; ++i) {
             samples[i] = processSample(samples[i]);
         }
+        flushDenormals();
     }
     
     void processBlock(float* samples, int numSamples) {
@@ -79,6 +82,7 @@ public:
         for (int i = 0; i < numSamples; ++i) {
             samples[i] = static_cast<float>(processSample(static_cast<double>(samples[i])));
         }
+        flushDenormals();
     }
     
     // ========================================================================
@@ -95,6 +99,11 @@ public:
     // Get magnitude response at frequency
     // ========================================================================
     double getMagnitudeResponse(double frequency, double sampleRate) const {
+        return getMagnitudeResponse(coeffs, frequency, sampleRate);
+    }
+    
+    static double getMagnitudeResponse(const BiquadCoeffs& coeffs,
+                                       double frequency, double sampleRate) {
         const double omega = 2.0 * juce::MathConstants<double>::pi * frequency / sampleRate;
         const double cosW = std::cos(omega);
         const double cos2W = std::cos(2.0 * omega);
@@ -120,6 +129,11 @@ public:
     // Get phase response at frequency
     // ========================================================================
     double getPhaseResponse(double frequency, double sampleRate) const {
+        return getPhaseResponse(coeffs, frequency, sampleRate);
+    }
+    
+    static double getPhaseResponse(const BiquadCoeffs& coeffs,
+                                   double frequency, double sampleRate) {
         const double omega = 2.0 * juce::MathConstants<double>::pi * frequency / sampleRate;
         const double cosW = std::cos(omega);
         const double cos2W = std::cos(2.0 * omega);
@@ -171,10 +185,23 @@ public:
     // ========================================================================
     void configureButterworth(EQFilterType type, double sampleRate, 
                                double frequency, int order) {
+        std::array<BiquadCoeffs, MAX_BIQUADS_PER_BAND> design;
+        const int numBiquads = designButterworth(type, sampleRate, frequency,
+                                                 order, design);
+        setNumStages(numBiquads);
+        
+        for (int i = 0; i < numStages; ++i) {
+            stages[i].setCoefficients(design[i]);
+        }
+    }
+    
+    // Fills one set of coefficients per stage; returns the number of stages
+    static int designButterworth(EQFilterType type, double sampleRate,
+                                 double frequency, int order,
+                                 std::array<BiquadCoeffs, MAX_BIQUADS_PER_BAND>& design) {
         // Order determines number of biquad stages
         // Each biquad is 2nd order, so order/2 biquads for even orders
-        const int numBiquads = (order + 1) / 2;
-        setNumStages(numBiquads);
+        const int numBiquads = juce::jlimit(0, MAX_BIQUADS_PER_BAND, (order + 1) / 2);
         
         for (int i = 0; i < numBiquads; ++i) {
             // Calculate Q for this stage in the Butterworth cascade
@@ -198,8 +225,10 @@ public:
                 coeffs = RBJCookbook::calculate(type, sampleRate, frequency, q, 0.0);
             }
             
-            stages[i].setCoefficients(coeffs);
+            coeffs.normalize();
+            design[i] = coeffs;
         }
+        return numBiquads;
     }
     
     // ========================================================================
@@ -222,6 +251,13 @@ public:
         return output;
     }
     
+    // Once per block when driving processSample() directly
+    void flushDenormals() {
+        for (int i = 0; i < numStages; ++i) {
+            stages[i].flushDenormals();
+        }
+    }
+    
     // ========================================================================
     // Process audio block through cascade
     // ========================================================================
@@ -270,5 +306,344 @@ private:
     int numStages = 0;
 };
 
+// ============================================================================
+// Multi-lane Biquad
+// NumLanes independent Direct Form II Transposed sections (stereo L/R,
+// M/S, or unrelated filters) stored lane by lane, so one sample of every
+// lane is computed by the same branch-free loop the compiler turns into
+// vector instructions. Like Biquad, it leaves denormal handling to the
+// block: run under juce::ScopedNoDenormals and flush once per block.
+// ============================================================================
+template <typename SampleType, int NumLanes>
+class BiquadLanes {
+public:
+    static_assert(NumLanes > 0, "BiquadLanes needs at least one lane");
+    
+    static constexpr size_t ALIGNMENT = 32;
+    
+    // Per-sample coefficient increments of a ramp
+    struct CoefficientSteps {
+        alignas(ALIGNMENT) SampleType b0[NumLanes];
+        alignas(ALIGNMENT) SampleType b1[NumLanes];
+        alignas(ALIGNMENT) SampleType b2[NumLanes];
+        alignas(ALIGNMENT) SampleType a1[NumLanes];
+        alignas(ALIGNMENT) SampleType a2[NumLanes];
+    };
+    
+    BiquadLanes() {
+        setCoefficients(BiquadCoeffs());
+        reset();
+    }
+    
+    // ========================================================================
+    // Set coefficients (one lane, or the same filter on every lane)
+    // ========================================================================
+    void setCoefficients(int lane, BiquadCoeffs newCoeffs) {
+        newCoeffs.normalize();
+        b0[lane] = static_cast<SampleType>(newCoeffs.b0);
+        b1[lane] = static_cast<SampleType>(newCoeffs.b1);
+        b2[lane] = static_cast<SampleType>(newCoeffs.b2);
+        a1[lane] = static_cast<SampleType>(newCoeffs.a1);
+        a2[lane] = static_cast<SampleType>(newCoeffs.a2);
+    }
+    
+    void setCoefficients(const BiquadCoeffs& newCoeffs) {
+        for (int lane = 0; lane < NumLanes; ++lane) {
+            setCoefficients(lane, newCoeffs);
+        }
+    }
+    
+    BiquadCoeffs getCoefficients(int lane) const {
+        BiquadCoeffs c;
+        c.b0 = b0[lane];
+        c.b1 = b1[lane];
+        c.b2 = b2[lane];
+        c.a1 = a1[lane];
+        c.a2 = a2[lane];
+        return c;
+    }
+    
+    // ========================================================================
+    // Reset filter state
+    // ========================================================================
+    void reset() {
+        for (int lane = 0; lane < NumLanes; ++lane) {
+            z1[lane] = SampleType(0);
+            z2[lane] = SampleType(0);
+        }
+    }
+    
+    // ========================================================================
+    // Process one sample of every lane in place
+    // ========================================================================
+    inline void processFrame(SampleType* frame) {
+        for (int lane = 0; lane < NumLanes; ++lane) {
+            const SampleType input = frame[lane];
+            const SampleType output = b0[lane] * input + z1[lane];
+            z1[lane] = b1[lane] * input - a1[lane] * output + z2[lane];
+            z2[lane] = b2[lane] * input - a2[lane] * output;
+            frame[lane] = output;
+        }
+    }
+    
+    // One lane on its own, for channels that are filtered separately
+    inline SampleType processSample(int lane, SampleType input) {
+        const SampleType output = b0[lane] * input + z1[lane];
+        z1[lane] = b1[lane] * input - a1[lane] * output + z2[lane];
+        z2[lane] = b2[lane] * input - a2[lane] * output;
+        return output;
+    }
+    
+    // Once per block
+    void flushDenormals() {
+        for (int lane = 0; lane < NumLanes; ++lane) {
+            z1[lane] = flushDenormal(z1[lane]);
+            z2[lane] = flushDenormal(z2[lane]);
+        }
+    }
+    
+    // Takes over another section's state (keeps this one's coefficients)
+    void copyStateFrom(const BiquadLanes& other) {
+        for (int lane = 0; lane < NumLanes; ++lane) {
+            z1[lane] = other.z1[lane];
+            z2[lane] = other.z2[lane];
+        }
+    }
+    
+    // Takes over another section's coefficients (keeps this one's state)
+    void copyCoefficientsFrom(const BiquadLanes& other) {
+        for (int lane = 0; lane < NumLanes; ++lane) {
+            b0[lane] = other.b0[lane];
+            b1[lane] = other.b1[lane];
+            b2[lane] = other.b2[lane];
+            a1[lane] = other.a1[lane];
+            a2[lane] = other.a2[lane];
+        }
+    }
+    
+    // ========================================================================
+    // Coefficient ramps
+    // ========================================================================
+    // Steps that bring these coefficients to the target's in numSamples
+    CoefficientSteps getStepsTowards(const BiquadLanes& target, int numSamples) const {
+        const SampleType scale = SampleType(1) / static_cast<SampleType>(numSamples);
+        CoefficientSteps steps;
+        for (int lane = 0; lane < NumLanes; ++lane) {
+            steps.b0[lane] = (target.b0[lane] - b0[lane]) * scale;
+            steps.b1[lane] = (target.b1[lane] - b1[lane]) * scale;
+            steps.b2[lane] = (target.b2[lane] - b2[lane]) * scale;
+            steps.a1[lane] = (target.a1[lane] - a1[lane]) * scale;
+            steps.a2[lane] = (target.a2[lane] - a2[lane]) * scale;
+        }
+        return steps;
+    }
+    
+    inline void stepCoefficients(const CoefficientSteps& steps) {
+        for (int lane = 0; lane < NumLanes; ++lane) {
+            b0[lane] += steps.b0[lane];
+            b1[lane] += steps.b1[lane];
+            b2[lane] += steps.b2[lane];
+            a1[lane] += steps.a1[lane];
+            a2[lane] += steps.a2[lane];
+        }
+    }
+
+private:
+    alignas(ALIGNMENT) SampleType b0[NumLanes];
+    alignas(ALIGNMENT) SampleType b1[NumLanes];
+    alignas(ALIGNMENT) SampleType b2[NumLanes];
+    alignas(ALIGNMENT) SampleType a1[NumLanes];
+    alignas(ALIGNMENT) SampleType a2[NumLanes];
+    alignas(ALIGNMENT) SampleType z1[NumLanes];
+    alignas(ALIGNMENT) SampleType z2[NumLanes];
+};
+
+// ============================================================================
+// Multi-lane Cascaded Biquad
+// All stages run back to back on each sample, so a sample stays in
+// registers through the whole cascade instead of making one pass over
+// the buffer per stage.
+// ============================================================================
+template <typename SampleType, int NumLanes>
+class BiquadLaneCascade {
+public:
+    // ========================================================================
+    // Stages and coefficients
+    // ========================================================================
+    void setNumStages(int stages) {
+        numStages = juce::jlimit(0, MAX_BIQUADS_PER_BAND, stages);
+        rampRemaining = 0;
+        reset();
+    }
+    
+    int getNumStages() const { return numStages; }
+    
+    void setStageCoefficients(int stageIndex, const BiquadCoeffs& coeffs) {
+        if (stageIndex >= 0 && stageIndex < numStages) {
+            stages[stageIndex].setCoefficients(coeffs);
+        }
+    }
+    
+    void setStageCoefficients(int stageIndex, int lane, const BiquadCoeffs& coeffs) {
+        if (stageIndex >= 0 && stageIndex < numStages) {
+            stages[stageIndex].setCoefficients(lane, coeffs);
+        }
+    }
+    
+    // Same Butterworth design as CascadedBiquad, on every lane
+    void configureButterworth(EQFilterType type, double sampleRate,
+                              double frequency, int order) {
+        std::array<BiquadCoeffs, MAX_BIQUADS_PER_BAND> design;
+        setNumStages(CascadedBiquad::designButterworth(type, sampleRate, frequency,
+                                                       order, design));
+        for (int i = 0; i < numStages; ++i) {
+            stages[i].setCoefficients(design[i]);
+        }
+    }
+    
+    void reset() {
+        for (auto& stage : stages) {
+            stage.reset();
+        }
+    }
+    
+    // ========================================================================
+    // Coefficient ramp to a design with the same number of stages, one step
+    // per sample. Every intermediate section is a convex mix of two stable
+    // sections and so is stable itself. Zero samples sets it at once.
+    // ========================================================================
+    void rampTo(const std::array<BiquadCoeffs, MAX_BIQUADS_PER_BAND>& design,
+                int numSamples) {
+        for (int i = 0; i < numStages; ++i) {
+            rampTargets[i].setCoefficients(design[i]);
+        }
+        
+        if (numSamples <= 0) {
+            finishRamp();
+            return;
+        }
+        
+        for (int i = 0; i < numStages; ++i) {
+            rampSteps[i] = stages[i].getStepsTowards(rampTargets[i], numSamples);
+        }
+        rampRemaining = numSamples;
+    }
+    
+    bool isRamping() const { return rampRemaining > 0; }
+    
+    // ========================================================================
+    // Process NumLanes channels in one pass. Channels may alias (a mono
+    // buffer fed to both lanes of a stereo filter comes out filtered once).
+    // ========================================================================
+    template <typename BufferType>
+    void processBlock(BufferType* const* channels, int numSamples) {
+        const int numRamped = juce::jmin(numSamples, rampRemaining);
+        processFrames<true>(channels, 0, numRamped);
+        processFrames<false>(channels, numRamped, numSamples);
+        flushDenormals();
+    }
+    
+    // One lane only (left-only, mid or side bands)
+    template <typename BufferType>
+    void processLane(int lane, BufferType* samples, int numSamples) {
+        const int numRamped = juce::jmin(numSamples, rampRemaining);
+        processLaneSamples<true>(lane, samples, 0, numRamped);
+        processLaneSamples<false>(lane, samples, numRamped, numSamples);
+        flushDenormals();
+    }
+    
+    void flushDenormals() {
+        for (int stage = 0; stage < numStages; ++stage) {
+            stages[stage].flushDenormals();
+        }
+    }
+    
+    BiquadLanes<SampleType, NumLanes>& getStage(int index) { return stages[index]; }
+    
+    // ========================================================================
+    // Response of one lane
+    // ========================================================================
+    double getMagnitudeResponse(int lane, double frequency, double sampleRate) const {
+        double magnitude = 1.0;
+        for (int i = 0; i < numStages; ++i) {
+            magnitude *= Biquad::getMagnitudeResponse(stages[i].getCoefficients(lane),
+                                                      frequency, sampleRate);
+        }
+        return magnitude;
+    }
+    
+    double getPhaseResponse(int lane, double frequency, double sampleRate) const {
+        double phase = 0.0;
+        for (int i = 0; i < numStages; ++i) {
+            phase += Biquad::getPhaseResponse(stages[i].getCoefficients(lane),
+                                              frequency, sampleRate);
+        }
+        return phase;
+    }
+
+private:
+    using Lanes = BiquadLanes<SampleType, NumLanes>;
+    
+    template <bool Ramping, typename BufferType>
+    void processFrames(BufferType* const* channels, int start, int end) {
+        alignas(32) SampleType frame[NumLanes];
+        
+        for (int i = start; i < end; ++i) {
+            for (int lane = 0; lane < NumLanes; ++lane) {
+                frame[lane] = static_cast<SampleType>(channels[lane][i]);
+            }
+            for (int stage = 0; stage < numStages; ++stage) {
+                stages[stage].processFrame(frame);
+            }
+            for (int lane = 0; lane < NumLanes; ++lane) {
+                channels[lane][i] = static_cast<BufferType>(frame[lane]);
+            }
+            if (Ramping) {
+                advanceRamp();
+            }
+        }
+    }
+    
+    template <bool Ramping, typename BufferType>
+    void processLaneSamples(int lane, BufferType* samples, int start, int end) {
+        for (int i = start; i < end; ++i) {
+            SampleType x = static_cast<SampleType>(samples[i]);
+            for (int stage = 0; stage < numStages; ++stage) {
+                x = stages[stage].processSample(lane, x);
+            }
+            samples[i] = static_cast<BufferType>(x);
+            if (Ramping) {
+                advanceRamp();
+            }
+        }
+    }
+    
+    inline void advanceRamp() {
+        if (--rampRemaining == 0) {
+            finishRamp();
+            return;
+        }
+        for (int stage = 0; stage < numStages; ++stage) {
+            stages[stage].stepCoefficients(rampSteps[stage]);
+        }
+    }
+    
+    // Lands exactly on the target, whatever rounding the steps collected
+    void finishRamp() {
+        for (int i = 0; i < numStages; ++i) {
+            stages[i].copyCoefficientsFrom(rampTargets[i]);
+        }
+        rampRemaining = 0;
+    }
+    
+    std::array<Lanes, MAX_BIQUADS_PER_BAND> stages;
+    int numStages = 0;
+    
+    // Coefficient ramp in progress
+    std::array<Lanes, MAX_BIQUADS_PER_BAND> rampTargets;
+    std::array<typename Lanes::CoefficientSteps, MAX_BIQUADS_PER_BAND> rampSteps;
+    int rampRemaining = 0;
+};
+
 } // namespace Sphere
 
@@ -17,6 +17,7 @@
 
 #include "SphereEQTypes.h"
 #include "SphereEQCookbook.h"
+#include "SphereEQBiquad.h"
 #include <cmath>
 #include <algorithm>
 
@@ -61,7 +62,8 @@ namespace DynamicFastMath {
 
 // ============================================================================
 // Sidechain Biquad Filter
-// Narrow bandpass filter for frequency-specific level detection
+// Narrow bandpass filter for frequency-specific level detection; left and
+// right (or a mono buffer on the left lane) run as two lanes of one pass
 // ============================================================================
 class SidechainFilter {
 public:
@@ -79,54 +81,47 @@ public:
         double cosOmega = std::cos(omega);
         double alpha = sinOmega / (2.0 * q);
         
-        // Bandpass (constant 0 dB peak gain)
-        b0 = alpha;
-        b1 = 0.0;
-        b2 = -alpha;
-        a0 = 1.0 + alpha;
-        a1 = -2.0 * cosOmega;
-        a2 = 1.0 - alpha;
-        
-        // Normalize
-        b0 /= a0;
-        b1 /= a0;
-        b2 /= a0;
-        a1 /= a0;
-        a2 /= a0;
+        // Bandpass (constant 0 dB peak gain), normalized by the lanes
+        BiquadCoeffs c;
+        c.b0 = alpha;
+        c.b1 = 0.0;
+        c.b2 = -alpha;
+        c.a0 = 1.0 + alpha;
+        c.a1 = -2.0 * cosOmega;
+        c.a2 = 1.0 - alpha;
+        lanes.setCoefficients(c);
     }
     
     void reset() {
-        x1 = x2 = y1 = y2 = 0.0;
+        lanes.reset();
     }
     
-    // Process single sample (for sidechain)
-    float processSample(float input) {
-        double x0 = static_cast<double>(input);
-        double y0 = b0 * x0 + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
-        
-        x2 = x1; x1 = x0;
-        y2 = y1; y1 = y0;
-        
-        // Denormal prevention
-        if (std::abs(y1) < 1e-15) y1 = 0.0;
-        if (std::abs(y2) < 1e-15) y2 = 0.0;
-        
-        return static_cast<float>(y0);
+    // Process stereo block for sidechain analysis
+    void processBlock(const float* left, const float* right,
+                      float* outLeft, float* outRight, int numSamples) {
+        double frame[2];
+        for (int i = 0; i < numSamples; ++i) {
+            frame[0] = left[i];
+            frame[1] = right[i];
+            lanes.processFrame(frame);
+            outLeft[i] = static_cast<float>(frame[0]);
+            outRight[i] = static_cast<float>(frame[1]);
+        }
+        lanes.flushDenormals();
     }
     
-    // Process block for sidechain analysis
-    void processBlock(const float* input, float* output, int numSamples) {
+    // Mono block, on the left lane
+    void processMono(const float* input, float* output, int numSamples) {
         for (int i = 0; i < numSamples; ++i) {
-            output[i] = processSample(input[i]);
+            output[i] = static_cast<float>(
+                lanes.processSample(0, static_cast<double>(input[i])));
         }
+        lanes.flushDenormals();
     }
     
 private:
     double sampleRate = 44100.0;
-    double b0 = 0.0, b1 = 0.0, b2 = 0.0;
-    double a0 = 1.0, a1 = 0.0, a2 = 0.0;
-    double x1 = 0.0, x2 = 0.0;
-    double y1 = 0.0, y2 = 0.0;
+    BiquadLanes<double, 2> lanes;
 };
 
 // ============================================================================
@@ -376,8 +371,7 @@ public:
         this->sampleRate = sampleRate;
         this->maxBlockSize = maxBlockSize;
         
-        sidechainL.prepare(sampleRate);
-        sidechainR.prepare(sampleRate);
+        sidechain.prepare(sampleRate);
         envelopeL.prepare(sampleRate, maxBlockSize);
         envelopeR.prepare(sampleRate, maxBlockSize);
         
@@ -391,8 +385,7 @@ public:
     }
     
     void reset() {
-        sidechainL.reset();
-        sidechainR.reset();
+        sidechain.reset();
         envelopeL.reset();
         envelopeR.reset();
         gainSmoother.setCurrentAndTargetValue(1.0f);
@@ -402,8 +395,7 @@ public:
     void setParameters(const EQBandParams& params) {
         // Update sidechain filters to match band frequency
         double sidechainQ = std::max(0.5, std::min(10.0, params.dynamicSidechainQ));
-        sidechainL.setParameters(params.frequency, sidechainQ);
-        sidechainR.setParameters(params.frequency, sidechainQ);
+        sidechain.setParameters(params.frequency, sidechainQ);
         
         // Update envelope followers
         envelopeL.setAttack(params.dynamicAttack);
@@ -439,8 +431,8 @@ public:
         if (dynamicMode == EQDynamicMode::Off) return;
         
         // Step 1: Filter through sidechain to isolate band frequency
-        sidechainL.processBlock(left, sidechainBufferL.data(), numSamples);
-        sidechainR.processBlock(right, sidechainBufferR.data(), numSamples);
+        sidechain.processBlock(left, right, sidechainBufferL.data(),
+                               sidechainBufferR.data(), numSamples);
         
         // Step 2: Compute envelope from filtered sidechain
         float envL = envelopeL.processBlock(sidechainBufferL.data(), numSamples);
@@ -491,7 +483,7 @@ public:
     void processMono(float* samples, int numSamples) {
         if (dynamicMode == EQDynamicMode::Off) return;
         
-        sidechainL.processBlock(samples, sidechainBufferL.data(), numSamples);
+        sidechain.processMono(samples, sidechainBufferL.data(), numSamples);
         float env = envelopeL.processBlock(sidechainBufferL.data(), numSamples);
         float envDb = DynamicFastMath::linearToDb(env);
         float dynamicGainDb = gainComputer.computeGain(envDb);
@@ -521,9 +513,8 @@ private:
     double sampleRate = 44100.0;
     int maxBlockSize = 512;
     
-    // Sidechain filters
-    SidechainFilter sidechainL;
-    SidechainFilter sidechainR;
+    // Sidechain filter (left and right lanes)
+    SidechainFilter sidechain;
     
     // Envelope followers
     DynamicEnvelopeFollower envelopeL;
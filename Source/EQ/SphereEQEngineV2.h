@@ -1,8 +1,10 @@
 #pragma once
 #include "SphereEQAnalyzer.h"
 #include "SphereEQBandProcessor.h"
+#include "SphereEQFusedCascade.h"
 #include "SphereEQLinearPhase.h"
 #include "SphereEQOversampler.h"
+#include "../Common/SphereSPSCQueue.h"
 #include <array>
 #include <atomic>
 #include <vector>
@@ -10,10 +12,9 @@
 namespace Sphere {
 
 // ============================================================================
-// Lock-free parameter snapshot for RT-safe updates
+// Engine-wide settings
 // ============================================================================
-struct EQParameterSnapshot {
-  std::array<EQBandParams, MAX_EQ_BANDS> bandParams;
+struct EQGlobalParams {
   bool enabled = true;
   float outputGainLinear = 1.0f;
   EQPhaseMode globalPhaseMode = EQPhaseMode::MinimumPhase;
@@ -22,18 +23,37 @@ struct EQParameterSnapshot {
       SphereEQOversampler::Factor::X2;
   EQCharacterMode globalCharacterMode = EQCharacterMode::Clean;
 
+  // Band edits ramp their coefficients (or crossfade) over this time
+  double smoothingSeconds = 0.02;
+};
+
+// ============================================================================
+// Parameter state; the message thread edits one copy, the audio thread
+// keeps its own, updated from the command queue
+// ============================================================================
+struct EQParameterSnapshot : EQGlobalParams {
+  std::array<EQBandParams, MAX_EQ_BANDS> bandParams;
+
   // Active band indices for optimized iteration
   std::vector<int> activeBandIndices;
   std::vector<int> midModeBandIndices;
   std::vector<int> sideModeBandIndices;
 
-  void rebuildActiveIndices() {
+  void reserveIndices() {
+    activeBandIndices.reserve(MAX_EQ_BANDS);
+    midModeBandIndices.reserve(MAX_EQ_BANDS);
+    sideModeBandIndices.reserve(MAX_EQ_BANDS);
+  }
+
+  // A bypassed band stays active while isFading(index) says it is still
+  // fading out
+  template <typename IsFading> void rebuildActiveIndices(IsFading &&isFading) {
     activeBandIndices.clear();
     midModeBandIndices.clear();
     sideModeBandIndices.clear();
 
     for (int i = 0; i < MAX_EQ_BANDS; ++i) {
-      if (!bandParams[i].bypass) {
+      if (!bandParams[i].bypass || isFading(i)) {
         activeBandIndices.push_back(i);
 
         if (bandParams[i].stereoMode == EQStereoMode::Mid) {
@@ -44,6 +64,24 @@ struct EQParameterSnapshot {
       }
     }
   }
+
+  void rebuildActiveIndices() {
+    rebuildActiveIndices([](int) { return false; });
+  }
+};
+
+// ============================================================================
+// Parameter change sent from the message thread to the audio thread. Each
+// command carries the complete state it touches; edits that find the queue
+// full go to the engine's resync state instead.
+// ============================================================================
+struct EQCommand {
+  enum class Type : uint8_t { Band, Globals };
+
+  Type type = Type::Band;
+  int bandIndex = 0;
+  EQBandParams band;
+  EQGlobalParams globals;
 };
 
 // ============================================================================
@@ -52,13 +90,10 @@ struct EQParameterSnapshot {
 class SphereEQEngineV2 {
 public:
   SphereEQEngineV2() {
-    // Initialize snapshots
-    for (int i = 0; i < MAX_EQ_BANDS; ++i) {
-      paramSnapshots[0].bandParams[i].bypass = true;
-      paramSnapshots[1].bandParams[i].bypass = true;
-    }
-    currentSnapshot.store(0);
-    pendingSnapshot.store(-1);
+    for (auto &params : editState.bandParams)
+      params.bypass = true;
+    editState.reserveIndices();
+    liveState = editState;
   }
 
   // ========================================================================
@@ -69,9 +104,20 @@ public:
     this->maxBlockSize = maxBlockSize;
     this->numChannels = juce::jlimit(1, 2, numChannels);
 
+    // Playback is stopped: take the current edit state as it is and drop
+    // any commands still queued
+    EQCommand command;
+    while (commands.pop(command)) {
+    }
+    resync.bandMask = 0;
+    resyncPending.store(false, std::memory_order_relaxed);
+    liveState = editState;
+    liveState.reserveIndices();
+
     // Prepare all band processors with sample rate
     for (int i = 0; i < MAX_EQ_BANDS; ++i) {
       bands[i].prepare(sampleRate, maxBlockSize);
+      bands[i].setParameters(liveState.bandParams[i], 0);
     }
 
     // Prepare oversampler for Natural Phase mode
@@ -83,8 +129,16 @@ public:
     // Prepare oversampled band processors (at 2x or 4x rate)
     for (int i = 0; i < MAX_EQ_BANDS; ++i) {
       oversampledBands[i].prepare(sampleRate * 2.0, maxBlockSize * 4);
+      oversampledBands[i].setParameters(liveState.bandParams[i], 0);
     }
 
+    // The cascades load programs for the new rate on the first block
+    programsDirty = true;
+    fusedCascade.reset();
+    oversampledFusedCascade.reset();
+    midSideCascade.reset();
+    oversampledMidSideCascade.reset();
+
     // Allocate M/S working buffers
     midBuffer.resize(maxBlockSize * 4); // Extra for oversampling
     sideBuffer.resize(maxBlockSize * 4);
@@ -110,6 +164,10 @@ public:
       bands[i].reset();
       oversampledBands[i].reset();
     }
+    fusedCascade.reset();
+    oversampledFusedCascade.reset();
+    midSideCascade.reset();
+    oversampledMidSideCascade.reset();
     oversampler.reset();
     linearPhaseEQ.reset();
     outputGainSmoother.setCurrentAndTargetValue(1.0f);
@@ -119,15 +177,9 @@ public:
   // Process Audio Block
   // ========================================================================
   void processBlock(juce::AudioBuffer<float> &buffer, juce::MidiBuffer &midi) {
-    // Handle parameter updates
-    int pending = pendingSnapshot.load(std::memory_order_acquire);
-    if (pending != -1) {
-      currentSnapshot.store(pending, std::memory_order_release);
-      pendingSnapshot.store(-1, std::memory_order_release);
-    }
+    applyPendingCommands();
 
-    const auto &snapshot =
-        paramSnapshots[currentSnapshot.load(std::memory_order_relaxed)];
+    const auto &snapshot = liveState;
 
     if (!snapshot.enabled)
       return;
@@ -190,48 +242,32 @@ public:
   // Phase Mode Settings
   // ========================================================================
   void setPhaseMode(EQPhaseMode mode) {
-    int activeIdx = currentSnapshot.load(std::memory_order_relaxed);
-    int writeIdx = 1 - activeIdx;
-    paramSnapshots[writeIdx] = paramSnapshots[activeIdx];
-    paramSnapshots[writeIdx].globalPhaseMode = mode;
-    pendingSnapshot.store(writeIdx, std::memory_order_release);
+    editState.globalPhaseMode = mode;
+    pushGlobals();
   }
 
-  EQPhaseMode getPhaseMode() const {
-    return paramSnapshots[currentSnapshot.load(std::memory_order_relaxed)]
-        .globalPhaseMode;
-  }
+  EQPhaseMode getPhaseMode() const { return editState.globalPhaseMode; }
 
   void setOversampleFactor(SphereEQOversampler::Factor factor) {
-    int activeIdx = currentSnapshot.load(std::memory_order_relaxed);
-    int writeIdx = 1 - activeIdx;
-    paramSnapshots[writeIdx] = paramSnapshots[activeIdx];
-    paramSnapshots[writeIdx].oversampleFactor = factor;
-    pendingSnapshot.store(writeIdx, std::memory_order_release);
+    editState.oversampleFactor = factor;
+    pushGlobals();
   }
 
   void setLinearPhaseLength(LinearPhaseLength length) {
-    int activeIdx = currentSnapshot.load(std::memory_order_relaxed);
-    int writeIdx = 1 - activeIdx;
-    paramSnapshots[writeIdx] = paramSnapshots[activeIdx];
-    paramSnapshots[writeIdx].linearPhaseLength = length;
-    pendingSnapshot.store(writeIdx, std::memory_order_release);
+    editState.linearPhaseLength = length;
+    pushGlobals();
   }
 
   void setGlobalCharacterMode(EQCharacterMode mode) {
-    int activeIdx = currentSnapshot.load(std::memory_order_relaxed);
-    int writeIdx = 1 - activeIdx;
-    paramSnapshots[writeIdx] = paramSnapshots[activeIdx];
-    paramSnapshots[writeIdx].globalCharacterMode = mode;
-    pendingSnapshot.store(writeIdx, std::memory_order_release);
+    editState.globalCharacterMode = mode;
+    pushGlobals();
   }
 
   // ========================================================================
   // Latency Reporting (for host compensation)
   // ========================================================================
   int getLatencySamples() const {
-    auto &snapshot =
-        paramSnapshots[currentSnapshot.load(std::memory_order_relaxed)];
+    const auto &snapshot = editState;
 
     int latency = 0;
     switch (snapshot.globalPhaseMode) {
@@ -262,29 +298,21 @@ public:
   }
 
   // ========================================================================
-  // Parameter updates (lock-free)
+  // Parameter updates (message thread). Edits go to the audio thread as
+  // commands and take effect at the start of its next block.
   // ========================================================================
   void setBandParameters(int bandIndex, const EQBandParams &params) {
     if (bandIndex < 0 || bandIndex >= MAX_EQ_BANDS)
       return;
 
-    int pending = pendingSnapshot.load(std::memory_order_acquire);
-    int activeIdx = currentSnapshot.load(std::memory_order_relaxed);
-    int writeIdx = 1 - activeIdx;
-
-    if (pending != writeIdx) {
-      paramSnapshots[writeIdx] = paramSnapshots[activeIdx];
-    }
+    editState.bandParams[bandIndex] = params;
+    editState.rebuildActiveIndices();
 
-    paramSnapshots[writeIdx].bandParams[bandIndex] = params;
-    paramSnapshots[writeIdx].rebuildActiveIndices();
-
-    if (prepared) {
-      bands[bandIndex].setParametersFromSnapshot(params);
-      oversampledBands[bandIndex].setParametersFromSnapshot(params);
-    }
-
-    pendingSnapshot.store(writeIdx, std::memory_order_release);
+    EQCommand command;
+    command.type = EQCommand::Type::Band;
+    command.bandIndex = bandIndex;
+    command.band = params;
+    pushCommand(command);
   }
 
   const EQBandParams &getBandParameters(int bandIndex) const {
@@ -292,8 +320,7 @@ public:
       static EQBandParams defaultParams;
       return defaultParams;
     }
-    return paramSnapshots[currentSnapshot.load(std::memory_order_relaxed)]
-        .bandParams[bandIndex];
+    return editState.bandParams[bandIndex];
   }
 
   // Convenience setters
@@ -382,41 +409,62 @@ public:
     setBandParameters(bandIndex, params);
   }
 
-  void setEnabled(bool shouldEnable) {
-    int activeIdx = currentSnapshot.load(std::memory_order_relaxed);
-    int writeIdx = 1 - activeIdx;
-    paramSnapshots[writeIdx] = paramSnapshots[activeIdx];
-    paramSnapshots[writeIdx].enabled = shouldEnable;
-    pendingSnapshot.store(writeIdx, std::memory_order_release);
+  void setBandTopology(int bandIndex, EQBandTopology topology) {
+    if (bandIndex < 0 || bandIndex >= MAX_EQ_BANDS)
+      return;
+    auto params = getBandParameters(bandIndex);
+    params.topology = topology;
+    setBandParameters(bandIndex, params);
+  }
+
+  // Frequency sweep of an SVF band: LFO rate (Hz) and depth, and envelope
+  // depth, in octaves
+  void setBandModulation(int bandIndex, double rate, double depth,
+                         double envelope) {
+    if (bandIndex < 0 || bandIndex >= MAX_EQ_BANDS)
+      return;
+    auto params = getBandParameters(bandIndex);
+    params.modulationRate = rate;
+    params.modulationDepth = depth;
+    params.modulationEnvelope = envelope;
+    setBandParameters(bandIndex, params);
   }
 
-  bool isEnabled() const {
-    return paramSnapshots[currentSnapshot.load(std::memory_order_relaxed)]
-        .enabled;
+  void setEnabled(bool shouldEnable) {
+    editState.enabled = shouldEnable;
+    pushGlobals();
   }
 
+  bool isEnabled() const { return editState.enabled; }
+
   void setOutputGain(double gainDb) {
     float linear = static_cast<float>(
         std::pow(10.0, juce::jlimit(-24.0, 24.0, gainDb) / 20.0));
-    int activeIdx = currentSnapshot.load(std::memory_order_relaxed);
-    int writeIdx = 1 - activeIdx;
-    paramSnapshots[writeIdx] = paramSnapshots[activeIdx];
-    paramSnapshots[writeIdx].outputGainLinear = linear;
-    pendingSnapshot.store(writeIdx, std::memory_order_release);
+    editState.outputGainLinear = linear;
+    pushGlobals();
   }
 
+  // Time over which band edits are smoothed; zero applies them at once
+  void setSmoothingTime(double seconds) {
+    editState.smoothingSeconds = juce::jmax(0.0, seconds);
+    pushGlobals();
+  }
+
+  // Times the command queue overflowed and edits went through a resync
+  int getNumDroppedCommands() const { return commands.getNumDropped(); }
+
   // ========================================================================
   // Analysis
   // ========================================================================
   double getMagnitudeResponse(double frequency) const {
-    auto &snapshot =
-        paramSnapshots[currentSnapshot.load(std::memory_order_relaxed)];
+    const auto &snapshot = editState;
     if (!snapshot.enabled)
       return 1.0;
 
     double totalMagnitude = 1.0;
     for (int idx : snapshot.activeBandIndices) {
-      totalMagnitude *= bands[idx].getMagnitudeResponse(frequency);
+      totalMagnitude *= EQBandProcessor::getMagnitudeResponse(
+          snapshot.bandParams[idx], frequency, sampleRate);
     }
     return totalMagnitude * snapshot.outputGainLinear;
   }
@@ -429,8 +477,7 @@ public:
   }
 
   int getActiveBandCount() const {
-    return static_cast<int>(
-        paramSnapshots[currentSnapshot.load()].activeBandIndices.size());
+    return static_cast<int>(editState.activeBandIndices.size());
   }
 
   // Analyzer Access
@@ -438,6 +485,135 @@ public:
   const SphereEQAnalyzer &getOutputAnalyzer() const { return outputAnalyzer; }
 
 private:
+  void pushGlobals() {
+    EQCommand command;
+    command.type = EQCommand::Type::Globals;
+    command.globals = editState;
+    pushCommand(command);
+  }
+
+  // Once the queue has overflowed, edits are collected in the resync state
+  // until the audio thread has taken it, so none is lost and none overtakes
+  // an earlier one
+  void pushCommand(const EQCommand &command) {
+    if (!resyncPending.load(std::memory_order_acquire) &&
+        commands.push(command))
+      return;
+
+    const juce::SpinLock::ScopedLockType sl(resyncLock);
+    if (command.type == EQCommand::Type::Band) {
+      resync.bandParams[command.bandIndex] = command.band;
+      resync.bandMask |= 1u << command.bandIndex;
+    }
+    resync.globals = editState;
+    resyncPending.store(true, std::memory_order_release);
+  }
+
+  // ========================================================================
+  // Command queue (audio thread, start of each block)
+  // ========================================================================
+  void applyPendingCommands() {
+    EQCommand command;
+    while (commands.pop(command)) {
+      if (command.type == EQCommand::Type::Globals) {
+        static_cast<EQGlobalParams &>(liveState) = command.globals;
+        programsDirty = true;
+        continue;
+      }
+
+      if (command.bandIndex >= 0 && command.bandIndex < MAX_EQ_BANDS)
+        applyBandEdit(command.bandIndex, command.band);
+    }
+
+    if (resyncPending.load(std::memory_order_acquire))
+      applyResync();
+
+    if (programsDirty)
+      compileFusedPrograms();
+  }
+
+  void applyBandEdit(int b, const EQBandParams &params) {
+    // A fused band takes its state back to its own filter, which runs it
+    // until the edit has been smoothed (a band that is already smoothing
+    // has left the cascade)
+    if (!bands[b].isSmoothing()) {
+      fusedCascade.exportBandState(b, bands[b].getFilter());
+      midSideCascade.exportBandState(b, bands[b].getFilter());
+    }
+    if (!oversampledBands[b].isSmoothing()) {
+      oversampledFusedCascade.exportBandState(b,
+                                              oversampledBands[b].getFilter());
+      oversampledMidSideCascade.exportBandState(
+          b, oversampledBands[b].getFilter());
+    }
+
+    const int ramp = static_cast<int>(
+        std::round(liveState.smoothingSeconds * sampleRate));
+    liveState.bandParams[b] = params;
+    bands[b].setParameters(params, ramp);
+    oversampledBands[b].setParameters(params, 2 * ramp);
+    programsDirty = true;
+  }
+
+  // Takes over the edits collected while the queue was full. If the message
+  // thread is writing them right now, the next block tries again.
+  void applyResync() {
+    const juce::SpinLock::ScopedTryLockType sl(resyncLock);
+    if (!sl.isLocked())
+      return;
+
+    static_cast<EQGlobalParams &>(liveState) = resync.globals;
+    for (int b = 0; b < MAX_EQ_BANDS; ++b)
+      if ((resync.bandMask & (1u << b)) != 0)
+        applyBandEdit(b, resync.bandParams[b]);
+
+    resync.bandMask = 0;
+    resyncPending.store(false, std::memory_order_relaxed);
+    programsDirty = true;
+  }
+
+  // Lays out the L/R and M/S fused programs for the live state; bands that
+  // are still smoothing an edit run on their own until they settle
+  void compileFusedPrograms() {
+    const bool natural =
+        liveState.globalPhaseMode == EQPhaseMode::NaturalPhase;
+    const auto &activeBands = natural ? oversampledBands : bands;
+
+    liveState.rebuildActiveIndices(
+        [&](int i) { return activeBands[i].isSmoothing(); });
+
+    auto isBusy = [this](int i) { return bands[i].isSmoothing(); };
+    auto isOversampledBusy = [this](int i) {
+      return oversampledBands[i].isSmoothing();
+    };
+
+    for (bool midSide : {false, true}) {
+      auto &program = midSide ? midSideProgram : fusedProgram;
+      auto &oversampledProgram =
+          midSide ? oversampledMidSideProgram : oversampledFusedProgram;
+
+      program.compile(liveState.bandParams, liveState.activeBandIndices,
+                      sampleRate, numChannels, midSide, ++programGeneration,
+                      isBusy);
+      oversampledProgram.compile(
+          liveState.bandParams, liveState.activeBandIndices, sampleRate * 2.0,
+          numChannels, midSide, ++programGeneration, isOversampledBusy);
+    }
+
+    for (int i = 0; i < MAX_EQ_BANDS; ++i)
+      compiledBusy[i] = activeBands[i].isSmoothing();
+    programsDirty = false;
+  }
+
+  // Once a band has settled it can rejoin the fused cascade (or, if it
+  // faded out, leave the active list)
+  template <typename BandArray>
+  void checkSettledBands(const BandArray &bandProcessors) {
+    for (int idx : liveState.activeBandIndices)
+      if (compiledBusy[idx] && !bandProcessors[idx].isSmoothing())
+        programsDirty = true;
+  }
+
   // ========================================================================
   // Saturation Helper
   // ========================================================================
@@ -489,29 +665,18 @@ private:
     float *leftChannel = buffer.getWritePointer(0);
     float *rightChannel = (numChans > 1) ? buffer.getWritePointer(1) : nullptr;
 
-    // Update filters
-    for (int idx : snapshot.activeBandIndices) {
-      bands[idx].updateIfNeeded();
-    }
-
     // Process M/S bands
     if (!snapshot.midModeBandIndices.empty() ||
         !snapshot.sideModeBandIndices.empty()) {
       processMidSideBands(leftChannel, rightChannel, numSamples, snapshot,
-                          bands);
+                          midSideProgram, midSideCascade, bands);
     }
 
     // Process regular bands
-    for (int idx : snapshot.activeBandIndices) {
-      auto mode = snapshot.bandParams[idx].stereoMode;
-      if (mode != EQStereoMode::Mid && mode != EQStereoMode::Side) {
-        if (rightChannel) {
-          bands[idx].processBlock(leftChannel, rightChannel, numSamples);
-        } else {
-          bands[idx].processBlock(leftChannel, leftChannel, numSamples);
-        }
-      }
-    }
+    processFusedProgram(leftChannel, rightChannel, numSamples, fusedProgram,
+                        fusedCascade, bands);
+
+    checkSettledBands(bands);
   }
 
   // ========================================================================
@@ -532,37 +697,26 @@ private:
           float *rightChannel =
               (numChans > 1) ? oversampledBuffer.getWritePointer(1) : nullptr;
 
-          // Use oversampled band processors
-          for (int idx : snapshot.activeBandIndices) {
-            oversampledBands[idx].updateIfNeeded();
-          }
-
           // Process M/S bands with oversampled processors
           if (!snapshot.midModeBandIndices.empty() ||
               !snapshot.sideModeBandIndices.empty()) {
             processMidSideBands(leftChannel, rightChannel, numSamples, snapshot,
-                                oversampledBands);
+                                oversampledMidSideProgram,
+                                oversampledMidSideCascade, oversampledBands);
           }
 
           // Process regular bands
-          for (int idx : snapshot.activeBandIndices) {
-            auto mode = snapshot.bandParams[idx].stereoMode;
-            if (mode != EQStereoMode::Mid && mode != EQStereoMode::Side) {
-              if (rightChannel) {
-                oversampledBands[idx].processBlock(leftChannel, rightChannel,
-                                                   numSamples);
-              } else {
-                oversampledBands[idx].processBlock(leftChannel, leftChannel,
-                                                   numSamples);
-              }
-            }
-          }
+          processFusedProgram(leftChannel, rightChannel, numSamples,
+                              oversampledFusedProgram, oversampledFusedCascade,
+                              oversampledBands);
 
           // Apply saturation inside the oversampled loop
           if (snapshot.globalCharacterMode != EQCharacterMode::Clean) {
             applySaturation(oversampledBuffer, snapshot.globalCharacterMode);
           }
         });
+
+    checkSettledBands(oversampledBands);
   }
 
   // ========================================================================
@@ -574,15 +728,44 @@ private:
   }
 
   // ========================================================================
-  // Shared M/S conversion and processing
+  // Regular (L/R) bands: fused runs in one pass, the rest band by band
+  // ========================================================================
+  template <typename BandArray>
+  void processFusedProgram(float *left, float *right, int numSamples,
+                           const FusedEQProgram &program,
+                           FusedSOSCascade &cascade,
+                           BandArray &bandProcessors) {
+    if (cascade.getGeneration() != program.generation)
+      cascade.load(program, bandProcessors);
+
+    if (!right)
+      right = left;
+
+    for (const auto &step : program.steps) {
+      if (step.band < 0) {
+        cascade.process(step, left, right, numSamples);
+      } else {
+        bandProcessors[step.band].processBlock(left, right, numSamples);
+      }
+    }
+  }
+
+  // ========================================================================
+  // Shared M/S conversion and processing: fused mid and side bands run on
+  // both buffers in one pass, the rest band by band
   // ========================================================================
   template <typename BandArray>
   void processMidSideBands(float *left, float *right, int numSamples,
                            const EQParameterSnapshot &snapshot,
+                           const FusedEQProgram &program,
+                           FusedSOSCascade &cascade,
                            BandArray &bandProcessors) {
     if (!right)
       return;
 
+    if (cascade.getGeneration() != program.generation)
+      cascade.load(program, bandProcessors);
+
     // Ensure buffer size
     if (midBuffer.size() < static_cast<size_t>(numSamples)) {
       midBuffer.resize(numSamples);
@@ -595,14 +778,18 @@ private:
       sideBuffer[i] = (left[i] - right[i]) * 0.5f;
     }
 
-    // Process all Mid bands
-    for (int idx : snapshot.midModeBandIndices) {
-      bandProcessors[idx].processMidBuffer(midBuffer.data(), numSamples);
-    }
-
-    // Process all Side bands
-    for (int idx : snapshot.sideModeBandIndices) {
-      bandProcessors[idx].processSideBuffer(sideBuffer.data(), numSamples);
+    for (const auto &step : program.steps) {
+      if (step.band < 0) {
+        cascade.process(step, midBuffer.data(), sideBuffer.data(),
+                        numSamples);
+      } else if (snapshot.bandParams[step.band].stereoMode ==
+                 EQStereoMode::Mid) {
+        bandProcessors[step.band].processMidBuffer(midBuffer.data(),
+                                                   numSamples);
+      } else {
+        bandProcessors[step.band].processSideBuffer(sideBuffer.data(),
+                                                    numSamples);
+      }
     }
 
     // Convert M/S back to L/R
@@ -642,16 +829,45 @@ private:
   // Band processors for oversampled (natural phase) processing
   std::array<EQBandProcessor, MAX_EQ_BANDS> oversampledBands;
 
+  // Fused static bands, at the base rate and at the natural phase
+  // oversampled rate (audio thread)
+  FusedEQProgram fusedProgram;
+  FusedEQProgram oversampledFusedProgram;
+  FusedSOSCascade fusedCascade;
+  FusedSOSCascade oversampledFusedCascade;
+  FusedEQProgram midSideProgram;
+  FusedEQProgram oversampledMidSideProgram;
+  FusedSOSCascade midSideCascade;
+  FusedSOSCascade oversampledMidSideCascade;
+  uint32_t programGeneration = 0;
+  bool programsDirty = true;
+
+  // Bands that were smoothing when the programs were compiled
+  std::array<bool, MAX_EQ_BANDS> compiledBusy{};
+
   // Oversampler for natural phase
   SphereEQOversampler oversampler;
 
   // Linear phase FFT convolver
   LinearPhaseEQ linearPhaseEQ;
 
-  // Double-buffered parameter snapshots
-  std::array<EQParameterSnapshot, 2> paramSnapshots;
-  std::atomic<int> currentSnapshot{0};
-  std::atomic<int> pendingSnapshot{-1};
+  // Parameters as edited (message thread) and as applied (audio thread)
+  EQParameterSnapshot editState;
+  EQParameterSnapshot liveState;
+  SPSCQueue<EQCommand, 256> commands;
+
+  // Edits made since the queue overflowed; the band mask marks which bands
+  // they touched (message thread writes, audio thread takes them)
+  struct ResyncState {
+    std::array<EQBandParams, MAX_EQ_BANDS> bandParams;
+    EQGlobalParams globals;
+    uint32_t bandMask = 0;
+  };
+  static_assert(MAX_EQ_BANDS <= 32, "One mask bit per band");
+
+  juce::SpinLock resyncLock;
+  ResyncState resync;
+  std::atomic<bool> resyncPending{false};
 
   // M/S working buffers
   std::vector<float> midBuffer;
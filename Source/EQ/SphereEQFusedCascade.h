@@ -0,0 +1,225 @@
+/*
+  ==============================================================================
+    SphereEQFusedCascade.h
+    Static EQ bands compiled into one second-order-section cascade
+
+    Processing the buffer band by band reads and writes every sample once
+    per band, and a steep cut adds a pass per stage. Bands that are purely
+    linear and time-invariant - biquads with no dynamics, no character,
+    stereo or single-channel - are instead compiled into a flat array of
+    two-lane sections (left and right), and the cascade runs every section
+    on one sample before moving on to the next, so the sample stays in
+    registers for the whole curve. Mid and side bands get a program of
+    their own, run on the mid and side buffers as the two lanes.
+
+    The engine compiles a FusedEQProgram on the audio thread whenever the
+    band layout changes (into storage reserved up front). It lists the
+    processing steps in band order: runs of fused sections, and the bands
+    that still need their own processor - dynamic or saturating ones, and
+    any band in the middle of a coefficient ramp or crossfade, which only
+    its own processor can run. The FusedSOSCascade loads a new program
+    when its generation changes. A section that survives the change (same
+    band, same stage) keeps its filter state, and a band joining or
+    leaving the cascade takes its state with it, so editing one band
+    never resets the others.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "SphereEQBandProcessor.h"
+#include <array>
+#include <vector>
+
+namespace Sphere {
+
+constexpr int MAX_FUSED_SECTIONS = MAX_EQ_BANDS * MAX_BIQUADS_PER_BAND;
+
+// ============================================================================
+// Compiled cascade (rebuilt by the audio thread when the layout changes)
+// ============================================================================
+struct FusedEQProgram {
+  FusedEQProgram() {
+    sections.reserve(MAX_FUSED_SECTIONS);
+    steps.reserve(2 * MAX_EQ_BANDS);
+  }
+
+  // One second-order section and the band stage it came from
+  struct Section {
+    int band;
+    int stage;
+    BiquadCoeffs left;
+    BiquadCoeffs right;
+  };
+
+  // A run of fused sections (band < 0), or one band processed on its own
+  struct Step {
+    int band;
+    int firstSection;
+    int numSections;
+  };
+
+  std::vector<Section> sections;
+  std::vector<Step> steps;
+  uint32_t generation = 0;
+
+  // Linear, time-invariant biquads
+  static bool canFuse(const EQBandParams &params) {
+    return params.topology == EQBandTopology::Biquad &&
+           params.dynamicMode == EQDynamicMode::Off &&
+           params.characterMode == EQCharacterMode::Clean;
+  }
+
+  static bool isMidSide(EQStereoMode mode) {
+    return mode == EQStereoMode::Mid || mode == EQStereoMode::Side;
+  }
+
+  // An L/R program takes the stereo, left and right bands; an M/S program
+  // (midSide) the mid bands on lane 0 and the side bands on lane 1. Busy
+  // bands are left to their own processors. With a single channel left-
+  // and right-only bands filter it like stereo bands. Doesn't allocate.
+  template <typename IsBusy>
+  void compile(const std::array<EQBandParams, MAX_EQ_BANDS> &bandParams,
+               const std::vector<int> &activeBandIndices, double sampleRate,
+               int numChannels, bool midSide, uint32_t newGeneration,
+               IsBusy &&isBusy) {
+    sections.clear();
+    steps.clear();
+    generation = newGeneration;
+
+    for (int idx : activeBandIndices) {
+      const auto &params = bandParams[idx];
+      if (isMidSide(params.stereoMode) != midSide)
+        continue;
+
+      if (!canFuse(params) || params.bypass || isBusy(idx)) {
+        steps.push_back({idx, 0, 0});
+        continue;
+      }
+
+      if (steps.empty() || steps.back().band >= 0)
+        steps.push_back({-1, static_cast<int>(sections.size()), 0});
+
+      std::array<BiquadCoeffs, MAX_BIQUADS_PER_BAND> design;
+      const int numStages =
+          EQBandProcessor::designFilter(params, sampleRate, design);
+      const bool stereo = numChannels > 1;
+
+      for (int stage = 0; stage < numStages; ++stage) {
+        Section section{idx, stage, design[stage], design[stage]};
+        if (params.stereoMode == EQStereoMode::Mid ||
+            (stereo && params.stereoMode == EQStereoMode::Left))
+          section.right = BiquadCoeffs();
+        else if (params.stereoMode == EQStereoMode::Side ||
+                 (stereo && params.stereoMode == EQStereoMode::Right))
+          section.left = BiquadCoeffs();
+
+        sections.push_back(section);
+        ++steps.back().numSections;
+      }
+    }
+  }
+};
+
+// ============================================================================
+// Fused cascade (audio thread)
+// ============================================================================
+class FusedSOSCascade {
+public:
+  uint32_t getGeneration() const { return generation; }
+
+  void reset() {
+    for (auto &bank : banks)
+      for (auto &section : bank)
+        section.reset();
+  }
+
+  // Takes the program's coefficients. State follows each band stage; a
+  // band that was processed on its own hands over its filter's state.
+  template <typename BandArray>
+  void load(const FusedEQProgram &program, BandArray &bands) {
+    const auto &previous = banks[static_cast<size_t>(active)];
+    auto &next = banks[static_cast<size_t>(1 - active)];
+
+    std::array<std::array<int16_t, MAX_BIQUADS_PER_BAND>, MAX_EQ_BANDS>
+        previousSlot;
+    for (auto &band : previousSlot)
+      band.fill(-1);
+    for (int i = 0; i < numSections; ++i)
+      previousSlot[sectionBand[i]][sectionStage[i]] = static_cast<int16_t>(i);
+
+    numSections = juce::jmin(static_cast<int>(program.sections.size()),
+                             MAX_FUSED_SECTIONS);
+    for (int i = 0; i < numSections; ++i) {
+      const auto &section = program.sections[static_cast<size_t>(i)];
+      auto &lanes = next[static_cast<size_t>(i)];
+      lanes.setCoefficients(0, section.left);
+      lanes.setCoefficients(1, section.right);
+
+      const int slot = previousSlot[section.band][section.stage];
+      auto &bandFilter = bands[section.band].getFilter();
+      if (slot >= 0)
+        lanes.copyStateFrom(previous[static_cast<size_t>(slot)]);
+      else if (section.stage < bandFilter.getNumStages())
+        lanes.copyStateFrom(bandFilter.getStage(section.stage));
+      else
+        lanes.reset();
+
+      sectionBand[i] = static_cast<int16_t>(section.band);
+      sectionStage[i] = static_cast<int16_t>(section.stage);
+    }
+
+    active = 1 - active;
+    generation = program.generation;
+  }
+
+  // Before a band is edited: its fused sections' state goes back to its
+  // own filter, which runs it while the edit is smoothed
+  void exportBandState(int band, BiquadLaneCascade<double, 2> &bandFilter) {
+    const auto &bank = banks[static_cast<size_t>(active)];
+    for (int i = 0; i < numSections; ++i) {
+      if (sectionBand[i] != band ||
+          sectionStage[i] >= bandFilter.getNumStages())
+        continue;
+
+      bandFilter.getStage(sectionStage[i])
+          .copyStateFrom(bank[static_cast<size_t>(i)]);
+    }
+  }
+
+  // One run of sections over the buffer; right may be the same buffer as
+  // left for mono. An M/S program takes the mid and side buffers.
+  void process(const FusedEQProgram::Step &step, float *left, float *right,
+               int numSamples) {
+    auto &bank = banks[static_cast<size_t>(active)];
+    const int first = step.firstSection;
+    const int last = juce::jmin(first + step.numSections, numSections);
+
+    alignas(32) double frame[2];
+    for (int i = 0; i < numSamples; ++i) {
+      frame[0] = left[i];
+      frame[1] = right[i];
+      for (int s = first; s < last; ++s)
+        bank[static_cast<size_t>(s)].processFrame(frame);
+      left[i] = static_cast<float>(frame[0]);
+      right[i] = static_cast<float>(frame[1]);
+    }
+
+    for (int s = first; s < last; ++s)
+      bank[static_cast<size_t>(s)].flushDenormals();
+  }
+
+private:
+  using Bank = std::array<BiquadLanes<double, 2>, MAX_FUSED_SECTIONS>;
+
+  // The loaded program's sections and the bank being filled by the next
+  // load, so state can be carried across
+  std::array<Bank, 2> banks;
+  int active = 0;
+  int numSections = 0;
+  std::array<int16_t, MAX_FUSED_SECTIONS> sectionBand{};
+  std::array<int16_t, MAX_FUSED_SECTIONS> sectionStage{};
+  uint32_t generation = 0;
+};
+
+} // namespace Sphere
@@ -13,6 +13,7 @@
 #include <JuceHeader.h>
 #include "SphereEQTypes.h"
 #include "SphereEQCookbook.h"
+#include "../Common/SphereFFT.h"
 #include <array>
 #include <vector>
 #include <complex>
@@ -20,73 +21,6 @@
 
 namespace Sphere {
 
-// ============================================================================
-// Simple FFT Implementation (Cooley-Tukey radix-2)
-// ============================================================================
-class SimpleFFT {
-public:
-    SimpleFFT(int order) : fftOrder(order), fftSize(1 << order) {
-        // Precompute twiddle factors
-        twiddleFactors.resize(fftSize / 2);
-        for (int i = 0; i < fftSize / 2; ++i) {
-            double angle = -2.0 * M_PI * i / fftSize;
-            twiddleFactors[i] = std::complex<double>(std::cos(angle), std::sin(angle));
-        }
-    }
-    
-    void forward(std::vector<std::complex<double>>& data) {
-        performFFT(data, false);
-    }
-    
-    void inverse(std::vector<std::complex<double>>& data) {
-        performFFT(data, true);
-        // Normalize
-        double scale = 1.0 / fftSize;
-        for (auto& c : data) {
-            c *= scale;
-        }
-    }
-    
-    int getSize() const { return fftSize; }
-    
-private:
-    void performFFT(std::vector<std::complex<double>>& data, bool inverse) {
-        // Bit reversal permutation
-        int n = fftSize;
-        for (int i = 1, j = 0; i < n; ++i) {
-            int bit = n >> 1;
-            for (; j & bit; bit >>= 1) {
-                j ^= bit;
-            }
-            j ^= bit;
-            if (i < j) {
-                std::swap(data[i], data[j]);
-            }
-        }
-        
-        // Cooley-Tukey iterative FFT
-        for (int len = 2; len <= n; len <<= 1) {
-            double angle = (inverse ? 2.0 : -2.0) * M_PI / len;
-            std::complex<double> wlen(std::cos(angle), std::sin(angle));
-            
-            for (int i = 0; i < n; i += len) {
-                std::complex<double> w(1.0, 0.0);
-                for (int j = 0; j < len / 2; ++j) {
-                    std::complex<double> u = data[i + j];
-                    std::complex<double> v = data[i + j + len / 2] * w;
-                    data[i + j] = u + v;
-                    data[i + j + len / 2] = u - v;
-                    w *= wlen;
-                }
-            }
-        }
-    }
-    
-    int fftOrder;
-    int fftSize;
-    std::vector<std::complex<double>> twiddleFactors;
-};
-
 // ============================================================================
 // FIR Kernel Length Options
 // ============================================================================
@@ -115,7 +49,7 @@ public:
             fftSize = 1 << fftOrder;
         }
         
-        SimpleFFT fft(fftOrder);
+        FFT<double> fft(fftOrder);
         
         // Create frequency domain representation
         std::vector<std::complex<double>> spectrum(fftSize);
@@ -136,7 +70,7 @@ public:
         }
         
         // Inverse FFT to get impulse response
-        fft.inverse(spectrum);
+        fft.inverse(spectrum.data());
         
         // Extract and window the kernel (centered, symmetric)
         std::vector<double> kernel(kernelLength);
@@ -276,7 +210,7 @@ public:
         fftSize = 1 << fftOrder;
         blockSize = fftSize - kernelLength + 1;
         
-        fft = std::make_unique<SimpleFFT>(fftOrder);
+        fft = std::make_unique<FFT<double>>(fftOrder);
         
         // Allocate buffers
         inputBuffer.resize(fftSize, 0.0);
@@ -301,7 +235,7 @@ public:
             kernelPadded[i] = std::complex<double>(kernel[i], 0.0);
         }
         
-        fft->forward(kernelPadded);
+        fft->forward(kernelPadded.data());
         kernelSpectrum = kernelPadded;
         kernelReady = true;
     }
@@ -356,7 +290,7 @@ private:
         }
         
         // Forward FFT
-        fft->forward(tempSpectrum);
+        fft->forward(tempSpectrum.data());
         
         // Multiply spectra (convolution in time domain)
         for (int i = 0; i < fftSize; ++i) {
@@ -364,7 +298,7 @@ private:
         }
         
         // Inverse FFT
-        fft->inverse(tempSpectrum);
+        fft->inverse(tempSpectrum.data());
         
         // Overlap-add
         int overlapLen = kernelLength - 1;
@@ -394,7 +328,7 @@ private:
     int blockSize = 513;
     double sampleRate = 44100.0;
     
-    std::unique_ptr<SimpleFFT> fft;
+    std::unique_ptr<FFT<double>> fft;
     
     std::vector<double> inputBuffer;
     std::vector<double> outputBuffer;
@@ -0,0 +1,473 @@
+/*
+  ==============================================================================
+    SphereEQSVF.h
+    Modulatable EQ band built from topology-preserving state-variable filters
+
+    A biquad band redoes the cookbook trig for every coefficient change, and
+    a direct-form section whose coefficients move quickly can blow up. A
+    band with the SVF topology instead runs trapezoidal state-variable
+    sections (the structure of the voice filter): every response is a mix
+    of the input, band and low outputs of one update, the integrator states
+    stay meaningful under any coefficient change, and new coefficients cost
+    a FastMath::tanPi and a divide.
+
+    While the band moves - an LFO or envelope sweep of its frequency, or an
+    edit gliding towards new settings - coefficients are recomputed every
+    CONTROL_INTERVAL samples. The envelope follows the band's input, so a
+    positive depth opens the band as the signal gets louder (auto-wah).
+
+    Cut filters are Butterworth like the biquad bands: one SVF section per
+    pole pair, plus a first-order section for odd orders.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../Common/SphereFastMath.h"
+#include "SphereEQBiquad.h"
+#include <array>
+
+namespace Sphere {
+
+// ============================================================================
+// State-variable band filter; lane 0 is left (or mid), lane 1 right (or side)
+// ============================================================================
+class SVFBandFilter {
+public:
+  // Samples between coefficient updates while the band moves
+  static constexpr int CONTROL_INTERVAL = 16;
+
+  // Swept frequency as a fraction of the sample rate; the top stays clear
+  // of tan's pole
+  static constexpr float MIN_CUTOFF = 1.0e-4f;
+  static constexpr float MAX_CUTOFF = 0.49f;
+
+  // Modulation ranges
+  static constexpr double MAX_RATE = 20.0;
+  static constexpr double MAX_DEPTH_OCTAVES = 4.0;
+
+  // Envelope follower, per update
+  static constexpr double ENVELOPE_ATTACK_MS = 5.0;
+  static constexpr double ENVELOPE_RELEASE_MS = 150.0;
+
+  void prepare(double newSampleRate) {
+    sampleRate = newSampleRate;
+    const double updateMs = 1000.0 * CONTROL_INTERVAL / sampleRate;
+    attackCoeff = 1.0 - std::exp(-updateMs / ENVELOPE_ATTACK_MS);
+    releaseCoeff = 1.0 - std::exp(-updateMs / ENVELOPE_RELEASE_MS);
+    lfoIncrement = modulationRate * CONTROL_INTERVAL / sampleRate;
+    updateCoefficients();
+  }
+
+  // Clears the filter and restarts the modulation
+  void reset() {
+    for (auto &section : sections)
+      for (int lane = 0; lane < 2; ++lane) {
+        section.state1[lane] = 0.0;
+        section.state2[lane] = 0.0;
+      }
+    onePoleState[0] = onePoleState[1] = 0.0;
+    lfoPhase = 0.0f;
+    envelope = 0.0;
+    inputPeak = 0.0;
+    samplesUntilUpdate = 0;
+    updateCoefficients();
+  }
+
+  // ========================================================================
+  // Parameters. Within the same layout (type, slope, bypass) frequency,
+  // gain and Q glide over glideSamples; a new layout is set at once with
+  // the states cleared.
+  // ========================================================================
+  void setParameters(const EQBandParams &params, int glideSamples) {
+    const Layout newLayout = getLayout(params);
+    const bool sameLayout = newLayout == layout;
+
+    modulationRate = juce::jlimit(0.0, MAX_RATE, params.modulationRate);
+    lfoIncrement = modulationRate * CONTROL_INTERVAL / sampleRate;
+    lfoDepth = juce::jlimit(0.0, MAX_DEPTH_OCTAVES, params.modulationDepth);
+    envelopeDepth = juce::jlimit(-MAX_DEPTH_OCTAVES, MAX_DEPTH_OCTAVES,
+                                 params.modulationEnvelope);
+
+    target.logFrequency = std::log2(
+        juce::jlimit(MIN_FREQUENCY, MAX_FREQUENCY, params.frequency));
+    target.q = juce::jlimit(MIN_Q, MAX_Q, params.q);
+    // Dynamic bands get their gain from the dynamic processor, as with
+    // the biquad design
+    target.gainDb = params.dynamicMode == EQDynamicMode::Off
+                        ? juce::jlimit(MIN_GAIN_DB, MAX_GAIN_DB, params.gainDb)
+                        : 0.0;
+
+    if (!sameLayout) {
+      layout = newLayout;
+      for (auto &section : sections)
+        for (int lane = 0; lane < 2; ++lane) {
+          section.state1[lane] = 0.0;
+          section.state2[lane] = 0.0;
+        }
+      onePoleState[0] = onePoleState[1] = 0.0;
+    }
+
+    if (!sameLayout || glideSamples <= 0) {
+      current = target;
+      glideUpdates = 0;
+    } else {
+      glideUpdates = (glideSamples + CONTROL_INTERVAL - 1) / CONTROL_INTERVAL;
+      const double scale = 1.0 / glideUpdates;
+      glideStep.logFrequency =
+          (target.logFrequency - current.logFrequency) * scale;
+      glideStep.q = (target.q - current.q) * scale;
+      glideStep.gainDb = (target.gainDb - current.gainDb) * scale;
+    }
+
+    updateCoefficients();
+  }
+
+  // Same type, slope and bypass state: the states carry over
+  static bool hasSameLayout(const EQBandParams &a, const EQBandParams &b) {
+    return getLayout(a) == getLayout(b);
+  }
+
+  // Swept, or gliding towards new settings
+  bool isMoving() const {
+    return glideUpdates > 0 || lfoDepth > 0.0 || envelopeDepth != 0.0;
+  }
+
+  // ========================================================================
+  // Process both lanes in one pass. Channels may alias, as with the biquad
+  // cascade; the envelope follows the louder one.
+  // ========================================================================
+  template <typename BufferType>
+  void processBlock(BufferType *const *channels, int numSamples) {
+    if (layout.order == 0)
+      return;
+
+    int start = 0;
+    while (start < numSamples) {
+      const int end = beginChunk(start, numSamples);
+      if (envelopeDepth != 0.0)
+        for (int i = start; i < end; ++i)
+          trackPeak(juce::jmax(std::abs(channels[0][i]),
+                               std::abs(channels[1][i])));
+
+      // Both inputs are read before either output is written, so aliased
+      // channels run through each lane once
+      for (int i = start; i < end; ++i) {
+        const double left = static_cast<double>(channels[0][i]);
+        const double right = static_cast<double>(channels[1][i]);
+        const double outLeft = processSample(0, left);
+        const double outRight = processSample(1, right);
+        channels[0][i] = static_cast<BufferType>(outLeft);
+        channels[1][i] = static_cast<BufferType>(outRight);
+      }
+
+      start = end;
+    }
+    flushDenormals();
+  }
+
+  // One lane only (left-only, mid or side bands)
+  template <typename BufferType>
+  void processLane(int lane, BufferType *samples, int numSamples) {
+    if (layout.order == 0)
+      return;
+
+    int start = 0;
+    while (start < numSamples) {
+      const int end = beginChunk(start, numSamples);
+      if (envelopeDepth != 0.0)
+        for (int i = start; i < end; ++i)
+          trackPeak(std::abs(samples[i]));
+
+      for (int i = start; i < end; ++i)
+        samples[i] = static_cast<BufferType>(
+            processSample(lane, static_cast<double>(samples[i])));
+
+      start = end;
+    }
+    flushDenormals();
+  }
+
+  // ========================================================================
+  // Response at the current (unswept) settings, through the equivalent
+  // biquads
+  // ========================================================================
+  double getMagnitudeResponse(double frequency) const {
+    double magnitude = 1.0;
+    for (int i = 0; i < getNumSections(); ++i)
+      magnitude *= Biquad::getMagnitudeResponse(sections[i].toBiquad(),
+                                                frequency, sampleRate);
+    if (layout.order % 2 != 0)
+      magnitude *= Biquad::getMagnitudeResponse(getOnePoleBiquad(), frequency,
+                                                sampleRate);
+    return magnitude;
+  }
+
+  // Response of a band's settings (any thread)
+  static double getMagnitudeResponse(const EQBandParams &params,
+                                     double frequency, double sampleRate) {
+    SVFBandFilter filter;
+    filter.prepare(sampleRate);
+    filter.setParameters(params, 0);
+    return filter.getMagnitudeResponse(frequency);
+  }
+
+private:
+  // What a parameter change can't glide across
+  struct Layout {
+    EQFilterType type = EQFilterType::Bell;
+    int order = 0; // 0 when bypassed; cut filters follow their slope
+
+    bool operator==(const Layout &other) const {
+      return type == other.type && order == other.order;
+    }
+  };
+
+  // Settings that glide
+  struct Settings {
+    double logFrequency = 10.0; // log2 Hz
+    double q = 1.0;
+    double gainDb = 0.0;
+  };
+
+  // One trapezoidal SVF section: the update coefficients from the
+  // prewarped gain g and damping k, and the output as a mix of input, band
+  // and low
+  struct Section {
+    double g = 0.0, k = 1.0;
+    double a1 = 1.0, a2 = 0.0, a3 = 0.0;
+    double m0 = 1.0, m1 = 0.0, m2 = 0.0;
+    double state1[2] = {0.0, 0.0};
+    double state2[2] = {0.0, 0.0};
+
+    void set(double newG, double newK, double mix0, double mix1,
+             double mix2) {
+      g = newG;
+      k = newK;
+      a1 = 1.0 / (1.0 + g * (g + k));
+      a2 = g * a1;
+      a3 = g * a2;
+      m0 = mix0;
+      m1 = mix1;
+      m2 = mix2;
+    }
+
+    // Bilinear transform of the same analog section
+    BiquadCoeffs toBiquad() const {
+      BiquadCoeffs c;
+      c.a0 = 1.0 + k * g + g * g;
+      c.a1 = 2.0 * g * g - 2.0;
+      c.a2 = 1.0 - k * g + g * g;
+      c.b0 = m0 * c.a0 + m1 * g + m2 * g * g;
+      c.b1 = m0 * c.a1 + 2.0 * m2 * g * g;
+      c.b2 = m0 * c.a2 - m1 * g + m2 * g * g;
+      c.normalize();
+      return c;
+    }
+  };
+
+  static bool isCut(EQFilterType type) {
+    return type == EQFilterType::LowCut || type == EQFilterType::HighCut;
+  }
+
+  static Layout getLayout(const EQBandParams &params) {
+    Layout result;
+    result.type = params.type;
+    if (!params.bypass)
+      result.order = isCut(params.type) ? static_cast<int>(params.slope) : 2;
+    return result;
+  }
+
+  int getNumSections() const { return layout.order / 2; }
+
+  BiquadCoeffs getOnePoleBiquad() const {
+    // Bilinear transform of 1 / (s + 1) or s / (s + 1)
+    BiquadCoeffs c;
+    c.a0 = 1.0 + onePoleG;
+    c.a1 = onePoleG - 1.0;
+    c.a2 = 0.0;
+    const bool highPass = layout.type == EQFilterType::LowCut;
+    c.b0 = highPass ? 1.0 : onePoleG;
+    c.b1 = highPass ? -1.0 : onePoleG;
+    c.b2 = 0.0;
+    c.normalize();
+    return c;
+  }
+
+  // ========================================================================
+  // Control rate
+  // ========================================================================
+  // End of the run of samples that share the current coefficients
+  int beginChunk(int start, int numSamples) {
+    if (!isMoving())
+      return numSamples;
+
+    if (samplesUntilUpdate == 0) {
+      advanceModulation();
+      updateCoefficients();
+      samplesUntilUpdate = CONTROL_INTERVAL;
+    }
+
+    const int end = juce::jmin(numSamples, start + samplesUntilUpdate);
+    samplesUntilUpdate -= end - start;
+    return end;
+  }
+
+  inline void trackPeak(double level) {
+    inputPeak = juce::jmax(inputPeak, level);
+  }
+
+  void advanceModulation() {
+    const double level = juce::jmin(inputPeak, 1.0);
+    envelope += (level - envelope) *
+                (level > envelope ? attackCoeff : releaseCoeff);
+    inputPeak = 0.0;
+
+    lfoPhase = FastMath::wrapPhaseFull(
+        lfoPhase + static_cast<float>(lfoIncrement));
+
+    if (glideUpdates > 0) {
+      current.logFrequency += glideStep.logFrequency;
+      current.q += glideStep.q;
+      current.gainDb += glideStep.gainDb;
+      if (--glideUpdates == 0)
+        current = target;
+    }
+  }
+
+  void updateCoefficients() {
+    if (layout.order == 0)
+      return;
+
+    const double octaves = current.logFrequency +
+                           lfoDepth * FastMath::sinCycle(lfoPhase) +
+                           envelopeDepth * envelope;
+    const float cutoff =
+        juce::jlimit(MIN_CUTOFF, MAX_CUTOFF,
+                     static_cast<float>(std::exp2(octaves) / sampleRate));
+    const double g = FastMath::tanPi(cutoff);
+
+    // Shelf and bell gain; the pow only runs while the gain moves
+    if (current.gainDb != amplitudeGainDb) {
+      amplitudeGainDb = current.gainDb;
+      amplitude = std::pow(10.0, amplitudeGainDb / 40.0);
+      tiltAmplitude = std::pow(10.0, amplitudeGainDb / 80.0);
+    }
+
+    const double q = current.q;
+    auto &first = sections[0];
+
+    switch (layout.type) {
+    case EQFilterType::Bell: {
+      const double A = amplitude;
+      const double k = 1.0 / (q * A);
+      first.set(g, k, 1.0, k * (A * A - 1.0), 0.0);
+      break;
+    }
+    case EQFilterType::LowShelf:
+    case EQFilterType::Tilt: {
+      // Tilt is the cookbook's gentle low shelf at a quarter of the gain
+      const bool tilt = layout.type == EQFilterType::Tilt;
+      const double A = tilt ? tiltAmplitude : amplitude;
+      const double k = 1.0 / (tilt ? 0.65 : q);
+      first.set(g / std::sqrt(A), k, 1.0, k * (A - 1.0), A * A - 1.0);
+      break;
+    }
+    case EQFilterType::HighShelf: {
+      const double A = amplitude;
+      const double k = 1.0 / q;
+      first.set(g * std::sqrt(A), k, A * A, k * (1.0 - A) * A, 1.0 - A * A);
+      break;
+    }
+    case EQFilterType::Notch:
+      first.set(g, 1.0 / q, 1.0, -1.0 / q, 0.0);
+      break;
+    case EQFilterType::BandPass:
+      // Peak gain Q, as the cookbook band pass
+      first.set(g, 1.0 / q, 0.0, 1.0, 0.0);
+      break;
+    case EQFilterType::AllPass:
+      first.set(g, 1.0 / q, 1.0, -2.0 / q, 0.0);
+      break;
+    case EQFilterType::LowCut:
+    case EQFilterType::HighCut: {
+      const bool highPass = layout.type == EQFilterType::LowCut;
+      for (int i = 0; i < getNumSections(); ++i) {
+        const double k = 1.0 / RBJCookbook::butterworthQ(layout.order, i);
+        if (highPass)
+          sections[i].set(g, k, 1.0, -k, -1.0);
+        else
+          sections[i].set(g, k, 0.0, 0.0, 1.0);
+      }
+      onePoleG = g;
+      onePoleGain = g / (1.0 + g);
+      break;
+    }
+    }
+  }
+
+  // ========================================================================
+  // Audio rate
+  // ========================================================================
+  inline double processSample(int lane, double x) {
+    if (layout.order % 2 != 0) {
+      const double v = (x - onePoleState[lane]) * onePoleGain;
+      const double low = v + onePoleState[lane];
+      onePoleState[lane] = low + v;
+      x = layout.type == EQFilterType::LowCut ? x - low : low;
+    }
+
+    for (int i = 0; i < getNumSections(); ++i) {
+      auto &s = sections[i];
+      const double v3 = x - s.state2[lane];
+      const double band = s.a1 * s.state1[lane] + s.a2 * v3;
+      const double low = s.state2[lane] + s.a2 * s.state1[lane] + s.a3 * v3;
+      s.state1[lane] = 2.0 * band - s.state1[lane];
+      s.state2[lane] = 2.0 * low - s.state2[lane];
+      x = s.m0 * x + s.m1 * band + s.m2 * low;
+    }
+    return x;
+  }
+
+  void flushDenormals() {
+    for (int i = 0; i < getNumSections(); ++i)
+      for (int lane = 0; lane < 2; ++lane) {
+        sections[i].state1[lane] = flushDenormal(sections[i].state1[lane]);
+        sections[i].state2[lane] = flushDenormal(sections[i].state2[lane]);
+      }
+    for (auto &state : onePoleState)
+      state = flushDenormal(state);
+  }
+
+  std::array<Section, MAX_BIQUADS_PER_BAND> sections;
+  double onePoleState[2] = {0.0, 0.0};
+  double onePoleG = 0.0;
+  double onePoleGain = 0.0;
+
+  Layout layout;
+  Settings current;
+  Settings target;
+  Settings glideStep;
+  int glideUpdates = 0;
+
+  // Gain as last converted to amplitude
+  double amplitudeGainDb = 0.0;
+  double amplitude = 1.0;
+  double tiltAmplitude = 1.0;
+
+  // Modulation
+  double modulationRate = 1.0;
+  double lfoIncrement = 0.0;
+  double lfoDepth = 0.0;
+  double envelopeDepth = 0.0;
+  float lfoPhase = 0.0f;
+  double envelope = 0.0;
+  double inputPeak = 0.0;
+  double attackCoeff = 1.0;
+  double releaseCoeff = 1.0;
+  int samplesUntilUpdate = 0;
+
+  double sampleRate = 44100.0;
+};
+
+} // namespace Sphere
@@ -79,6 +79,14 @@ enum class EQPhaseMode {
   NaturalPhase  // Hybrid approach
 };
 
+// ============================================================================
+// Band Filter Topology
+// ============================================================================
+enum class EQBandTopology {
+  Biquad, // Direct-form cookbook sections (static, fusable)
+  SVF     // State-variable sections, modulatable at audio rate
+};
+
 // ============================================================================
 // Filter Slope (dB/octave for cut filters)
 // ============================================================================
@@ -154,8 +162,15 @@ struct EQBandParams {
   // Spectral dynamics parameters
   SpectralQuality spectralQuality = SpectralQuality::Normal;
 
+  // Filter topology; SVF bands can sweep their frequency
+  EQBandTopology topology = EQBandTopology::Biquad;
+  double modulationRate = 1.0;     // Hz LFO rate (0.01 - 20)
+  double modulationDepth = 0.0;    // octaves of LFO sweep (0 - 4)
+  double modulationEnvelope = 0.0; // octaves at full-scale input (-4 to +4)
+
   bool operator==(const EQBandParams &other) const {
     return bypass == other.bypass && type == other.type &&
+           topology == other.topology &&
            std::abs(frequency - other.frequency) < 0.001 &&
            std::abs(q - other.q) < 0.0001 &&
            std::abs(gainDb - other.gainDb) < 0.01 && slope == other.slope &&
@@ -739,6 +739,19 @@ inline const juce::String js = R"JS(
             drawEQSpectrum();
         }
 
+        // Note-on to output latency per input path (ms), from latency/report
+        function requestLatencyReport() { window.location = 'sphere://latency/report'; }
+        function updateLatency(report) {
+            ['device', 'ui', 'remote'].forEach(path => {
+                const cell = document.getElementById('latency-' + path);
+                if (!cell) return;
+                const s = report[path];
+                cell.textContent = (s && s.count > 0)
+                    ? 'p50 ' + s.p50.toFixed(1) + ' / p99 ' + s.p99.toFixed(1) + ' / max ' + s.max.toFixed(1) + ' ms (' + s.count + ')'
+                    : 'no notes yet';
+            });
+        }
+
         function toggleScaleDropdown() {
             const dropdown = document.getElementById('eq-scale-dropdown');
             if (dropdown) dropdown.classList.toggle('open');
@@ -2693,6 +2706,15 @@ inline const juce::String html =
             <div class="settings-dropdown-menu" id="midi-input-menu"></div>
           </div>
         </div>
+        <div style="margin-bottom: 20px;">
+          <label style="display: block; color: rgba(255,255,255,0.6); font-size: 10px; margin-bottom: 5px; letter-spacing: 0.5px;">Note Latency</label>
+          <div style="font-size: 11px; line-height: 1.6; color: rgba(255,255,255,0.85);">
+            <div>Device MIDI: <span id="latency-device">-</span></div>
+            <div>On-screen keys: <span id="latency-ui">-</span></div>
+            <div>Remote: <span id="latency-remote">-</span></div>
+          </div>
+          <button class="settings-dropdown-trigger" style="margin-top: 6px;" onclick="requestLatencyReport()">Refresh</button>
+        </div>
         <button class="popup-dismiss" onclick="toggleSettings()">Close</button>
       </div>
     </body><script>)HTML" +
@@ -0,0 +1,483 @@
+/*
+  ==============================================================================
+    SphereAdditive.h
+    Additive sound, engine and voice synthesizing partials by inverse FFT
+
+    Rather than running one sine per partial, the engine writes every
+    partial of every sounding note into one shared spectrum as a few bins of
+    a Blackman-Harris window's main lobe, then turns the spectrum into audio
+    with a single real inverse FFT per hop. The frames are reshaped to
+    triangles (divided by the analysis window) and overlap-added, which
+    interpolates each partial's amplitude linearly from hop to hop. Cost is
+    a handful of complex adds per partial per hop plus one FFT, whatever the
+    number of partials.
+
+    Partials are updated at hop rate (HOP_SIZE samples) and sound HOP_SIZE
+    samples after they are scheduled. Like the oscillator bank, notes own
+    engine slots and a stolen note keeps fading out in a detached slot.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../Common/SphereFFT.h"
+#include "../Common/SphereFastMath.h"
+#include "SphereSynthTypes.h"
+#include <cmath>
+#include <vector>
+
+namespace Sphere {
+namespace Synth {
+
+constexpr int MAX_PARTIALS = 1024;
+constexpr int MAX_ADDITIVE_SLOTS = 64;
+
+struct AdditivePatch {
+  int numPartials = 256;
+  float rolloff = 1.0f;        // partial k at 1 / k^rolloff
+  float evenLevel = 1.0f;      // even partials relative to odd ones
+  float inharmonicity = 0.0f;  // stiffness: f_k = k f0 sqrt(1 + B k^2)
+  float evolveRate = 0.15f;    // spectral sweep speed, Hz
+  float evolveDepth = 0.5f;    // 0 = static spectrum
+  float attack = 0.3f;         // seconds
+  float release = 1.0f;        // seconds
+};
+
+// ============================================================================
+// Additive Sound
+// ============================================================================
+class AdditiveSound final : public juce::SynthesiserSound {
+public:
+  explicit AdditiveSound(const AdditivePatch &patchToPlay)
+      : patch(patchToPlay) {}
+
+  bool appliesToNote(int /*midiNoteNumber*/) override { return true; }
+  bool appliesToChannel(int /*midiChannel*/) override { return true; }
+
+  const AdditivePatch &getPatch() const { return patch; }
+
+private:
+  AdditivePatch patch;
+};
+
+// ============================================================================
+// Additive Engine (partial slots, shared spectrum and overlap-add output)
+// ============================================================================
+class AdditiveEngine {
+public:
+  static constexpr int FFT_ORDER = 9;
+  static constexpr int FRAME_SIZE = 1 << FFT_ORDER;
+  static constexpr int NUM_BINS = FRAME_SIZE / 2 + 1;
+  static constexpr int HOP_SIZE = FRAME_SIZE / 4;
+
+  // Blackman-Harris main lobe, tabulated at KERNEL_OVERSAMPLING points per
+  // bin; the sidelobes beyond it are below -92 dB and are dropped
+  static constexpr int KERNEL_HALF_WIDTH = 4;
+  static constexpr int KERNEL_OVERSAMPLING = 64;
+  static constexpr int KERNEL_BINS = 2 * KERNEL_HALF_WIDTH + 1;
+
+  AdditiveEngine() : fft(FFT_ORDER), slots(MAX_ADDITIVE_SLOTS) {
+    buildTables();
+    reset();
+  }
+
+  void reset() {
+    for (auto &slot : slots) {
+      slot.active = false;
+      slot.owner = -1;
+    }
+    numActiveSlots = 0;
+
+    overlap.fill(0.0f);
+    hopOutput.fill(0.0f);
+    hopPosition = HOP_SIZE;
+    overlapHasSignal = false;
+  }
+
+  // ========================================================================
+  // Slots (audio thread)
+  // ========================================================================
+
+  // Claims a free slot for an owner (any id >= 0), or cuts short a fading
+  // slot nobody owns any more; -1 if every slot is owned
+  int allocateSlot(int owner) {
+    int index = -1;
+    for (int s = 0; s < MAX_ADDITIVE_SLOTS && index < 0; ++s)
+      if (!slots[s].active)
+        index = s;
+
+    for (int s = 0; s < MAX_ADDITIVE_SLOTS && index < 0; ++s)
+      if (slots[s].owner < 0)
+        index = s;
+
+    if (index < 0)
+      return -1;
+
+    auto &slot = slots[index];
+    if (!slot.active)
+      ++numActiveSlots;
+    slot.active = true;
+    slot.owner = owner;
+    slot.level = 0.0f;
+    slot.levelStep = 0.0f;
+    slot.numPartials = 0; // silent until started
+    return index;
+  }
+
+  int getSlotOwner(int index) const {
+    return slots[index].active ? slots[index].owner : -1;
+  }
+
+  void startVoice(int index, const AdditivePatch &patch,
+                  double cyclesPerSample, float velocity, double sampleRate) {
+    auto &slot = slots[index];
+    if (!slot.active)
+      return;
+
+    const float cps = static_cast<float>(cyclesPerSample);
+    const float maxBin =
+        static_cast<float>(NUM_BINS - 1 - KERNEL_HALF_WIDTH - 1);
+    const int requested = juce::jlimit(1, MAX_PARTIALS, patch.numPartials);
+
+    // Ratios rise with k, so the first partial past Nyquist ends the list
+    int count = 0;
+    double energy = 0.0;
+    for (int k = 1; k <= requested; ++k) {
+      const float ratio = static_cast<float>(k) *
+                          std::sqrt(1.0f + patch.inharmonicity * k * k);
+      if (ratio * cps * FRAME_SIZE > maxBin)
+        break;
+
+      const float weight = (k % 2 == 0) ? patch.evenLevel : 1.0f;
+      const float amplitude =
+          weight / std::pow(static_cast<float>(k), patch.rolloff);
+
+      slot.ratio[count] = ratio;
+      slot.baseAmplitude[count] = amplitude;
+      slot.phase[count] = 0.0f;
+      energy += static_cast<double>(amplitude) * amplitude;
+      ++count;
+    }
+
+    // Normalized to the power of a single full-scale sine
+    slot.gain = energy > 0.0
+                    ? velocity * VOICE_LEVEL_SCALE /
+                          static_cast<float>(std::sqrt(energy))
+                    : 0.0f;
+    slot.numPartials = count;
+    slot.cyclesPerSample = cps;
+    slot.sweepPhase = 0.0f;
+    slot.sweepIncrement =
+        static_cast<float>(patch.evolveRate * HOP_SIZE / sampleRate);
+    slot.evolveDepth = juce::jlimit(0.0f, 1.0f, patch.evolveDepth);
+
+    slot.level = 0.0f;
+    slot.levelStep = hopsToStep(patch.attack, sampleRate);
+    slot.releaseStep = hopsToStep(patch.release, sampleRate);
+  }
+
+  void releaseVoice(int index) {
+    auto &slot = slots[index];
+    if (slot.active)
+      slot.levelStep = -slot.releaseStep;
+  }
+
+  // Fades out over one hop and detaches the owner; the slot frees itself
+  void fadeOutVoice(int index) {
+    auto &slot = slots[index];
+    if (!slot.active)
+      return;
+    slot.levelStep = -1.0f;
+    slot.owner = -1;
+  }
+
+  float getVoiceLevel(int index) const {
+    return slots[index].active ? slots[index].level : 0.0f;
+  }
+
+  int getNumActiveVoices() const { return numActiveSlots; }
+
+  // ========================================================================
+  // Rendering (audio thread): adds the mono output to every channel
+  // ========================================================================
+  void render(juce::AudioBuffer<float> &buffer, int startSample,
+              int numSamples) {
+    while (numSamples > 0) {
+      if (hopPosition == HOP_SIZE) {
+        if (numActiveSlots == 0 && !overlapHasSignal)
+          return;
+        synthesizeHop();
+        hopPosition = 0;
+      }
+
+      const int n = juce::jmin(numSamples, HOP_SIZE - hopPosition);
+      for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+        juce::FloatVectorOperations::add(
+            buffer.getWritePointer(ch, startSample),
+            hopOutput.data() + hopPosition, n);
+
+      hopPosition += n;
+      startSample += n;
+      numSamples -= n;
+    }
+  }
+
+private:
+  using Complex = std::complex<float>;
+
+  struct Slot {
+    std::array<float, MAX_PARTIALS> ratio{};
+    std::array<float, MAX_PARTIALS> baseAmplitude{};
+    std::array<float, MAX_PARTIALS> phase{}; // cycles, at the frame centre
+    int numPartials = 0;
+    int owner = -1;
+    bool active = false;
+
+    float cyclesPerSample = 0.0f;
+    float gain = 0.0f;
+    float level = 0.0f;
+    float levelStep = 0.0f; // per hop: attack > 0, release < 0
+    float releaseStep = 0.0f;
+    float sweepPhase = 0.0f;
+    float sweepIncrement = 0.0f;
+    float evolveDepth = 0.0f;
+  };
+
+  static float hopsToStep(float seconds, double sampleRate) {
+    const double hops = seconds * sampleRate / HOP_SIZE;
+    return hops > 1.0 ? static_cast<float>(1.0 / hops) : 1.0f;
+  }
+
+  void synthesizeHop() {
+    std::fill(spectrum.begin(), spectrum.end(), Complex());
+
+    bool anySignal = false;
+    for (int s = 0; s < MAX_ADDITIVE_SLOTS; ++s) {
+      auto &slot = slots[s];
+      if (!slot.active)
+        continue;
+
+      slot.level = juce::jlimit(0.0f, 1.0f, slot.level + slot.levelStep);
+      if (slot.level <= 0.0f && slot.levelStep < 0.0f) {
+        slot.active = false;
+        slot.owner = -1;
+        --numActiveSlots;
+        continue;
+      }
+
+      addSlotPartials(slot);
+      anySignal = true;
+    }
+
+    // Partials are already summed, so one inverse transform covers them all
+    float *frame = reinterpret_cast<float *>(spectrum.data());
+    fft.inverseReal(spectrum.data(), frame);
+
+    // The frame's centre 2 * HOP_SIZE samples, reshaped to a triangle
+    const float *centre = frame + FRAME_SIZE / 2 - HOP_SIZE;
+    for (int i = 0; i < HOP_SIZE; ++i) {
+      hopOutput[i] = overlap[i] + centre[i] * synthesisWindow[i];
+      overlap[i] = centre[HOP_SIZE + i] * synthesisWindow[HOP_SIZE + i];
+    }
+    overlapHasSignal = anySignal;
+  }
+
+  void addSlotPartials(Slot &slot) {
+    const int count = slot.numPartials;
+    const float scale = slot.gain * slot.level;
+    const float depth = slot.evolveDepth;
+    const float binsPerRatio = slot.cyclesPerSample * FRAME_SIZE;
+    const float cyclesPerHop = slot.cyclesPerSample * HOP_SIZE;
+
+    // Vectorizable passes first: amplitudes, then centre phases, ...
+    for (int k = 0; k < count; ++k) {
+      const float sweep = FastMath::sinCycle(FastMath::wrapPhaseFull(
+          slot.sweepPhase + static_cast<float>(k) * EVOLVE_SPACING));
+      amplitudes[k] = slot.baseAmplitude[k] * scale *
+                      (1.0f - depth * (0.5f + 0.5f * sweep));
+      rotations[k] = Complex(FastMath::cosCycle(slot.phase[k]),
+                             FastMath::sinCycle(slot.phase[k]));
+    }
+
+    // ... then the scatter into the spectrum
+    for (int k = 0; k < count; ++k)
+      addPartial(slot.ratio[k] * binsPerRatio, amplitudes[k] * rotations[k]);
+
+    for (int k = 0; k < count; ++k)
+      slot.phase[k] = FastMath::wrapPhaseFull(slot.phase[k] +
+                                              slot.ratio[k] * cyclesPerHop);
+    slot.sweepPhase =
+        FastMath::wrapPhaseFull(slot.sweepPhase + slot.sweepIncrement);
+  }
+
+  // A sinusoid of amplitude |a| and phase arg(a) at the frame centre,
+  // `position` bins up: KERNEL_BINS bins starting at the first one inside
+  // the main lobe (the kernel table is zero past its edge)
+  void addPartial(float position, Complex a) {
+    const int first =
+        static_cast<int>(std::ceil(position)) - KERNEL_HALF_WIDTH;
+    const float offset =
+        (position - static_cast<float>(first)) * KERNEL_OVERSAMPLING;
+
+    // (-1)^b moves the phase reference from sample 0 to the centre
+    Complex c = a * ((first & 1) != 0 ? -0.5f : 0.5f);
+
+    if (first > 0) {
+      Complex *bins = spectrum.data() + first;
+      for (int j = 0; j < KERNEL_BINS; ++j) {
+        bins[j] += c * kernelAt(offset - j * KERNEL_OVERSAMPLING);
+        c = -c;
+      }
+      return;
+    }
+
+    // Low partials: bins below zero belong to the negative frequency image
+    // and fold back conjugated; DC takes both halves' real parts
+    for (int j = 0; j < KERNEL_BINS; ++j) {
+      const int b = first + j;
+      const Complex v = c * kernelAt(offset - j * KERNEL_OVERSAMPLING);
+      if (b > 0)
+        spectrum[b] += v;
+      else if (b < 0)
+        spectrum[-b] += std::conj(v);
+      else
+        spectrum[0] += 2.0f * v.real();
+      c = -c;
+    }
+  }
+
+  // Window transform at a distance in table steps (either sign)
+  float kernelAt(float distance) const {
+    const float d = std::abs(distance);
+    const int i = static_cast<int>(d);
+    return kernel[i] +
+           (d - static_cast<float>(i)) * (kernel[i + 1] - kernel[i]);
+  }
+
+  void buildTables() {
+    const double pi = juce::MathConstants<double>::pi;
+    std::array<double, FRAME_SIZE> window{};
+    for (int n = 0; n < FRAME_SIZE; ++n) {
+      const double x = 2.0 * pi * n / FRAME_SIZE;
+      window[n] = 0.35875 - 0.48829 * std::cos(x) + 0.14128 * std::cos(2 * x) -
+                  0.01168 * std::cos(3 * x);
+    }
+
+    // Window transform around the frame centre (real: the window is even)
+    for (size_t i = 0; i < kernel.size(); ++i) {
+      const double offset = static_cast<double>(i) / KERNEL_OVERSAMPLING;
+      double sum = 0.0;
+      if (offset <= KERNEL_HALF_WIDTH)
+        for (int n = 0; n < FRAME_SIZE; ++n)
+          sum += window[n] *
+                 std::cos(2.0 * pi * offset * (n - FRAME_SIZE / 2) /
+                          FRAME_SIZE);
+      kernel[i] = static_cast<float>(sum);
+    }
+
+    // Triangles over 2 * HOP_SIZE sum to one at HOP_SIZE spacing
+    for (int i = 0; i < 2 * HOP_SIZE; ++i) {
+      const int n = FRAME_SIZE / 2 - HOP_SIZE + i;
+      const double triangle =
+          1.0 - std::abs(static_cast<double>(i - HOP_SIZE)) / HOP_SIZE;
+      synthesisWindow[i] = static_cast<float>(triangle / window[n]);
+    }
+  }
+
+  // Spacing of the spectral sweep between neighbouring partials, cycles
+  static constexpr float EVOLVE_SPACING = 0.0618034f;
+
+  const FFT<float> fft;
+  std::vector<Slot> slots;
+  int numActiveSlots = 0;
+
+  std::array<Complex, NUM_BINS> spectrum{};
+  std::array<float, (KERNEL_HALF_WIDTH + 1) * KERNEL_OVERSAMPLING + 2>
+      kernel{};
+  std::array<float, 2 * HOP_SIZE> synthesisWindow{};
+  alignas(SIMD_ALIGNMENT) std::array<float, MAX_PARTIALS> amplitudes{};
+  alignas(SIMD_ALIGNMENT) std::array<Complex, MAX_PARTIALS> rotations{};
+
+  std::array<float, HOP_SIZE> overlap{};
+  std::array<float, HOP_SIZE> hopOutput{};
+  int hopPosition = HOP_SIZE;
+  bool overlapHasSignal = false;
+};
+
+// ============================================================================
+// Additive Voice
+// ============================================================================
+class AdditiveVoice final : public juce::SynthesiserVoice {
+public:
+  AdditiveVoice(AdditiveEngine &engineToUse, int voiceIndex)
+      : engine(engineToUse), ownerId(voiceIndex) {}
+
+  bool canPlaySound(juce::SynthesiserSound *sound) override {
+    return dynamic_cast<const AdditiveSound *>(sound) != nullptr;
+  }
+
+  void startNote(int midiNoteNumber, float velocity,
+                 juce::SynthesiserSound *s,
+                 int /*currentPitchWheelPosition*/) override {
+    detachSlot();
+
+    auto *sound = dynamic_cast<const AdditiveSound *>(s);
+    slot = sound != nullptr ? engine.allocateSlot(ownerId) : -1;
+    if (slot < 0) {
+      clearCurrentNote();
+      return;
+    }
+
+    const double cyclesPerSample =
+        juce::MidiMessage::getMidiNoteInHertz(midiNoteNumber) /
+        getSampleRate();
+    engine.startVoice(slot, sound->getPatch(), cyclesPerSample, velocity,
+                      getSampleRate());
+  }
+
+  void stopNote(float /*velocity*/, bool allowTailOff) override {
+    if (allowTailOff) {
+      if (ownsSlot())
+        engine.releaseVoice(slot);
+    } else {
+      detachSlot();
+      clearCurrentNote();
+    }
+  }
+
+  float getCurrentLevel() const {
+    return ownsSlot() ? engine.getVoiceLevel(slot) : 0.0f;
+  }
+
+  void pitchWheelMoved(int /*newValue*/) override {}
+  void controllerMoved(int /*controllerNumber*/, int /*newValue*/) override {}
+
+  // Audio was already rendered by the engine; only notice a freed slot here
+  void renderNextBlock(juce::AudioBuffer<float> & /*outputBuffer*/,
+                       int /*startSample*/, int /*numSamples*/) override {
+    if (isVoiceActive() && !ownsSlot()) {
+      slot = -1;
+      clearCurrentNote();
+    }
+  }
+
+  using SynthesiserVoice::renderNextBlock;
+
+private:
+  bool ownsSlot() const {
+    return slot >= 0 && engine.getSlotOwner(slot) == ownerId;
+  }
+
+  void detachSlot() {
+    if (ownsSlot())
+      engine.fadeOutVoice(slot);
+    slot = -1;
+  }
+
+  AdditiveEngine &engine;
+  const int ownerId;
+  int slot = -1;
+};
+
+} // namespace Synth
+} // namespace Sphere
@@ -0,0 +1,587 @@
+/*
+  ==============================================================================
+    SphereFMBank.h
+    Structure-of-arrays bank of 4-6 operator FM (phase modulation) voices
+
+    Operator routings are constexpr tables; every algorithm is instantiated
+    as its own render kernel, so the modulation graph is resolved at compile
+    time and the per-sample loop is straight-line code over VOICE_LANES
+    voices. Sines come from FastMath::sinCycle, never std::sin.
+
+    A lane group only ever holds voices of one algorithm: slots are handed
+    out from a group already running the requested algorithm, or from an
+    empty group which then adopts it. Operator envelopes are one-pole
+    segments evaluated per sample; stage changes and culling happen at
+    control rate, every CONTROL_INTERVAL samples.
+
+    Like the OscillatorBank, groups render in parallel on an optional
+    RealtimeWorkerPool into their own buffers and are summed in group
+    order, so the output does not depend on the number of threads.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../Common/SphereFastMath.h"
+#include "../Common/SphereWorkerPool.h"
+#include "SphereSynthTypes.h"
+#include <cmath>
+#include <vector>
+
+namespace Sphere {
+namespace Synth {
+
+constexpr int MAX_FM_OPERATORS = 6;
+constexpr int MAX_FM_VOICES = MAX_POOL_VOICES;
+constexpr int MAX_FM_GROUPS = MAX_FM_VOICES / VOICE_LANES;
+
+// ============================================================================
+// Algorithms (operator 0 is always a carrier; arrows point at the operator
+// being modulated)
+// ============================================================================
+enum class FMAlgorithm : int {
+  FourOpStack,         // 3 > 2 > 1 > 0
+  FourOpBranch,        // 3 > 1, 2 > 1, 1 > 0
+  FourOpTwoStacks,     // 3 > 2, 1 > 0
+  FourOpThreeCarriers, // 3 > 0, 3 > 1, 3 > 2
+  FourOpAdditive,      // four carriers
+  SixOpStack,          // 5 > 4 > 3 > 2 > 1 > 0
+  SixOpTwoStacks,      // 5 > 4 > 3, 2 > 1 > 0
+  SixOpThreeStacks,    // 5 > 4, 3 > 2, 1 > 0
+  NumAlgorithms
+};
+
+struct FMRouting {
+  int numOperators;
+  // Bit m of modulators[op] set: operator m modulates op (always m > op)
+  std::array<uint8_t, MAX_FM_OPERATORS> modulators;
+  uint8_t carriers;
+  int feedbackOperator; // modulates itself
+};
+
+constexpr std::array<FMRouting,
+                     static_cast<size_t>(FMAlgorithm::NumAlgorithms)>
+    FM_ROUTINGS = {{
+        {4, {1 << 1, 1 << 2, 1 << 3, 0, 0, 0}, 0b0001, 3},
+        {4, {1 << 1, (1 << 2) | (1 << 3), 0, 0, 0, 0}, 0b0001, 3},
+        {4, {1 << 1, 0, 1 << 3, 0, 0, 0}, 0b0101, 3},
+        {4, {1 << 3, 1 << 3, 1 << 3, 0, 0, 0}, 0b0111, 3},
+        {4, {0, 0, 0, 0, 0, 0}, 0b1111, 3},
+        {6, {1 << 1, 1 << 2, 1 << 3, 1 << 4, 1 << 5, 0}, 0b000001, 5},
+        {6, {1 << 1, 1 << 2, 0, 1 << 4, 1 << 5, 0}, 0b001001, 5},
+        {6, {1 << 1, 0, 1 << 3, 0, 1 << 5, 0}, 0b010101, 5},
+    }};
+
+// ============================================================================
+// Patch
+// ============================================================================
+struct FMOperatorParams {
+  float ratio = 1.0f;  // frequency as a multiple of the note frequency
+  float level = 1.0f;  // carrier: output gain; modulator: index in cycles
+  float attack = 0.005f; // seconds to full level
+  float decay = 0.3f;    // time constant towards sustain, seconds
+  float sustain = 1.0f;
+  float release = 0.3f; // time constant towards silence, seconds
+};
+
+struct FMPatch {
+  FMAlgorithm algorithm = FMAlgorithm::FourOpStack;
+  std::array<FMOperatorParams, MAX_FM_OPERATORS> operators{};
+  float feedback = 0.0f; // feedback operator's self-modulation, cycles
+};
+
+// ============================================================================
+// FM Bank
+// ============================================================================
+class FMBank {
+public:
+  static constexpr int CONTROL_INTERVAL = 32;
+
+  FMBank() { reset(); }
+
+  // ========================================================================
+  // Setup (message thread, before playback)
+  // ========================================================================
+  void prepare(int maxBlockSize) {
+    this->maxBlockSize = juce::jmax(1, maxBlockSize);
+    groupMix.assign(static_cast<size_t>(this->maxBlockSize) * MAX_FM_GROUPS,
+                    0.0f);
+    monoMix.assign(static_cast<size_t>(this->maxBlockSize), 0.0f);
+    reset();
+  }
+
+  // Optional; nullptr renders every group on the calling thread
+  void setWorkerPool(RealtimeWorkerPool *poolToUse) { workerPool = poolToUse; }
+
+  void reset() {
+    for (int slot = 0; slot < MAX_FM_VOICES; ++slot)
+      clearSlot(slot);
+
+    groupActiveCount.fill(0);
+    groupAlgorithm.fill(-1);
+    numActiveVoices = 0;
+  }
+
+  // ========================================================================
+  // Slot allocation (audio thread)
+  // ========================================================================
+
+  // Claims a silent slot in a group running the algorithm (or an empty
+  // group); -1 if there is none
+  int allocateSlot(int owner, FMAlgorithm algorithm) {
+    const int algo = static_cast<int>(algorithm);
+    int slot = -1;
+
+    for (int g = 0; g < MAX_FM_GROUPS && slot < 0; ++g)
+      if (groupAlgorithm[g] == algo)
+        slot = findFreeLane(g);
+
+    for (int g = 0; g < MAX_FM_GROUPS && slot < 0; ++g)
+      if (groupActiveCount[g] == 0)
+        slot = g * VOICE_LANES;
+
+    // Out of slots: cut short a fading slot nobody owns any more
+    for (int s = 0; s < MAX_FM_VOICES && slot < 0; ++s) {
+      if (active[s] != 0 && owners[s] < 0 &&
+          groupAlgorithm[s / VOICE_LANES] == algo) {
+        killVoice(s);
+        slot = s;
+      }
+    }
+
+    if (slot < 0)
+      return -1;
+
+    groupAlgorithm[slot / VOICE_LANES] = algo;
+    setActive(slot, true);
+    owners[slot] = owner;
+    return slot;
+  }
+
+  int getSlotOwner(int slot) const {
+    return isVoiceActive(slot) ? owners[slot] : -1;
+  }
+
+  // ========================================================================
+  // Voice control (audio thread)
+  // ========================================================================
+
+  // The slot must have been allocated for patch.algorithm
+  void startVoice(int slot, const FMPatch &patch, double cyclesPerSample,
+                  float velocity, double sampleRate) {
+    if (!isVoiceActive(slot))
+      return;
+
+    const auto &routing = FM_ROUTINGS[static_cast<size_t>(patch.algorithm)];
+    for (int op = 0; op < MAX_FM_OPERATORS; ++op) {
+      const auto &params = patch.operators[static_cast<size_t>(op)];
+      const bool used = op < routing.numOperators;
+
+      phase[op][slot] = 0.0f;
+      increment[op][slot] = static_cast<float>(
+          juce::jmin(0.5, cyclesPerSample * params.ratio));
+      opLevel[op][slot] = used ? params.level : 0.0f;
+      envelope[op][slot] = 0.0f;
+
+      // Attack heads for 1.5 and is clamped at 1, reaching it in `attack`
+      // seconds (1.5 * (1 - e^-t/tau) = 1 at t = tau * ln 3)
+      attackCoeff[op][slot] =
+          timeToCoeff(params.attack / std::log(3.0f), sampleRate);
+      decayCoeff[op][slot] = timeToCoeff(params.decay, sampleRate);
+      releaseCoeff[op][slot] = timeToCoeff(params.release, sampleRate);
+      sustainLevel[op][slot] = juce::jlimit(0.0f, 1.0f, params.sustain);
+
+      envTarget[op][slot] = 1.5f;
+      envCoeff[op][slot] = attackCoeff[op][slot];
+      stage[op][slot] = Attack;
+    }
+
+    feedbackAmount[slot] = patch.feedback;
+    feedback1[slot] = 0.0f;
+    feedback2[slot] = 0.0f;
+    level[slot] = velocity * VOICE_LEVEL_SCALE;
+  }
+
+  // Moves every operator to its release segment
+  void releaseVoice(int slot) {
+    if (!isVoiceActive(slot))
+      return;
+
+    for (int op = 0; op < MAX_FM_OPERATORS; ++op)
+      enterStage(op, slot, Release, 0.0f, releaseCoeff[op][slot]);
+  }
+
+  // Fast fade for a stolen voice; the slot frees itself once silent
+  void fadeOutVoice(int slot) {
+    if (!isVoiceActive(slot))
+      return;
+
+    for (int op = 0; op < MAX_FM_OPERATORS; ++op)
+      enterStage(op, slot, Release, 0.0f, 1.0f - STEAL_FADE_COEFF);
+    owners[slot] = -1;
+  }
+
+  void killVoice(int slot) {
+    if (slot < 0 || slot >= MAX_FM_VOICES)
+      return;
+
+    setActive(slot, false);
+    clearSlot(slot);
+  }
+
+  bool isVoiceActive(int slot) const {
+    return slot >= 0 && slot < MAX_FM_VOICES && active[slot] != 0;
+  }
+
+  int getNumActiveVoices() const { return numActiveVoices; }
+
+  // Loudest carrier envelope times the voice gain
+  float getVoiceLevel(int slot) const {
+    if (!isVoiceActive(slot))
+      return 0.0f;
+
+    const auto &routing = getRouting(slot);
+    float loudest = 0.0f;
+    for (int op = 0; op < routing.numOperators; ++op)
+      if ((routing.carriers >> op) & 1)
+        loudest = juce::jmax(loudest, envelope[op][slot]);
+    return loudest * level[slot];
+  }
+
+  // ========================================================================
+  // Render all active voices and add them to every channel of the buffer
+  // ========================================================================
+  void render(juce::AudioBuffer<float> &buffer, int startSample,
+              int numSamples) {
+    if (numActiveVoices == 0 || monoMix.empty())
+      return;
+
+    while (numSamples > 0) {
+      const int chunk = juce::jmin(numSamples, maxBlockSize);
+      renderChunk(buffer, startSample, chunk);
+      startSample += chunk;
+      numSamples -= chunk;
+    }
+  }
+
+private:
+  enum Stage : int32_t { Attack, Decay, Release };
+
+  void renderChunk(juce::AudioBuffer<float> &buffer, int startSample,
+                   int numSamples) {
+    numRenderGroups = 0;
+    for (int g = 0; g < MAX_FM_GROUPS; ++g)
+      if (groupActiveCount[g] != 0)
+        renderGroups[numRenderGroups++] = g;
+
+    chunkSamples = numSamples;
+    if (workerPool != nullptr)
+      workerPool->run(numRenderGroups, &renderGroupTask, this);
+    else
+      for (int t = 0; t < numRenderGroups; ++t)
+        renderGroupTask(this, t, 0);
+
+    // Fixed-order mixdown, then culling (touches shared counters)
+    juce::FloatVectorOperations::clear(monoMix.data(), numSamples);
+    for (int t = 0; t < numRenderGroups; ++t) {
+      const int g = renderGroups[t];
+      juce::FloatVectorOperations::add(monoMix.data(), getGroupMix(g),
+                                       numSamples);
+      cullGroup(g);
+    }
+
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+      juce::FloatVectorOperations::add(buffer.getWritePointer(ch, startSample),
+                                       monoMix.data(), numSamples);
+  }
+
+  static void renderGroupTask(void *context, int taskIndex,
+                              int /*workerIndex*/) {
+    auto &bank = *static_cast<FMBank *>(context);
+    const int g = bank.renderGroups[taskIndex];
+    float *out = bank.getGroupMix(g);
+
+    for (int done = 0; done < bank.chunkSamples; done += CONTROL_INTERVAL) {
+      const int n = juce::jmin(CONTROL_INTERVAL, bank.chunkSamples - done);
+      bank.renderGroupForAlgorithm(g, out + done, n);
+      bank.updateEnvelopeStages(g);
+    }
+  }
+
+  float *getGroupMix(int g) {
+    return groupMix.data() + static_cast<size_t>(g) * maxBlockSize;
+  }
+
+  void renderGroupForAlgorithm(int g, float *out, int numSamples) {
+    switch (static_cast<FMAlgorithm>(groupAlgorithm[g])) {
+    case FMAlgorithm::FourOpStack:
+      renderGroup<FMAlgorithm::FourOpStack>(g, out, numSamples);
+      break;
+    case FMAlgorithm::FourOpBranch:
+      renderGroup<FMAlgorithm::FourOpBranch>(g, out, numSamples);
+      break;
+    case FMAlgorithm::FourOpTwoStacks:
+      renderGroup<FMAlgorithm::FourOpTwoStacks>(g, out, numSamples);
+      break;
+    case FMAlgorithm::FourOpThreeCarriers:
+      renderGroup<FMAlgorithm::FourOpThreeCarriers>(g, out, numSamples);
+      break;
+    case FMAlgorithm::FourOpAdditive:
+      renderGroup<FMAlgorithm::FourOpAdditive>(g, out, numSamples);
+      break;
+    case FMAlgorithm::SixOpStack:
+      renderGroup<FMAlgorithm::SixOpStack>(g, out, numSamples);
+      break;
+    case FMAlgorithm::SixOpTwoStacks:
+      renderGroup<FMAlgorithm::SixOpTwoStacks>(g, out, numSamples);
+      break;
+    case FMAlgorithm::SixOpThreeStacks:
+      renderGroup<FMAlgorithm::SixOpThreeStacks>(g, out, numSamples);
+      break;
+    default:
+      juce::FloatVectorOperations::clear(out, numSamples);
+      break;
+    }
+  }
+
+  // The routing is a compile-time constant, so the operator loops unroll
+  // and the modulator tests fold away
+  template <FMAlgorithm Algorithm>
+  void renderGroup(int g, float *out, int numSamples) {
+    constexpr FMRouting routing = FM_ROUTINGS[static_cast<size_t>(Algorithm)];
+    constexpr int numOps = routing.numOperators;
+    constexpr int fbOp = routing.feedbackOperator;
+
+    alignas(SIMD_ALIGNMENT) float p[numOps][VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float inc[numOps][VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float amp[numOps][VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float env[numOps][VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float target[numOps][VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float coeff[numOps][VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float fb1[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float fb2[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float fbAmount[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float gain[VOICE_LANES];
+
+    const int base = g * VOICE_LANES;
+    for (int op = 0; op < numOps; ++op) {
+      for (int l = 0; l < VOICE_LANES; ++l) {
+        p[op][l] = phase[op][base + l];
+        inc[op][l] = increment[op][base + l];
+        amp[op][l] = opLevel[op][base + l];
+        env[op][l] = envelope[op][base + l];
+        target[op][l] = envTarget[op][base + l];
+        coeff[op][l] = envCoeff[op][base + l];
+      }
+    }
+    for (int l = 0; l < VOICE_LANES; ++l) {
+      fb1[l] = feedback1[base + l];
+      fb2[l] = feedback2[base + l];
+      fbAmount[l] = feedbackAmount[base + l];
+      gain[l] = level[base + l];
+    }
+
+    for (int i = 0; i < numSamples; ++i) {
+      alignas(SIMD_ALIGNMENT) float opOut[numOps][VOICE_LANES];
+
+      // Modulators have higher indices, so they are always evaluated first
+      for (int op = numOps - 1; op >= 0; --op) {
+        for (int l = 0; l < VOICE_LANES; ++l) {
+          float mod = 0.0f;
+          for (int m = op + 1; m < numOps; ++m)
+            if ((routing.modulators[op] >> m) & 1)
+              mod += opOut[m][l];
+
+          // Averaging the last two outputs tames feedback oscillation
+          if (op == fbOp)
+            mod += 0.5f * (fb1[l] + fb2[l]) * fbAmount[l];
+
+          const float e = juce::jmin(
+              1.0f, env[op][l] + (target[op][l] - env[op][l]) * coeff[op][l]);
+          env[op][l] = e;
+
+          opOut[op][l] =
+              FastMath::sinCycle(FastMath::wrapPhaseFull(p[op][l] + mod)) *
+              amp[op][l] * e;
+          p[op][l] = FastMath::wrapPhase(p[op][l] + inc[op][l]);
+        }
+      }
+
+      alignas(SIMD_ALIGNMENT) float mix[VOICE_LANES];
+      for (int l = 0; l < VOICE_LANES; ++l) {
+        fb2[l] = fb1[l];
+        fb1[l] = opOut[fbOp][l];
+
+        float sum = 0.0f;
+        for (int op = 0; op < numOps; ++op)
+          if ((routing.carriers >> op) & 1)
+            sum += opOut[op][l];
+        mix[l] = sum * gain[l];
+      }
+
+      float total = 0.0f;
+      for (int l = 0; l < VOICE_LANES; ++l)
+        total += mix[l];
+      out[i] = total;
+    }
+
+    for (int op = 0; op < numOps; ++op) {
+      for (int l = 0; l < VOICE_LANES; ++l) {
+        phase[op][base + l] = p[op][l];
+        envelope[op][base + l] = env[op][l];
+      }
+    }
+    for (int l = 0; l < VOICE_LANES; ++l) {
+      feedback1[base + l] = fb1[l];
+      feedback2[base + l] = fb2[l];
+    }
+  }
+
+  // Control rate: attack -> decay once full level is reached
+  void updateEnvelopeStages(int g) {
+    const int base = g * VOICE_LANES;
+    const int numOps = FM_ROUTINGS[static_cast<size_t>(groupAlgorithm[g])]
+                           .numOperators;
+
+    for (int l = 0; l < VOICE_LANES; ++l) {
+      const int slot = base + l;
+      if (active[slot] == 0)
+        continue;
+
+      for (int op = 0; op < numOps; ++op)
+        if (stage[op][slot] == Attack && envelope[op][slot] >= 1.0f)
+          enterStage(op, slot, Decay, sustainLevel[op][slot],
+                     decayCoeff[op][slot]);
+    }
+  }
+
+  // A voice is finished once every carrier has decayed to silence and
+  // can't come back (released, or decaying towards a silent sustain)
+  void cullGroup(int g) {
+    const int base = g * VOICE_LANES;
+    const auto &routing = FM_ROUTINGS[static_cast<size_t>(groupAlgorithm[g])];
+
+    for (int l = 0; l < VOICE_LANES; ++l) {
+      const int slot = base + l;
+      if (active[slot] == 0)
+        continue;
+
+      bool silent = true;
+      for (int op = 0; op < routing.numOperators && silent; ++op) {
+        if (((routing.carriers >> op) & 1) == 0)
+          continue;
+        silent = stage[op][slot] != Attack &&
+                 envelope[op][slot] < FM_TAIL_CUTOFF &&
+                 envTarget[op][slot] < FM_TAIL_CUTOFF;
+      }
+
+      if (silent)
+        killVoice(slot);
+    }
+
+    if (groupActiveCount[g] == 0)
+      groupAlgorithm[g] = -1;
+  }
+
+  void enterStage(int op, int slot, Stage newStage, float newTarget,
+                  float newCoeff) {
+    stage[op][slot] = newStage;
+    envTarget[op][slot] = newTarget;
+    envCoeff[op][slot] = newCoeff;
+  }
+
+  const FMRouting &getRouting(int slot) const {
+    const int algo = juce::jmax(0, groupAlgorithm[slot / VOICE_LANES]);
+    return FM_ROUTINGS[static_cast<size_t>(algo)];
+  }
+
+  int findFreeLane(int g) const {
+    for (int l = 0; l < VOICE_LANES; ++l)
+      if (active[g * VOICE_LANES + l] == 0)
+        return g * VOICE_LANES + l;
+    return -1;
+  }
+
+  static float timeToCoeff(float seconds, double sampleRate) {
+    const double samples = juce::jmax(1.0, seconds * sampleRate);
+    return static_cast<float>(1.0 - std::exp(-1.0 / samples));
+  }
+
+  void setActive(int slot, bool shouldBeActive) {
+    const bool wasActive = active[slot] != 0;
+    if (wasActive == shouldBeActive)
+      return;
+
+    active[slot] = shouldBeActive ? 1 : 0;
+    const int delta = shouldBeActive ? 1 : -1;
+    groupActiveCount[slot / VOICE_LANES] += delta;
+    numActiveVoices += delta;
+  }
+
+  // Idle lanes still run through the kernels, so keep them silent
+  void clearSlot(int slot) {
+    for (int op = 0; op < MAX_FM_OPERATORS; ++op) {
+      phase[op][slot] = 0.0f;
+      increment[op][slot] = 0.0f;
+      opLevel[op][slot] = 0.0f;
+      envelope[op][slot] = 0.0f;
+      envTarget[op][slot] = 0.0f;
+      envCoeff[op][slot] = 0.0f;
+      attackCoeff[op][slot] = 0.0f;
+      decayCoeff[op][slot] = 0.0f;
+      releaseCoeff[op][slot] = 0.0f;
+      sustainLevel[op][slot] = 0.0f;
+      stage[op][slot] = Release;
+    }
+
+    feedbackAmount[slot] = 0.0f;
+    feedback1[slot] = 0.0f;
+    feedback2[slot] = 0.0f;
+    level[slot] = 0.0f;
+    active[slot] = 0;
+    owners[slot] = -1;
+  }
+
+  // Below this a released carrier is inaudible
+  static constexpr float FM_TAIL_CUTOFF = 1.0e-4f;
+
+  // Operator state, [operator][slot]
+  using OperatorArray = std::array<VoiceLaneArray, MAX_FM_OPERATORS>;
+  OperatorArray phase;
+  OperatorArray increment;
+  OperatorArray opLevel;
+  OperatorArray envelope;
+  OperatorArray envTarget;
+  OperatorArray envCoeff;
+  OperatorArray attackCoeff;
+  OperatorArray decayCoeff;
+  OperatorArray releaseCoeff;
+  OperatorArray sustainLevel;
+  std::array<std::array<int32_t, MAX_FM_VOICES>, MAX_FM_OPERATORS> stage{};
+
+  // Voice state
+  VoiceLaneArray feedbackAmount;
+  VoiceLaneArray feedback1;
+  VoiceLaneArray feedback2;
+  VoiceLaneArray level;
+  std::array<uint8_t, MAX_FM_VOICES> active{};
+  std::array<int, MAX_FM_VOICES> owners{};
+
+  std::array<int, MAX_FM_GROUPS> groupActiveCount{};
+  std::array<int, MAX_FM_GROUPS> groupAlgorithm{};
+  int numActiveVoices = 0;
+
+  // Scratch (allocated in prepare)
+  std::vector<float> groupMix; // [group][sample]
+  std::vector<float> monoMix;
+  int maxBlockSize = 0;
+
+  // Current chunk's work list, read by the group tasks
+  std::array<int, MAX_FM_GROUPS> renderGroups{};
+  int numRenderGroups = 0;
+  int chunkSamples = 0;
+  RealtimeWorkerPool *workerPool = nullptr;
+};
+
+} // namespace Synth
+} // namespace Sphere
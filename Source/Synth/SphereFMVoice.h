@@ -0,0 +1,140 @@
+/*
+  ==============================================================================
+    SphereFMVoice.h
+    FM sound and voice playing through the shared FMBank
+
+    Like OscillatorVoice, the voice holds no DSP state of its own: it claims
+    a bank slot for its patch's algorithm at note-on and leaves rendering to
+    the bank, which SphereSynthesiser renders once per block.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "SphereFMBank.h"
+
+namespace Sphere {
+namespace Synth {
+
+// ============================================================================
+// FM Sound (immutable patch)
+// ============================================================================
+class FMSound final : public juce::SynthesiserSound {
+public:
+  explicit FMSound(const FMPatch &patchToPlay) : patch(patchToPlay) {}
+
+  bool appliesToNote(int /*midiNoteNumber*/) override { return true; }
+  bool appliesToChannel(int /*midiChannel*/) override { return true; }
+
+  const FMPatch &getPatch() const { return patch; }
+
+  // A playable starting point for every algorithm: modulators at integer
+  // ratios with decaying indices, carriers with a gentle organ envelope
+  static FMPatch createDefaultPatch(FMAlgorithm algorithm) {
+    FMPatch p;
+    p.algorithm = algorithm;
+    p.feedback = 0.1f;
+
+    const auto &routing = FM_ROUTINGS[static_cast<size_t>(algorithm)];
+    for (int op = 0; op < routing.numOperators; ++op) {
+      auto &params = p.operators[static_cast<size_t>(op)];
+      const bool carrier = ((routing.carriers >> op) & 1) != 0;
+
+      params.ratio = carrier ? 1.0f : static_cast<float>(op + 1);
+      params.level = carrier ? 1.0f / routing.numOperators : 0.8f / op;
+      params.attack = 0.005f;
+      params.decay = carrier ? 0.8f : 0.4f;
+      params.sustain = carrier ? 0.7f : 0.3f;
+      params.release = 0.3f;
+    }
+    return p;
+  }
+
+private:
+  FMPatch patch;
+};
+
+// ============================================================================
+// FM Voice
+// ============================================================================
+class FMVoice final : public juce::SynthesiserVoice {
+public:
+  FMVoice(FMBank &bankToUse, int voiceIndex)
+      : bank(bankToUse), ownerId(voiceIndex) {}
+
+  bool canPlaySound(juce::SynthesiserSound *sound) override {
+    return dynamic_cast<const FMSound *>(sound) != nullptr;
+  }
+
+  void startNote(int midiNoteNumber, float velocity,
+                 juce::SynthesiserSound *s,
+                 int /*currentPitchWheelPosition*/) override {
+    detachSlot();
+
+    auto *sound = dynamic_cast<const FMSound *>(s);
+    if (sound == nullptr) {
+      clearCurrentNote();
+      return;
+    }
+
+    const auto &patch = sound->getPatch();
+    slot = bank.allocateSlot(ownerId, patch.algorithm);
+    if (slot < 0) {
+      clearCurrentNote();
+      return;
+    }
+
+    const double cyclesPerSample =
+        juce::MidiMessage::getMidiNoteInHertz(midiNoteNumber) /
+        getSampleRate();
+    bank.startVoice(slot, patch, cyclesPerSample, velocity, getSampleRate());
+  }
+
+  void stopNote(float /*velocity*/, bool allowTailOff) override {
+    if (allowTailOff) {
+      if (ownsSlot())
+        bank.releaseVoice(slot);
+    } else {
+      detachSlot();
+      clearCurrentNote();
+    }
+  }
+
+  float getCurrentLevel() const {
+    return ownsSlot() ? bank.getVoiceLevel(slot) : 0.0f;
+  }
+
+  void pitchWheelMoved(int /*newValue*/) override {}
+  void controllerMoved(int /*controllerNumber*/, int /*newValue*/) override {}
+
+  // Audio was already rendered by the bank; only notice a culled slot here
+  void renderNextBlock(juce::AudioBuffer<float> & /*outputBuffer*/,
+                       int /*startSample*/, int /*numSamples*/) override {
+    if (isVoiceActive() && !ownsSlot()) {
+      slot = -1;
+      clearCurrentNote();
+    }
+  }
+
+  using SynthesiserVoice::renderNextBlock;
+
+private:
+  // A culled slot may already belong to another voice
+  bool ownsSlot() const {
+    return slot >= 0 && bank.getSlotOwner(slot) == ownerId;
+  }
+
+  // Hands the slot to the bank, which fades it out and frees it
+  void detachSlot() {
+    if (ownsSlot())
+      bank.fadeOutVoice(slot);
+    slot = -1;
+  }
+
+  FMBank &bank;
+  const int ownerId;
+  int slot = -1;
+};
+
+} // namespace Synth
+} // namespace Sphere
@@ -0,0 +1,567 @@
+/*
+  ==============================================================================
+    SphereGranular.h
+    Granular sound, engine and voice reading decoded samples from the cache
+
+    A granular voice does not render anything itself: it owns a grain
+    stream in the GranularEngine, which schedules grains for every stream
+    and renders all of them once per block, ahead of the per-voice
+    callbacks.
+
+    Grains live in a fixed pool of MAX_GRAINS structure-of-arrays slots,
+    rendered VOICE_LANES at a time, so spawning and retiring a grain is a
+    bit flip and never allocates. Onsets are scheduled to the sample: a
+    grain spawned mid-block carries its offset and stays silent until then.
+    Windows come from lookup tables built once; samples are read in place
+    from Float32 cache entries, whose guard samples cover the interpolator.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "SphereSampleCache.h"
+#include "SphereSynthTypes.h"
+#include <cmath>
+#include <vector>
+
+namespace Sphere {
+namespace Synth {
+
+constexpr int MAX_GRAINS = 512;
+constexpr int MAX_GRAIN_GROUPS = MAX_GRAINS / VOICE_LANES;
+constexpr int MAX_GRANULAR_STREAMS = MAX_POOL_VOICES;
+
+enum class GrainWindow : int { Hann, Gaussian, Tukey, Triangle, NumWindows };
+
+struct GranularParams {
+  float position = 0.25f;       // read position as a fraction of the sample
+  float positionJitter = 0.05f; // random offset, fraction of the sample
+  float grainLength = 0.08f;    // seconds
+  float density = 40.0f;        // grains per second
+  float timingJitter = 0.3f;    // 0 = periodic, 1 = onsets vary +-100%
+  float pitchJitter = 0.1f;     // semitones
+  float spread = 0.5f;          // stereo spread 0..1
+  GrainWindow window = GrainWindow::Hann;
+};
+
+// ============================================================================
+// Granular Sound
+// ============================================================================
+class GranularSound final : public juce::SynthesiserSound {
+public:
+  GranularSound(SampleCache::Entry::Ptr sampleEntry, int rootMidiNote,
+                const GranularParams &grainParams, double attackTimeSecs,
+                double releaseTimeSecs)
+      : entry(std::move(sampleEntry)), midiRootNote(rootMidiNote),
+        params(grainParams) {
+    envelope.attack = static_cast<float>(attackTimeSecs);
+    envelope.release = static_cast<float>(releaseTimeSecs);
+  }
+
+  bool appliesToNote(int /*midiNoteNumber*/) override { return true; }
+  bool appliesToChannel(int /*midiChannel*/) override { return true; }
+
+  // nullptr while the cache is still decoding
+  const DecodedSample *getSample() const { return entry->getSample(); }
+  SampleCache::Entry *getEntry() const { return entry.get(); }
+  int getRootNote() const { return midiRootNote; }
+  const GranularParams &getParams() const { return params; }
+  const juce::ADSR::Parameters &getEnvelopeParameters() const {
+    return envelope;
+  }
+
+private:
+  SampleCache::Entry::Ptr entry;
+  int midiRootNote = 60;
+  GranularParams params;
+  juce::ADSR::Parameters envelope;
+};
+
+// ============================================================================
+// Granular Engine (grain streams, grain pool and window tables)
+// ============================================================================
+class GranularEngine {
+public:
+  static constexpr int WINDOW_SIZE = 1024;
+
+  GranularEngine() {
+    buildWindows();
+    for (int s = 0; s < MAX_GRANULAR_STREAMS; ++s)
+      streams[s].random.setSeed(s + 1);
+    reset();
+  }
+
+  // ========================================================================
+  // Setup (message thread, before playback)
+  // ========================================================================
+  void prepare(int maxBlockSize) {
+    this->maxBlockSize = juce::jmax(1, maxBlockSize);
+    stereoMix.assign(static_cast<size_t>(this->maxBlockSize) * 2, 0.0f);
+    reset();
+  }
+
+  void reset() {
+    for (auto &stream : streams) {
+      stream.active = false;
+      stream.adsr.reset();
+    }
+
+    for (int grain = 0; grain < MAX_GRAINS; ++grain)
+      clearGrain(grain);
+
+    groupActiveCount.fill(0);
+    activeBits.fill(0);
+    numActiveGrains = 0;
+    numActiveStreams = 0;
+  }
+
+  // ========================================================================
+  // Streams (audio thread)
+  // ========================================================================
+
+  // Starts scheduling grains for a note; false if the sample isn't decoded
+  // yet or is not stored as Float32
+  bool startStream(int index, const GranularSound &sound, int midiNoteNumber,
+                   float velocity, double sampleRate) {
+    auto &stream = streams[index];
+    const DecodedSample *sample = sound.getSample();
+
+    if (sample == nullptr || sample->getEncoding() != SampleEncoding::Float32 ||
+        sample->getNumSamples() < 4) {
+      stopStream(index);
+      return false;
+    }
+
+    const auto &params = sound.getParams();
+    stream.entry = sound.getEntry();
+    stream.sample = sample;
+    stream.params = params;
+    stream.pitchRatio =
+        std::pow(2.0, (midiNoteNumber - sound.getRootNote()) / 12.0) *
+        sample->getSampleRate() / sampleRate;
+    stream.grainSamples = juce::jmax(
+        2, static_cast<int>(params.grainLength * sampleRate));
+    stream.interval = juce::jmax(
+        1.0, sampleRate / juce::jmax(0.1, static_cast<double>(params.density)));
+    stream.nextOnset = 0.0;
+
+    // Keep the summed level roughly independent of how many grains overlap
+    const float overlap = juce::jmax(
+        1.0f, params.density * params.grainLength);
+    stream.gain = velocity * VOICE_LEVEL_SCALE / std::sqrt(overlap);
+
+    stream.adsr.setSampleRate(sampleRate);
+    stream.adsr.setParameters(sound.getEnvelopeParameters());
+    stream.adsr.noteOn();
+
+    if (!stream.active)
+      ++numActiveStreams;
+    stream.active = true;
+    return true;
+  }
+
+  // Envelope release; the stream ends once the envelope has
+  void releaseStream(int index) { streams[index].adsr.noteOff(); }
+
+  // Stops spawning at once; grains already sounding play to their end
+  void stopStream(int index) {
+    auto &stream = streams[index];
+    if (stream.active)
+      --numActiveStreams;
+    stream.active = false;
+    stream.adsr.reset();
+    stream.entry = nullptr;
+  }
+
+  bool isStreamActive(int index) const { return streams[index].active; }
+
+  int getNumActiveGrains() const { return numActiveGrains; }
+
+  // Grains not started because the pool was full
+  uint32_t getDroppedGrains() const { return droppedGrains; }
+
+  // ========================================================================
+  // Rendering (audio thread): schedules and adds every grain to the buffer
+  // ========================================================================
+  void render(juce::AudioBuffer<float> &buffer, int startSample,
+              int numSamples) {
+    if ((numActiveStreams == 0 && numActiveGrains == 0) || stereoMix.empty())
+      return;
+
+    while (numSamples > 0) {
+      const int chunk = juce::jmin(numSamples, maxBlockSize);
+      renderChunk(buffer, startSample, chunk);
+      startSample += chunk;
+      numSamples -= chunk;
+    }
+  }
+
+private:
+  static constexpr int NUM_SLOT_WORDS = MAX_GRAINS / 64;
+  static constexpr int NUM_WINDOWS = static_cast<int>(GrainWindow::NumWindows);
+
+  struct Stream {
+    SampleCache::Entry::Ptr entry; // keeps sample alive, see grainEntry
+    const DecodedSample *sample = nullptr;
+    GranularParams params;
+    double pitchRatio = 1.0; // source frames per output frame
+    double interval = 1.0;   // mean samples between onsets
+    double nextOnset = 0.0;  // relative to the start of the next chunk
+    int grainSamples = 2;
+    float gain = 0.0f;
+    float level = 0.0f; // envelope at the last scheduled sample
+    juce::ADSR adsr;
+    juce::Random random;
+    bool active = false;
+  };
+
+  void renderChunk(juce::AudioBuffer<float> &buffer, int startSample,
+                   int numSamples) {
+    for (int s = 0; s < MAX_GRANULAR_STREAMS; ++s)
+      if (streams[s].active)
+        scheduleGrains(s, numSamples);
+
+    float *mixL = stereoMix.data();
+    float *mixR = mixL + maxBlockSize;
+    juce::FloatVectorOperations::clear(mixL, numSamples);
+    juce::FloatVectorOperations::clear(mixR, numSamples);
+
+    for (int g = 0; g < MAX_GRAIN_GROUPS; ++g) {
+      if (groupActiveCount[g] != 0) {
+        renderGroup(g, mixL, mixR, numSamples);
+        cullGroup(g);
+      }
+    }
+
+    const int numChannels = buffer.getNumChannels();
+    if (numChannels == 1) {
+      juce::FloatVectorOperations::add(mixL, mixR, numSamples);
+      juce::FloatVectorOperations::addWithMultiply(
+          buffer.getWritePointer(0, startSample), mixL, 0.5f, numSamples);
+      return;
+    }
+
+    for (int ch = 0; ch < numChannels; ++ch)
+      juce::FloatVectorOperations::add(buffer.getWritePointer(ch, startSample),
+                                       ch == 0 ? mixL : mixR, numSamples);
+  }
+
+  // Runs the stream's envelope over the chunk and spawns a grain at every
+  // onset that falls inside it
+  void scheduleGrains(int index, int numSamples) {
+    auto &stream = streams[index];
+    int i = 0;
+
+    while (stream.nextOnset < numSamples) {
+      const int onset = static_cast<int>(stream.nextOnset);
+      for (; i <= onset; ++i)
+        stream.level = stream.adsr.getNextSample();
+
+      spawnGrain(stream, onset);
+
+      const float jitter =
+          stream.params.timingJitter * nextBipolar(stream.random);
+      stream.nextOnset += juce::jmax(1.0, stream.interval * (1.0 + jitter));
+    }
+
+    for (; i < numSamples; ++i)
+      stream.level = stream.adsr.getNextSample();
+    stream.nextOnset -= numSamples;
+
+    if (!stream.adsr.isActive())
+      stopStream(index);
+  }
+
+  void spawnGrain(Stream &stream, int offset) {
+    const int grain = findFreeGrain();
+    if (grain < 0) {
+      ++droppedGrains;
+      return;
+    }
+
+    auto &random = stream.random;
+    const auto &params = stream.params;
+    const DecodedSample &sample = *stream.sample;
+    const int numFrames = sample.getNumSamples();
+
+    const double detune = params.pitchJitter * nextBipolar(random);
+    const double step = stream.pitchRatio * std::pow(2.0, detune / 12.0);
+
+    // The grain has to end inside the sample: the guard samples only cover
+    // the interpolator's one frame of lookahead
+    const int length = juce::jmax(
+        2, juce::jmin(stream.grainSamples,
+                      static_cast<int>((numFrames - 2) / step)));
+    const double lastStart = juce::jmax(0.0, numFrames - 2 - length * step);
+    const double jitter = params.positionJitter * nextBipolar(random);
+    const double start = juce::jlimit(
+        0.0, lastStart, (params.position + jitter) * numFrames);
+
+    const float pan = params.spread * nextBipolar(random);
+    const float amplitude = stream.gain * stream.level;
+
+    setActive(grain, true);
+    sourceIndex[grain] = static_cast<int32_t>(start);
+    sourceFrac[grain] = static_cast<float>(start - sourceIndex[grain]);
+    sourceStep[grain] = static_cast<float>(step);
+    windowPhase[grain] = 0.0f;
+    windowIncrement[grain] = 1.0f / static_cast<float>(length);
+    gainLeft[grain] = amplitude * juce::jmin(1.0f, 1.0f - pan);
+    gainRight[grain] = amplitude * juce::jmin(1.0f, 1.0f + pan);
+    startOffset[grain] = offset;
+    sourceLeft[grain] = sample.getReadPointer(0);
+    sourceRight[grain] = sample.getReadPointer(1);
+    grainEntry[grain] = stream.entry;
+    windowTable[grain] = windows[static_cast<size_t>(params.window)].data();
+  }
+
+  static float nextBipolar(juce::Random &random) {
+    return 2.0f * random.nextFloat() - 1.0f;
+  }
+
+  // One sample per lane per step; lanes run until their window has ended
+  // and silent lanes read a zero table, so the loop body has no branches
+  void renderGroup(int g, float *mixL, float *mixR, int numSamples) {
+    alignas(SIMD_ALIGNMENT) int32_t index[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float frac[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float step[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float wPhase[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float wInc[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float gainL[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float gainR[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) int32_t offset[VOICE_LANES];
+    const float *srcL[VOICE_LANES];
+    const float *srcR[VOICE_LANES];
+    const float *win[VOICE_LANES];
+
+    const int base = g * VOICE_LANES;
+    for (int l = 0; l < VOICE_LANES; ++l) {
+      index[l] = sourceIndex[base + l];
+      frac[l] = sourceFrac[base + l];
+      step[l] = sourceStep[base + l];
+      wPhase[l] = windowPhase[base + l];
+      wInc[l] = windowIncrement[base + l];
+      gainL[l] = gainLeft[base + l];
+      gainR[l] = gainRight[base + l];
+      offset[l] = startOffset[base + l];
+      srcL[l] = sourceLeft[base + l];
+      srcR[l] = sourceRight[base + l];
+      win[l] = windowTable[base + l];
+    }
+
+    for (int i = 0; i < numSamples; ++i) {
+      alignas(SIMD_ALIGNMENT) float laneL[VOICE_LANES];
+      alignas(SIMD_ALIGNMENT) float laneR[VOICE_LANES];
+
+      for (int l = 0; l < VOICE_LANES; ++l) {
+        const float scaled = wPhase[l] * static_cast<float>(WINDOW_SIZE);
+        const int w = static_cast<int>(scaled);
+        const float *t = win[l] + w;
+        const float window = t[0] + (scaled - static_cast<float>(w)) *
+                                        (t[1] - t[0]);
+
+        const float *a = srcL[l] + index[l];
+        const float *b = srcR[l] + index[l];
+        const float left = a[0] + frac[l] * (a[1] - a[0]);
+        const float right = b[0] + frac[l] * (b[1] - b[0]);
+
+        const bool running = i >= offset[l] && wPhase[l] < 1.0f;
+        const float amp = running ? window : 0.0f;
+        laneL[l] = left * amp * gainL[l];
+        laneR[l] = right * amp * gainR[l];
+
+        const float advance = running ? 1.0f : 0.0f;
+        wPhase[l] = juce::jmin(1.0f, wPhase[l] + wInc[l] * advance);
+        const float f = frac[l] + step[l] * advance;
+        const auto carry = static_cast<int32_t>(f);
+        index[l] += carry;
+        frac[l] = f - static_cast<float>(carry);
+      }
+
+      float sumL = 0.0f;
+      float sumR = 0.0f;
+      for (int l = 0; l < VOICE_LANES; ++l) {
+        sumL += laneL[l];
+        sumR += laneR[l];
+      }
+      mixL[i] += sumL;
+      mixR[i] += sumR;
+    }
+
+    for (int l = 0; l < VOICE_LANES; ++l) {
+      sourceIndex[base + l] = index[l];
+      sourceFrac[base + l] = frac[l];
+      windowPhase[base + l] = wPhase[l];
+      startOffset[base + l] = 0; // onsets only apply to their own chunk
+    }
+  }
+
+  void cullGroup(int g) {
+    const int base = g * VOICE_LANES;
+    for (int l = 0; l < VOICE_LANES; ++l) {
+      const int grain = base + l;
+      if (active[grain] != 0 && windowPhase[grain] >= 1.0f) {
+        setActive(grain, false);
+        clearGrain(grain);
+      }
+    }
+  }
+
+  int findFreeGrain() const {
+    for (int w = 0; w < NUM_SLOT_WORDS; ++w) {
+      const uint64_t free = ~activeBits[w];
+      if (free == 0)
+        continue;
+
+      int bit = 0;
+      while (((free >> bit) & 1u) == 0)
+        ++bit;
+      return w * 64 + bit;
+    }
+    return -1;
+  }
+
+  void setActive(int grain, bool shouldBeActive) {
+    const bool wasActive = active[grain] != 0;
+    if (wasActive == shouldBeActive)
+      return;
+
+    active[grain] = shouldBeActive ? 1 : 0;
+    activeBits[grain / 64] ^= uint64_t{1} << (grain % 64);
+    const int delta = shouldBeActive ? 1 : -1;
+    groupActiveCount[grain / VOICE_LANES] += delta;
+    numActiveGrains += delta;
+  }
+
+  // Idle lanes still run through the kernel: finished window, zero gain and
+  // a zero source that never advances
+  void clearGrain(int grain) {
+    sourceIndex[grain] = 0;
+    sourceFrac[grain] = 0.0f;
+    sourceStep[grain] = 0.0f;
+    windowPhase[grain] = 1.0f;
+    windowIncrement[grain] = 0.0f;
+    gainLeft[grain] = 0.0f;
+    gainRight[grain] = 0.0f;
+    startOffset[grain] = 0;
+    sourceLeft[grain] = silence.data();
+    sourceRight[grain] = silence.data();
+    grainEntry[grain] = nullptr;
+    windowTable[grain] = windows[0].data();
+  }
+
+  // WINDOW_SIZE + 1 points from 0 to 1 inclusive, plus a zero so the
+  // interpolator can read one past the end
+  void buildWindows() {
+    const double pi = juce::MathConstants<double>::pi;
+    const double gaussianEdge = std::exp(-0.5 * (0.5 / 0.15) * (0.5 / 0.15));
+
+    for (int k = 0; k <= WINDOW_SIZE; ++k) {
+      const double x = static_cast<double>(k) / WINDOW_SIZE;
+      const double g = (x - 0.5) / 0.15;
+      // Tukey: cosine tapers over the first and last quarter
+      const double edge = juce::jmin(x, 1.0 - x) / 0.25;
+
+      windows[0][k] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * pi * x));
+      windows[1][k] = static_cast<float>(
+          (std::exp(-0.5 * g * g) - gaussianEdge) / (1.0 - gaussianEdge));
+      windows[2][k] = static_cast<float>(
+          edge >= 1.0 ? 1.0 : 0.5 - 0.5 * std::cos(pi * edge));
+      windows[3][k] = static_cast<float>(1.0 - std::abs(2.0 * x - 1.0));
+    }
+
+    for (auto &window : windows) {
+      window[0] = 0.0f;
+      window[WINDOW_SIZE] = 0.0f;
+      window[WINDOW_SIZE + 1] = 0.0f;
+    }
+  }
+
+  // Streams, one per granular voice
+  std::array<Stream, MAX_GRANULAR_STREAMS> streams;
+  int numActiveStreams = 0;
+
+  // Grain pool (structure of arrays)
+  alignas(SIMD_ALIGNMENT) std::array<int32_t, MAX_GRAINS> sourceIndex{};
+  VoiceLaneArray sourceFrac;
+  VoiceLaneArray sourceStep;
+  VoiceLaneArray windowPhase;
+  VoiceLaneArray windowIncrement;
+  VoiceLaneArray gainLeft;
+  VoiceLaneArray gainRight;
+  alignas(SIMD_ALIGNMENT) std::array<int32_t, MAX_GRAINS> startOffset{};
+  std::array<const float *, MAX_GRAINS> sourceLeft{};
+  std::array<const float *, MAX_GRAINS> sourceRight{};
+  std::array<const float *, MAX_GRAINS> windowTable{};
+  std::array<uint8_t, MAX_GRAINS> active{};
+
+  // Grains play on after their voice (and possibly its sound) has gone, so
+  // each one holds the entry it reads from. The sample cache keeps its own
+  // reference until nothing else holds one, so releasing these on the audio
+  // thread never deletes anything.
+  std::array<SampleCache::Entry::Ptr, MAX_GRAINS> grainEntry;
+
+  std::array<uint64_t, NUM_SLOT_WORDS> activeBits{};
+  std::array<int, MAX_GRAIN_GROUPS> groupActiveCount{};
+  int numActiveGrains = 0;
+  uint32_t droppedGrains = 0;
+
+  std::array<std::array<float, WINDOW_SIZE + 2>, NUM_WINDOWS> windows{};
+  std::array<float, 2> silence{};
+
+  std::vector<float> stereoMix;
+  int maxBlockSize = 0;
+};
+
+// ============================================================================
+// Granular Voice
+// ============================================================================
+class GranularVoice final : public juce::SynthesiserVoice {
+public:
+  GranularVoice(GranularEngine &engineToUse, int streamIndex)
+      : engine(engineToUse), stream(streamIndex) {}
+
+  bool canPlaySound(juce::SynthesiserSound *sound) override {
+    return dynamic_cast<const GranularSound *>(sound) != nullptr;
+  }
+
+  void startNote(int midiNoteNumber, float velocity,
+                 juce::SynthesiserSound *s,
+                 int /*currentPitchWheelPosition*/) override {
+    auto *sound = dynamic_cast<const GranularSound *>(s);
+
+    // Not decoded yet: stay silent rather than wait
+    if (sound == nullptr ||
+        !engine.startStream(stream, *sound, midiNoteNumber, velocity,
+                            getSampleRate()))
+      clearCurrentNote();
+  }
+
+  void stopNote(float /*velocity*/, bool allowTailOff) override {
+    if (allowTailOff) {
+      engine.releaseStream(stream);
+    } else {
+      engine.stopStream(stream);
+      clearCurrentNote();
+    }
+  }
+
+  void pitchWheelMoved(int /*newValue*/) override {}
+  void controllerMoved(int /*controllerNumber*/, int /*newValue*/) override {}
+
+  // Grains were already rendered by the engine; only notice the end here
+  void renderNextBlock(juce::AudioBuffer<float> & /*outputBuffer*/,
+                       int /*startSample*/, int /*numSamples*/) override {
+    if (isVoiceActive() && !engine.isStreamActive(stream))
+      clearCurrentNote();
+  }
+
+  using SynthesiserVoice::renderNextBlock;
+
+private:
+  GranularEngine &engine;
+  const int stream;
+};
+
+} // namespace Synth
+} // namespace Sphere
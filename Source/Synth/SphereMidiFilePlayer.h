@@ -0,0 +1,329 @@
+/*
+  ==============================================================================
+    SphereMidiFilePlayer.h
+    Standard MIDI File playback with sample-accurate, allocation-free dispatch
+
+    A MidiSequence is parsed once on the message thread: every track's
+    channel messages are converted to sample positions at the engine rate
+    (following the file's tempo map), merged into one time-sorted array
+    of packed events, and frozen. Meta and system exclusive events are
+    dropped.
+
+    The MidiFilePlayer walks that array with a cursor on the audio thread.
+    Each block it copies the events that fall inside the block into the
+    block's MidiBuffer at their exact offsets - no searching, no parsing
+    and no allocation once the buffer has been sized. The same
+    renderNextBlock() call drives real-time playback, soak tests and
+    offline rendering alike.
+
+    Sequences are published like a SoundSet (atomic pointer, release
+    pool). Transport requests from other threads are atomics the audio
+    thread picks up at its next block; stopping, seeking, looping and
+    replacing the sequence all send note-offs for the notes the player
+    left sounding.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../Common/SphereReleasePool.h"
+#include <JuceHeader.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <vector>
+
+namespace Sphere {
+namespace Synth {
+
+// ============================================================================
+// Parsed, immutable event list
+// ============================================================================
+class MidiSequence final : public juce::ReferenceCountedObject {
+public:
+  using Ptr = juce::ReferenceCountedObjectPtr<MidiSequence>;
+
+  // One channel message: up to three bytes packed as
+  // status | data1 << 8 | data2 << 16 | length << 24
+  struct Event {
+    int64_t sample; // from the start of the sequence
+    uint32_t message;
+
+    int getNumBytes() const { return static_cast<int>(message >> 24); }
+    uint8_t getStatus() const { return static_cast<uint8_t>(message); }
+  };
+
+  // Message thread. The file's timestamps may be in ticks or seconds.
+  MidiSequence(const juce::MidiFile &file, double sampleRate)
+      : sampleRate(sampleRate) {
+    juce::MidiFile timed(file);
+    timed.convertTimestampTicksToSeconds();
+
+    for (int t = 0; t < timed.getNumTracks(); ++t) {
+      const auto *track = timed.getTrack(t);
+      for (int i = 0; i < track->getNumEvents(); ++i)
+        addEvent(track->getEventPointer(i)->message);
+    }
+
+    // At equal times note-offs go first, so a repeated note retriggers
+    // instead of being cut by its own previous note-off
+    std::stable_sort(events.begin(), events.end(),
+                     [](const Event &a, const Event &b) {
+                       if (a.sample != b.sample)
+                         return a.sample < b.sample;
+                       return isNoteOff(a) && !isNoteOff(b);
+                     });
+
+    lengthInSamples = juce::jmax(
+        toSamples(timed.getLastTimestamp()),
+        events.empty() ? int64_t{0} : events.back().sample + 1);
+  }
+
+  // Reads a Standard MIDI File; nullptr if the stream isn't one
+  static Ptr loadFrom(juce::InputStream &stream, double sampleRate) {
+    juce::MidiFile file;
+    if (!file.readFrom(stream))
+      return nullptr;
+    return new MidiSequence(file, sampleRate);
+  }
+
+  const Event *getEvents() const { return events.data(); }
+  int getNumEvents() const { return static_cast<int>(events.size()); }
+  int64_t getLengthInSamples() const { return lengthInSamples; }
+  double getSampleRate() const { return sampleRate; }
+
+  // First event at or after a position (seeking only, not per block)
+  int findEventAt(int64_t sample) const {
+    const auto it = std::lower_bound(
+        events.begin(), events.end(), sample,
+        [](const Event &e, int64_t position) { return e.sample < position; });
+    return static_cast<int>(it - events.begin());
+  }
+
+private:
+  void addEvent(const juce::MidiMessage &message) {
+    const int numBytes = message.getRawDataSize();
+    if (message.isMetaEvent() || message.isSysEx() || numBytes < 1 ||
+        numBytes > 3)
+      return;
+
+    const auto *data = message.getRawData();
+    uint32_t packed = static_cast<uint32_t>(numBytes) << 24;
+    for (int b = 0; b < numBytes; ++b)
+      packed |= static_cast<uint32_t>(data[b]) << (8 * b);
+
+    events.push_back({toSamples(message.getTimeStamp()), packed});
+  }
+
+  int64_t toSamples(double seconds) const {
+    return juce::jmax(int64_t{0},
+                      static_cast<int64_t>(std::llround(seconds * sampleRate)));
+  }
+
+  static bool isNoteOff(const Event &e) {
+    const uint8_t type = e.getStatus() & 0xf0;
+    const uint8_t velocity = static_cast<uint8_t>(e.message >> 16);
+    return type == 0x80 || (type == 0x90 && velocity == 0);
+  }
+
+  const double sampleRate;
+  std::vector<Event> events;
+  int64_t lengthInSamples = 0;
+};
+
+// ============================================================================
+// MIDI File Player
+// ============================================================================
+class MidiFilePlayer {
+public:
+  explicit MidiFilePlayer(ReleasePool &poolToUse) : releasePool(poolToUse) {}
+
+  ~MidiFilePlayer() {
+    if (auto *pending = pendingSequence.exchange(nullptr))
+      pending->decReferenceCount();
+  }
+
+  // ========================================================================
+  // Control (any thread except the audio thread). A new sequence starts
+  // stopped at its beginning; nullptr unloads.
+  // ========================================================================
+  void setSequence(MidiSequence::Ptr newSequence) {
+    if (newSequence == nullptr)
+      newSequence = new MidiSequence(juce::MidiFile(), 44100.0);
+
+    stop();
+    seekRequest.store(-1.0, std::memory_order_release);
+    releasePool.add(newSequence.get());
+    newSequence->incReferenceCount();
+    if (auto *previous = pendingSequence.exchange(newSequence.get(),
+                                                  std::memory_order_acq_rel))
+      previous->decReferenceCount();
+  }
+
+  void play() { playRequested.store(true, std::memory_order_release); }
+  void stop() { playRequested.store(false, std::memory_order_release); }
+
+  void setLooping(bool shouldLoop) {
+    looping.store(shouldLoop, std::memory_order_release);
+  }
+
+  void seek(double seconds) {
+    seekRequest.store(juce::jmax(0.0, seconds), std::memory_order_release);
+  }
+
+  bool isPlaying() const { return playing.load(std::memory_order_acquire); }
+
+  // Samples at the sequence's rate
+  int64_t getPosition() const {
+    return reportedPosition.load(std::memory_order_relaxed);
+  }
+
+  // ========================================================================
+  // Audio thread: adds this block's events to the buffer at their sample
+  // offsets. The buffer should have been sized up front (ensureSize) so
+  // adding never allocates.
+  // ========================================================================
+  void renderNextBlock(juce::MidiBuffer &midi, int numSamples) {
+    adoptPendingSequence(midi);
+    applySeekRequest(midi);
+
+    const bool wantPlay = playRequested.load(std::memory_order_acquire);
+    if (!wantPlay && running) {
+      releaseHeldNotes(midi, 0);
+      running = false;
+    } else if (wantPlay && !running) {
+      running = sequence != nullptr && sequence->getNumEvents() > 0;
+      if (!running)
+        playRequested.store(false, std::memory_order_release);
+    }
+
+    if (running)
+      dispatch(midi, numSamples);
+
+    playing.store(running, std::memory_order_release);
+    reportedPosition.store(position, std::memory_order_relaxed);
+  }
+
+private:
+  void dispatch(juce::MidiBuffer &midi, int numSamples) {
+    const auto *events = sequence->getEvents();
+    const int numEvents = sequence->getNumEvents();
+    const int64_t length = sequence->getLengthInSamples();
+
+    int offset = 0;
+    while (offset < numSamples) {
+      const int64_t blockEnd =
+          juce::jmin(position + (numSamples - offset), length);
+
+      for (; cursor < numEvents && events[cursor].sample < blockEnd;
+           ++cursor) {
+        const auto &event = events[cursor];
+        const int eventOffset =
+            offset + static_cast<int>(event.sample - position);
+        sendEvent(midi, event, eventOffset);
+      }
+
+      offset += static_cast<int>(blockEnd - position);
+      position = blockEnd;
+      if (position < length)
+        break;
+
+      // End of the sequence: wrap, or stop where it ended
+      releaseHeldNotes(midi, juce::jmin(offset, numSamples - 1));
+      position = 0;
+      cursor = 0;
+      if (!looping.load(std::memory_order_acquire)) {
+        running = false;
+        playRequested.store(false, std::memory_order_release);
+        break;
+      }
+    }
+  }
+
+  void sendEvent(juce::MidiBuffer &midi, const MidiSequence::Event &event,
+                 int sampleOffset) {
+    const uint8_t bytes[3] = {static_cast<uint8_t>(event.message),
+                              static_cast<uint8_t>(event.message >> 8),
+                              static_cast<uint8_t>(event.message >> 16)};
+    midi.addEvent(bytes, event.getNumBytes(), sampleOffset);
+
+    // Track sounding notes so they can be released on stop or seek
+    const int type = bytes[0] & 0xf0;
+    const int channel = bytes[0] & 0x0f;
+    if (event.getNumBytes() == 3 && (type == 0x80 || type == 0x90)) {
+      const int note = bytes[1] & 0x7f;
+      auto &word = heldNotes[static_cast<size_t>(channel)][note / 64];
+      const uint64_t bit = uint64_t{1} << (note % 64);
+      if (type == 0x90 && bytes[2] != 0)
+        word |= bit;
+      else
+        word &= ~bit;
+    }
+  }
+
+  void releaseHeldNotes(juce::MidiBuffer &midi, int sampleOffset) {
+    for (int channel = 0; channel < 16; ++channel) {
+      for (int w = 0; w < 2; ++w) {
+        uint64_t &word = heldNotes[static_cast<size_t>(channel)][w];
+        for (int bit = 0; word != 0; ++bit) {
+          if ((word & (uint64_t{1} << bit)) == 0)
+            continue;
+
+          const uint8_t noteOff[3] = {
+              static_cast<uint8_t>(0x80 | channel),
+              static_cast<uint8_t>(w * 64 + bit), 0};
+          midi.addEvent(noteOff, 3, sampleOffset);
+          word &= ~(uint64_t{1} << bit);
+        }
+      }
+    }
+  }
+
+  // Takes over the reference handed over by setSequence(); the replaced
+  // sequence is still held by the release pool
+  void adoptPendingSequence(juce::MidiBuffer &midi) {
+    if (pendingSequence.load(std::memory_order_relaxed) == nullptr)
+      return;
+
+    if (auto *latest =
+            pendingSequence.exchange(nullptr, std::memory_order_acq_rel)) {
+      releaseHeldNotes(midi, 0);
+      sequence = latest;
+      latest->decReferenceCount();
+      position = 0;
+      cursor = 0;
+      running = false;
+    }
+  }
+
+  void applySeekRequest(juce::MidiBuffer &midi) {
+    const double target =
+        seekRequest.exchange(-1.0, std::memory_order_acq_rel);
+    if (target < 0.0 || sequence == nullptr)
+      return;
+
+    releaseHeldNotes(midi, 0);
+    position = juce::jmin(
+        static_cast<int64_t>(target * sequence->getSampleRate()),
+        sequence->getLengthInSamples());
+    cursor = sequence->findEventAt(position);
+  }
+
+  ReleasePool &releasePool;
+  std::atomic<MidiSequence *> pendingSequence{nullptr};
+  std::atomic<bool> playRequested{false};
+  std::atomic<bool> looping{false};
+  std::atomic<double> seekRequest{-1.0}; // seconds; negative = none
+  std::atomic<bool> playing{false};
+  std::atomic<int64_t> reportedPosition{0};
+
+  // Audio thread only
+  MidiSequence::Ptr sequence;
+  int64_t position = 0;
+  int cursor = 0;
+  bool running = false;
+  std::array<std::array<uint64_t, 2>, 16> heldNotes{};
+};
+
+} // namespace Synth
+} // namespace Sphere
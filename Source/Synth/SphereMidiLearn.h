@@ -0,0 +1,477 @@
+/*
+  ==============================================================================
+    SphereMidiLearn.h
+    MIDI-learned controllers routed to engine parameters on the audio thread
+
+    Bindings (channel + CC, or channel + NRPN number -> target) are edited
+    on the message thread and compiled into an immutable MidiLearnMap: a
+    16 x 128 table giving each channel's CCs their target directly, plus
+    a short list of NRPN bindings. The map reaches the audio thread with
+    an atomic pointer swap, like a ModProgram.
+
+    On the audio thread a controller message is one table lookup. NRPNs
+    follow the usual 99/98 select, 6/38 data entry sequence per channel
+    and resolve to 14-bit values. Each target is smoothed towards its
+    latest value over a per-target time; the output stage reads audio-rate
+    ramps of the gain-like targets and the voices pick up the others once
+    per block. A target nobody has moved yet keeps the engine's own
+    setting.
+
+    Learning is a two-step handshake: the message thread arms a target,
+    the next controller that arrives is bound to it on the audio thread
+    at once and reported back, and the message thread then folds the new
+    binding into the settings and republishes the map.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "SphereVoiceFilter.h"
+#include <JuceHeader.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+namespace Sphere {
+namespace Synth {
+
+constexpr int MIDI_LEARN_CHANNELS = 16;
+constexpr int MIDI_LEARN_CONTROLLERS = 128;
+constexpr int MAX_NRPN_BINDINGS = 32;
+
+// Master gain multiplies the output gain, FX mix is the wet share; the
+// rest take over the oscillator sound's settings of the same name
+enum class ControlTarget : uint8_t {
+  MasterGain,
+  FXMix,
+  FilterCutoff,
+  FilterResonance,
+  WavetablePosition,
+  PulseWidth,
+  NumTargets
+};
+
+constexpr int NUM_CONTROL_TARGETS = static_cast<int>(ControlTarget::NumTargets);
+
+// Value range of a target; logarithmic ones sweep evenly in octaves
+struct ControlRange {
+  float minimum;
+  float maximum;
+  bool logarithmic;
+};
+
+inline const ControlRange &getControlRange(ControlTarget target) {
+  static const ControlRange ranges[NUM_CONTROL_TARGETS] = {
+      {0.0f, 1.0f, false},
+      {0.0f, 1.0f, false},
+      {20.0f, 20000.0f, true},
+      {VoiceFilter::MIN_RESONANCE, VoiceFilter::MAX_RESONANCE, true},
+      {0.0f, 1.0f, false},
+      {0.01f, 0.99f, false}};
+  return ranges[static_cast<int>(target)];
+}
+
+// Names used by the IPC commands
+inline const char *getControlTargetName(ControlTarget target) {
+  static constexpr const char *names[NUM_CONTROL_TARGETS] = {
+      "mastergain", "fxmix",     "cutoff",
+      "resonance",  "wavetable", "pulsewidth"};
+  return names[static_cast<int>(target)];
+}
+
+// NumTargets if the name is unknown
+inline ControlTarget findControlTarget(const juce::String &name) {
+  for (int i = 0; i < NUM_CONTROL_TARGETS; ++i)
+    if (name == getControlTargetName(static_cast<ControlTarget>(i)))
+      return static_cast<ControlTarget>(i);
+  return ControlTarget::NumTargets;
+}
+
+// Channel 1..16; number is the CC (0..127) or the NRPN (0..16383)
+struct MidiLearnBinding {
+  int channel = 1;
+  int number = 0;
+  bool nrpn = false;
+  ControlTarget target = ControlTarget::MasterGain;
+};
+
+struct MidiLearnSettings {
+  std::vector<MidiLearnBinding> bindings;
+  std::array<float, NUM_CONTROL_TARGETS> smoothingSeconds;
+
+  MidiLearnSettings() { smoothingSeconds.fill(DEFAULT_SMOOTHING); }
+
+  // Replaces whatever the controller was bound to before
+  void bind(const MidiLearnBinding &binding) {
+    unbindController(binding.channel, binding.number, binding.nrpn);
+    bindings.push_back(binding);
+  }
+
+  void unbindController(int channel, int number, bool nrpn) {
+    bindings.erase(std::remove_if(bindings.begin(), bindings.end(),
+                                  [&](const MidiLearnBinding &b) {
+                                    return b.channel == channel &&
+                                           b.number == number &&
+                                           b.nrpn == nrpn;
+                                  }),
+                   bindings.end());
+  }
+
+  void unbindTarget(ControlTarget target) {
+    bindings.erase(std::remove_if(bindings.begin(), bindings.end(),
+                                  [target](const MidiLearnBinding &b) {
+                                    return b.target == target;
+                                  }),
+                   bindings.end());
+  }
+
+  static constexpr float DEFAULT_SMOOTHING = 0.02f; // seconds
+};
+
+// ============================================================================
+// Compiled, immutable binding table
+// ============================================================================
+class MidiLearnMap final : public juce::ReferenceCountedObject {
+public:
+  using Ptr = juce::ReferenceCountedObjectPtr<MidiLearnMap>;
+
+  static constexpr uint8_t NO_TARGET = 0xff;
+
+  // Invalid bindings are dropped, as are NRPNs past MAX_NRPN_BINDINGS
+  explicit MidiLearnMap(const MidiLearnSettings &settings)
+      : smoothingSeconds(settings.smoothingSeconds) {
+    for (auto &row : controllerTargets)
+      row.fill(NO_TARGET);
+
+    for (const auto &binding : settings.bindings) {
+      const int channel = binding.channel - 1;
+      if (channel < 0 || channel >= MIDI_LEARN_CHANNELS ||
+          binding.target == ControlTarget::NumTargets)
+        continue;
+
+      const auto target = static_cast<uint8_t>(binding.target);
+      if (!binding.nrpn) {
+        if (binding.number >= 0 && binding.number < MIDI_LEARN_CONTROLLERS)
+          controllerTargets[static_cast<size_t>(channel)]
+                           [static_cast<size_t>(binding.number)] = target;
+      } else if (binding.number >= 0 && binding.number < 16384 &&
+                 numNrpnBindings < MAX_NRPN_BINDINGS) {
+        nrpnBindings[static_cast<size_t>(numNrpnBindings++)] = {
+            makeNrpnKey(channel, binding.number), target};
+      }
+    }
+  }
+
+  // Channel index 0..15
+  uint8_t getControllerTarget(int channel, int controller) const {
+    return controllerTargets[static_cast<size_t>(channel)]
+                            [static_cast<size_t>(controller)];
+  }
+
+  uint8_t getNrpnTarget(int channel, int number) const {
+    const uint32_t key = makeNrpnKey(channel, number);
+    for (int i = 0; i < numNrpnBindings; ++i)
+      if (nrpnBindings[static_cast<size_t>(i)].key == key)
+        return nrpnBindings[static_cast<size_t>(i)].target;
+    return NO_TARGET;
+  }
+
+  const std::array<float, NUM_CONTROL_TARGETS> smoothingSeconds;
+
+private:
+  struct NrpnBinding {
+    uint32_t key;
+    uint8_t target;
+  };
+
+  static uint32_t makeNrpnKey(int channel, int number) {
+    return static_cast<uint32_t>(channel) << 14 |
+           static_cast<uint32_t>(number);
+  }
+
+  std::array<std::array<uint8_t, MIDI_LEARN_CONTROLLERS>, MIDI_LEARN_CHANNELS>
+      controllerTargets;
+  std::array<NrpnBinding, MAX_NRPN_BINDINGS> nrpnBindings{};
+  int numNrpnBindings = 0;
+};
+
+// ============================================================================
+// MIDI Learn
+// ============================================================================
+class MidiLearn {
+public:
+  MidiLearn()
+      : defaultMap(new MidiLearnMap(MidiLearnSettings())), map(defaultMap) {
+    reset();
+  }
+
+  // ========================================================================
+  // Setup (message thread, before playback)
+  // ========================================================================
+  void prepare(double newSampleRate) {
+    sampleRate = newSampleRate;
+    reset();
+  }
+
+  void reset() {
+    for (auto &control : controls)
+      control = Control();
+    for (auto &state : nrpnStates)
+      state = NrpnState();
+    provisionalKey = NO_PROVISIONAL;
+  }
+
+  // Audio thread; the caller keeps the map alive (release pool)
+  void setMap(MidiLearnMap *newMap) {
+    if (newMap != nullptr) {
+      map = newMap;
+      provisionalKey = NO_PROVISIONAL;
+    }
+  }
+
+  // ========================================================================
+  // Learning (message thread): the next controller to arrive is bound to
+  // the target. takeLearnedBinding() reports it once.
+  // ========================================================================
+  void learn(ControlTarget target) {
+    learnRequest.store(static_cast<int>(target), std::memory_order_release);
+  }
+
+  void cancelLearn() { learnRequest.store(-1, std::memory_order_release); }
+
+  bool isLearning() const {
+    return learnRequest.load(std::memory_order_acquire) >= 0;
+  }
+
+  bool takeLearnedBinding(MidiLearnBinding &binding) {
+    const uint32_t packed = learned.exchange(0, std::memory_order_acq_rel);
+    if ((packed & LEARNED_VALID) == 0)
+      return false;
+
+    binding.number = static_cast<int>(packed & 0x3fff);
+    binding.channel = static_cast<int>((packed >> 14) & 0xf) + 1;
+    binding.target = static_cast<ControlTarget>((packed >> 18) & 0xff);
+    binding.nrpn = (packed & LEARNED_NRPN) != 0;
+    return true;
+  }
+
+  // ========================================================================
+  // Controller input (audio thread), channel 1..16
+  // ========================================================================
+  void handleController(int midiChannel, int controller, int value) {
+    const int channel = midiChannel - 1;
+    if (channel < 0 || channel >= MIDI_LEARN_CHANNELS || controller < 0 ||
+        controller >= MIDI_LEARN_CONTROLLERS)
+      return;
+
+    auto &nrpn = nrpnStates[static_cast<size_t>(channel)];
+    switch (controller) {
+    case NRPN_MSB:
+      nrpn.parameterMsb = value;
+      nrpn.selected = nrpn.parameterLsb >= 0;
+      return;
+    case NRPN_LSB:
+      nrpn.parameterLsb = value;
+      nrpn.selected = nrpn.parameterMsb >= 0;
+      return;
+    case RPN_MSB:
+    case RPN_LSB:
+      nrpn.selected = false;
+      return;
+    case DATA_ENTRY_MSB:
+    case DATA_ENTRY_LSB:
+      if (nrpn.selected) {
+        if (controller == DATA_ENTRY_MSB)
+          nrpn.dataMsb = value;
+        const int data = nrpn.dataMsb << 7 |
+                         (controller == DATA_ENTRY_LSB ? value : 0);
+        handleNrpn(channel, nrpn.parameterMsb << 7 | nrpn.parameterLsb,
+                   static_cast<float>(data) / 16383.0f);
+        return;
+      }
+      break;
+    default:
+      break;
+    }
+
+    const float normalized = static_cast<float>(value) / 127.0f;
+    const uint32_t key = makeKey(channel, controller, false);
+    if (tryLearn(key, normalized))
+      return;
+
+    uint8_t target = map->getControllerTarget(channel, controller);
+    if (key == provisionalKey)
+      target = provisionalTarget;
+    if (target != MidiLearnMap::NO_TARGET)
+      setNormalized(target, normalized);
+  }
+
+  // ========================================================================
+  // Smoothing (audio thread), once per block after the MIDI has been handled
+  // ========================================================================
+  void process(int numSamples) {
+    blockSamples = juce::jmax(0, numSamples);
+    for (auto &control : controls) {
+      control.blockStart = control.value;
+      control.rampSamples = juce::jmin(control.remaining, blockSamples);
+      control.value += control.step * static_cast<float>(control.rampSamples);
+      control.remaining -= control.rampSamples;
+      if (control.remaining == 0)
+        control.value = control.goal;
+    }
+  }
+
+  // True once a bound controller has moved the target
+  bool isControlled(ControlTarget target) const {
+    return controls[static_cast<size_t>(target)].controlled;
+  }
+
+  // The oscillator targets, which voices pick up per block
+  bool isControllingVoices() const {
+    return isControlled(ControlTarget::FilterCutoff) ||
+           isControlled(ControlTarget::FilterResonance) ||
+           isControlled(ControlTarget::WavetablePosition) ||
+           isControlled(ControlTarget::PulseWidth);
+  }
+
+  // Value at the end of the last processed block, in the target's units
+  float getValue(ControlTarget target) const {
+    return toRange(target, controls[static_cast<size_t>(target)].value);
+  }
+
+  // Audio-rate values across the last processed block
+  void fillRamp(ControlTarget target, float *output) const {
+    const auto &control = controls[static_cast<size_t>(target)];
+    float value = control.blockStart;
+    int i = 0;
+    for (; i < control.rampSamples; ++i) {
+      value += control.step;
+      output[i] = toRange(target, value);
+    }
+    const float settled = toRange(target, control.value);
+    for (; i < blockSamples; ++i)
+      output[i] = settled;
+  }
+
+private:
+  enum : int {
+    DATA_ENTRY_MSB = 6,
+    DATA_ENTRY_LSB = 38,
+    NRPN_LSB = 98,
+    NRPN_MSB = 99,
+    RPN_LSB = 100,
+    RPN_MSB = 101
+  };
+
+  static constexpr uint32_t LEARNED_VALID = 1u << 31;
+  static constexpr uint32_t LEARNED_NRPN = 1u << 26;
+  static constexpr uint32_t NO_PROVISIONAL = 0xffffffffu;
+
+  // Smoothing runs on the normalized value, so logarithmic targets glide
+  // evenly in octaves
+  struct Control {
+    float value = 0.0f;
+    float goal = 0.0f;
+    float step = 0.0f;
+    float blockStart = 0.0f;
+    int remaining = 0;
+    int rampSamples = 0;
+    bool controlled = false;
+  };
+
+  struct NrpnState {
+    int parameterMsb = -1;
+    int parameterLsb = -1;
+    int dataMsb = 0;
+    bool selected = false;
+  };
+
+  static uint32_t makeKey(int channel, int number, bool nrpn) {
+    return static_cast<uint32_t>(number) |
+           static_cast<uint32_t>(channel) << 14 | (nrpn ? LEARNED_NRPN : 0u);
+  }
+
+  // Clamped, as ramps can overshoot their goal by a rounding error
+  static float toRange(ControlTarget target, float normalized) {
+    const auto &range = getControlRange(target);
+    normalized = juce::jlimit(0.0f, 1.0f, normalized);
+    if (range.logarithmic)
+      return range.minimum *
+             std::exp2(normalized * std::log2(range.maximum / range.minimum));
+    return range.minimum + normalized * (range.maximum - range.minimum);
+  }
+
+  static float toRange(uint8_t target, float normalized) {
+    return toRange(static_cast<ControlTarget>(target), normalized);
+  }
+
+  void handleNrpn(int channel, int number, float normalized) {
+    const uint32_t key = makeKey(channel, number, true);
+    if (tryLearn(key, normalized))
+      return;
+
+    uint8_t target = map->getNrpnTarget(channel, number);
+    if (key == provisionalKey)
+      target = provisionalTarget;
+    if (target != MidiLearnMap::NO_TARGET)
+      setNormalized(target, normalized);
+  }
+
+  // Binds the controller if a target is armed. It routes here until the
+  // map with the binding arrives.
+  bool tryLearn(uint32_t key, float normalized) {
+    if (learnRequest.load(std::memory_order_relaxed) < 0)
+      return false;
+
+    const int target = learnRequest.exchange(-1, std::memory_order_acq_rel);
+    if (target < 0 || target >= NUM_CONTROL_TARGETS)
+      return false;
+
+    provisionalKey = key;
+    provisionalTarget = static_cast<uint8_t>(target);
+    learned.store(LEARNED_VALID | key | static_cast<uint32_t>(target) << 18,
+                  std::memory_order_release);
+    setNormalized(provisionalTarget, normalized);
+    return true;
+  }
+
+  // The first value a target receives applies at once
+  void setNormalized(uint8_t target, float normalized) {
+    auto &control = controls[target];
+    if (!control.controlled) {
+      control = Control();
+      control.value = control.goal = control.blockStart = normalized;
+      control.controlled = true;
+      return;
+    }
+
+    const int length = static_cast<int>(
+        map->smoothingSeconds[target] * static_cast<float>(sampleRate));
+    control.goal = normalized;
+    if (length <= 0) {
+      control.value = normalized;
+      control.remaining = 0;
+      return;
+    }
+    control.remaining = length;
+    control.step = (normalized - control.value) / static_cast<float>(length);
+  }
+
+  MidiLearnMap::Ptr defaultMap; // held for good, see setMap()
+  MidiLearnMap::Ptr map;
+  double sampleRate = 44100.0;
+
+  std::array<Control, NUM_CONTROL_TARGETS> controls{};
+  std::array<NrpnState, MIDI_LEARN_CHANNELS> nrpnStates{};
+  int blockSamples = 0;
+  uint32_t provisionalKey = NO_PROVISIONAL;
+  uint8_t provisionalTarget = MidiLearnMap::NO_TARGET;
+
+  std::atomic<int> learnRequest{-1};
+  std::atomic<uint32_t> learned{0};
+};
+
+} // namespace Synth
+} // namespace Sphere
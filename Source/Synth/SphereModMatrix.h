@@ -0,0 +1,776 @@
+/*
+  ==============================================================================
+    SphereModMatrix.h
+    Control-rate modulation matrix: LFOs, envelopes and MIDI controllers
+
+    Routes (source -> destination, amount, optional "via" scaling source)
+    are edited on the message thread and compiled into a flat, immutable
+    ModProgram: one operation per route, sorted by destination, with
+    routes that can't apply dropped. The program reaches the audio thread
+    with an atomic pointer swap, like a SoundSet.
+
+    Sources are evaluated every controlInterval samples (a "tick"), not
+    every sample. Per-voice state is stored by voice in lane arrays, so
+    each compiled operation is one loop over all voices. The matrix
+    publishes the per-voice results at the end of each tick, and consumers
+    ramp linearly between ticks to get audio-rate values. The oscillator
+    bank does this for pitch, amplitude and pulse width per lane and
+    steps its filters' cutoff once per tick; the output stage ramps the
+    global destinations.
+
+    Additive destinations (pitch, pulse width, cutoff, FX mix) sum
+    amount * source. Gain destinations (amplitude, master gain) multiply,
+    one factor of 1 + amount * (source - 1) per route: an envelope routed
+    with amount 1 becomes the voice's amplitude envelope, and an LFO with
+    a small amount gives tremolo below unity gain.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../Common/SphereFastMath.h"
+#include "SphereSynthTypes.h"
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+namespace Sphere {
+namespace Synth {
+
+constexpr int MAX_MOD_VOICES = MAX_POOL_VOICES;
+constexpr int MAX_MOD_ROUTES = 32;
+constexpr int NUM_MOD_LFOS = 2;
+constexpr int NUM_MOD_ENVELOPES = 2;
+
+// Values: LFOs -1..1, envelopes, velocity and mod wheel 0..1, pitch wheel
+// -1..1, key track (note - 60) / 60; Constant is always 1
+enum class ModSource : uint8_t {
+  Constant,
+  VoiceLFO1,
+  VoiceLFO2,
+  Envelope1,
+  Envelope2,
+  Velocity,
+  KeyTrack,
+  PitchWheel,
+  ModWheel,
+  GlobalLFO1,
+  GlobalLFO2,
+  NumSources
+};
+
+// Pitch and filter cutoff in semitones, pulse width as an offset to the
+// sound's width, FX mix as an offset from fully wet. The last two act on
+// the whole output and only accept global sources (constant, wheels,
+// global LFOs).
+enum class ModDestination : uint8_t {
+  Pitch,
+  Amplitude,
+  PulseWidth,
+  FilterCutoff,
+  MasterGain,
+  FXMix,
+  NumDestinations
+};
+
+constexpr int NUM_MOD_SOURCES = static_cast<int>(ModSource::NumSources);
+constexpr int NUM_MOD_DESTINATIONS =
+    static_cast<int>(ModDestination::NumDestinations);
+constexpr int NUM_VOICE_MOD_DESTINATIONS =
+    static_cast<int>(ModDestination::MasterGain);
+constexpr int NUM_GLOBAL_MOD_DESTINATIONS =
+    NUM_MOD_DESTINATIONS - NUM_VOICE_MOD_DESTINATIONS;
+
+inline bool isGlobalModSource(ModSource source) {
+  return source == ModSource::Constant || source == ModSource::PitchWheel ||
+         source == ModSource::ModWheel || source == ModSource::GlobalLFO1 ||
+         source == ModSource::GlobalLFO2;
+}
+
+inline bool isGainModDestination(ModDestination destination) {
+  return destination == ModDestination::Amplitude ||
+         destination == ModDestination::MasterGain;
+}
+
+// Names used by the IPC commands
+inline const char *getModSourceName(ModSource source) {
+  static constexpr const char *names[NUM_MOD_SOURCES] = {
+      "constant", "lfo1",  "lfo2",     "env1",     "env2",      "velocity",
+      "key",      "pitchwheel", "modwheel", "globallfo1", "globallfo2"};
+  return names[static_cast<int>(source)];
+}
+
+inline const char *getModDestinationName(ModDestination destination) {
+  static constexpr const char *names[NUM_MOD_DESTINATIONS] = {
+      "pitch", "amplitude", "pulsewidth", "cutoff", "mastergain", "fxmix"};
+  return names[static_cast<int>(destination)];
+}
+
+// Name lookups; NumSources / NumDestinations if the name is unknown
+inline ModSource findModSource(const juce::String &name) {
+  for (int i = 0; i < NUM_MOD_SOURCES; ++i)
+    if (name == getModSourceName(static_cast<ModSource>(i)))
+      return static_cast<ModSource>(i);
+  return ModSource::NumSources;
+}
+
+inline ModDestination findModDestination(const juce::String &name) {
+  for (int i = 0; i < NUM_MOD_DESTINATIONS; ++i)
+    if (name == getModDestinationName(static_cast<ModDestination>(i)))
+      return static_cast<ModDestination>(i);
+  return ModDestination::NumDestinations;
+}
+
+enum class LFOShape { Sine, Triangle, Saw, Square, SampleAndHold };
+
+struct LFOSettings {
+  LFOShape shape = LFOShape::Sine;
+  float rateHz = 5.0f;
+};
+
+// Times in seconds; decay and release are exponential, the times are
+// roughly how long they take to settle
+struct EnvelopeSettings {
+  float attack = 0.01f;
+  float decay = 0.3f;
+  float sustain = 0.7f;
+  float release = 0.3f;
+};
+
+struct ModRoute {
+  ModSource source = ModSource::Constant;
+  ModDestination destination = ModDestination::Pitch;
+  float amount = 0.0f;
+  ModSource via = ModSource::Constant; // scales the source, e.g. mod wheel
+};
+
+struct ModMatrixSettings {
+  std::array<LFOSettings, NUM_MOD_LFOS> voiceLFOs;
+  std::array<LFOSettings, NUM_MOD_LFOS> globalLFOs;
+  std::array<EnvelopeSettings, NUM_MOD_ENVELOPES> envelopes;
+  std::vector<ModRoute> routes;
+  int controlInterval = 32; // samples per tick, 8..256
+
+  // Pitch wheel bends +-2 semitones; the mod wheel fades in vibrato
+  static ModMatrixSettings createDefault() {
+    ModMatrixSettings settings;
+    settings.voiceLFOs[0].rateHz = 5.5f;
+    settings.routes.push_back(
+        {ModSource::PitchWheel, ModDestination::Pitch, 2.0f});
+    settings.routes.push_back({ModSource::VoiceLFO1, ModDestination::Pitch,
+                               0.5f, ModSource::ModWheel});
+    return settings;
+  }
+};
+
+// ============================================================================
+// Compiled, immutable routing program
+// ============================================================================
+class ModProgram final : public juce::ReferenceCountedObject {
+public:
+  using Ptr = juce::ReferenceCountedObjectPtr<ModProgram>;
+
+  static constexpr int MIN_CONTROL_INTERVAL = 8;
+  static constexpr int MAX_CONTROL_INTERVAL = 256;
+
+  enum class OpKind : uint8_t { Add, Scale };
+
+  struct Op {
+    OpKind kind;
+    uint8_t source;
+    uint8_t via;
+    uint8_t destination;
+    float amount;
+  };
+
+  explicit ModProgram(const ModMatrixSettings &settings)
+      : voiceLFOs(settings.voiceLFOs), globalLFOs(settings.globalLFOs),
+        envelopes(settings.envelopes),
+        controlInterval(juce::jlimit(MIN_CONTROL_INTERVAL,
+                                     MAX_CONTROL_INTERVAL,
+                                     settings.controlInterval)) {
+    for (int d = 0; d < NUM_MOD_DESTINATIONS; ++d) {
+      const auto destination = static_cast<ModDestination>(d);
+      for (const auto &route : settings.routes)
+        if (route.destination == destination)
+          addOp(route);
+    }
+  }
+
+  const Op *getVoiceOps() const { return voiceOps.data(); }
+  int getNumVoiceOps() const { return numVoiceOps; }
+  const Op *getGlobalOps() const { return globalOps.data(); }
+  int getNumGlobalOps() const { return numGlobalOps; }
+
+  bool isRouted(ModDestination destination) const {
+    return routed[static_cast<size_t>(destination)];
+  }
+
+  // Envelopes feeding the amplitude (bit per envelope); while one of them
+  // is releasing, the voice's note-off tail is theirs
+  uint32_t getAmplitudeEnvelopeMask() const { return amplitudeEnvelopes; }
+
+  const std::array<LFOSettings, NUM_MOD_LFOS> voiceLFOs;
+  const std::array<LFOSettings, NUM_MOD_LFOS> globalLFOs;
+  const std::array<EnvelopeSettings, NUM_MOD_ENVELOPES> envelopes;
+  const int controlInterval;
+
+private:
+  void addOp(const ModRoute &route) {
+    const bool global = static_cast<int>(route.destination) >=
+                        NUM_VOICE_MOD_DESTINATIONS;
+    if (route.amount == 0.0f || route.source == ModSource::NumSources ||
+        route.via == ModSource::NumSources ||
+        route.destination == ModDestination::NumDestinations)
+      return;
+
+    // The output stage has no voice to read a per-voice source from
+    if (global &&
+        (!isGlobalModSource(route.source) || !isGlobalModSource(route.via)))
+      return;
+
+    auto &ops = global ? globalOps : voiceOps;
+    auto &numOps = global ? numGlobalOps : numVoiceOps;
+    if (numOps == MAX_MOD_ROUTES)
+      return;
+
+    ops[static_cast<size_t>(numOps++)] = {
+        isGainModDestination(route.destination) ? OpKind::Scale : OpKind::Add,
+        static_cast<uint8_t>(route.source), static_cast<uint8_t>(route.via),
+        static_cast<uint8_t>(route.destination), route.amount};
+    routed[static_cast<size_t>(route.destination)] = true;
+
+    if (route.destination == ModDestination::Amplitude) {
+      for (auto source : {route.source, route.via}) {
+        if (source == ModSource::Envelope1)
+          amplitudeEnvelopes |= 1u;
+        else if (source == ModSource::Envelope2)
+          amplitudeEnvelopes |= 2u;
+      }
+    }
+  }
+
+  std::array<Op, MAX_MOD_ROUTES> voiceOps{};
+  std::array<Op, MAX_MOD_ROUTES> globalOps{};
+  int numVoiceOps = 0;
+  int numGlobalOps = 0;
+  std::array<bool, NUM_MOD_DESTINATIONS> routed{};
+  uint32_t amplitudeEnvelopes = 0;
+};
+
+// ============================================================================
+// Per-voice results of one render call, read by the oscillator bank.
+// Row r of tick t for destination d is at values[d][t * stride + r]; each
+// tick's values are the targets for its last sample.
+// ============================================================================
+struct VoiceModulation {
+  const float *pitchRatio = nullptr;
+  const float *gain = nullptr;
+  const float *pulseWidthOffset = nullptr;
+  const float *cutoffRatio = nullptr;
+  int stride = MAX_MOD_VOICES;
+  int numRows = 0; // rows past this are unmodulated
+  int tickLength = 0;
+  int numSamples = 0;
+
+  int getTickEnd(int tick) const {
+    return juce::jmin((tick + 1) * tickLength, numSamples);
+  }
+};
+
+// ============================================================================
+// Modulation Matrix
+// ============================================================================
+class ModMatrix {
+public:
+  ModMatrix()
+      : defaultProgram(new ModProgram(ModMatrixSettings::createDefault())),
+        program(defaultProgram) {
+    reset();
+  }
+
+  // ========================================================================
+  // Setup (message thread, before playback)
+  // ========================================================================
+  void prepare(double sampleRate, int maxBlockSize) {
+    this->sampleRate = sampleRate;
+    maxTicks = (juce::jmax(1, maxBlockSize) +
+                ModProgram::MIN_CONTROL_INTERVAL - 1) /
+               ModProgram::MIN_CONTROL_INTERVAL;
+
+    voiceOutput.assign(static_cast<size_t>(NUM_VOICE_MOD_DESTINATIONS) *
+                           maxTicks * MAX_MOD_VOICES,
+                       0.0f);
+    globalOutput.assign(static_cast<size_t>(NUM_GLOBAL_MOD_DESTINATIONS) *
+                            maxTicks,
+                        0.0f);
+    reset();
+  }
+
+  void reset() {
+    resetVoices();
+    resetGlobal();
+    globalPitchWheel = 0.0f;
+    globalModWheel = 0.0f;
+    globalResetPending.store(false, std::memory_order_relaxed);
+  }
+
+  // State the voices use; the caller holds the synth lock, so no voice is
+  // rendering
+  void resetVoices() {
+    for (int v = 0; v < MAX_MOD_VOICES; ++v)
+      clearVoice(v);
+
+    voiceGlobalLFOPhase.fill(0.0f);
+    voiceGlobalLFOHeld.fill(0.0f);
+    voiceGlobalRandom = 1u;
+    constantRow.fill(1.0f);
+  }
+
+  // The output stage's state belongs to the audio thread outside the synth
+  // lock, so it is reset at the start of the next processGlobal() instead
+  void requestGlobalReset() {
+    globalResetPending.store(true, std::memory_order_release);
+  }
+
+  // Audio thread; the caller keeps the program alive (release pool), so
+  // replacing it here never deletes anything
+  void setProgram(ModProgram *newProgram) {
+    if (newProgram != nullptr)
+      program = newProgram;
+  }
+
+  const ModProgram &getProgram() const { return *program; }
+
+  // ========================================================================
+  // Voice control (audio thread). Voices are addressed by a row index
+  // below MAX_MOD_VOICES, e.g. the synth voice's index in its family.
+  // ========================================================================
+  void startVoice(int row, int midiNoteNumber, float velocity,
+                  int pitchWheelPosition) {
+    if (row < 0 || row >= MAX_MOD_VOICES)
+      return;
+
+    active[row] = 1;
+    this->velocity[row] = velocity;
+    keyTrack[row] = static_cast<float>(midiNoteNumber - 60) / 60.0f;
+    pitchWheel[row] = pitchWheelToUnit(pitchWheelPosition);
+    modWheel[row] = globalModWheel;
+
+    for (int k = 0; k < NUM_MOD_LFOS; ++k) {
+      lfoPhase[k][row] = 0.0f;
+      lfoHeld[k][row] = nextRandom(randomState[row]);
+    }
+    for (int k = 0; k < NUM_MOD_ENVELOPES; ++k) {
+      envelopeLevel[k][row] = 0.0f;
+      envelopeStage[k][row] = attackStage;
+    }
+  }
+
+  void releaseVoice(int row) {
+    if (!isRowActive(row))
+      return;
+    for (int k = 0; k < NUM_MOD_ENVELOPES; ++k)
+      if (envelopeStage[k][row] != idleStage)
+        envelopeStage[k][row] = releaseStage;
+  }
+
+  void stopVoice(int row) {
+    if (isRowActive(row))
+      active[row] = 0;
+  }
+
+  // True once every envelope feeding the amplitude has finished its
+  // release; always true if the program has none
+  bool isAmplitudeReleaseFinished(int row) const {
+    if (!isRowActive(row))
+      return true;
+
+    const uint32_t mask = program->getAmplitudeEnvelopeMask();
+    for (int k = 0; k < NUM_MOD_ENVELOPES; ++k)
+      if ((mask & (1u << k)) != 0 && envelopeStage[k][row] != idleStage)
+        return false;
+    return true;
+  }
+
+  void setPitchWheel(int row, int pitchWheelPosition) {
+    if (isRowActive(row))
+      pitchWheel[row] = pitchWheelToUnit(pitchWheelPosition);
+  }
+
+  void setController(int row, int controllerNumber, int value) {
+    if (isRowActive(row) && controllerNumber == MOD_WHEEL_CONTROLLER)
+      modWheel[row] = static_cast<float>(value) / 127.0f;
+  }
+
+  // Last values on any channel; the global sources, and what new voices'
+  // mod wheel starts at
+  void setGlobalPitchWheel(int pitchWheelPosition) {
+    globalPitchWheel = pitchWheelToUnit(pitchWheelPosition);
+  }
+
+  void setGlobalController(int controllerNumber, int value) {
+    if (controllerNumber == MOD_WHEEL_CONTROLLER)
+      globalModWheel = static_cast<float>(value) / 127.0f;
+  }
+
+  // ========================================================================
+  // Per-voice ticks for the next numSamples (audio thread). Longer calls
+  // than prepared for stretch the ticks rather than allocate. nullptr
+  // before prepare().
+  // ========================================================================
+  const VoiceModulation *processVoices(int numSamples) {
+    if (voiceOutput.empty() || numSamples <= 0)
+      return nullptr;
+
+    const int interval = getTickLength(numSamples);
+    const int numTicks = (numSamples + interval - 1) / interval;
+
+    // Rows up to the highest active voice, padded to whole lane groups
+    int numRows = 0;
+    for (int v = MAX_MOD_VOICES - 1; v >= 0 && numRows == 0; --v)
+      if (active[v] != 0)
+        numRows = v + 1;
+    numRows = (numRows + VOICE_LANES - 1) / VOICE_LANES * VOICE_LANES;
+
+    const size_t tickStride = static_cast<size_t>(maxTicks) * MAX_MOD_VOICES;
+    float *pitchOut = voiceOutput.data();
+    float *gainOut = pitchOut + tickStride;
+    float *widthOut = gainOut + tickStride;
+    float *cutoffOut = widthOut + tickStride;
+
+    for (int t = 0; t < numTicks && numRows > 0; ++t) {
+      const int length = juce::jmin(interval, numSamples - t * interval);
+      advanceVoiceSources(numRows, length);
+
+      const size_t offset = static_cast<size_t>(t) * MAX_MOD_VOICES;
+      float *rows[NUM_VOICE_MOD_DESTINATIONS] = {
+          pitchOut + offset, gainOut + offset, widthOut + offset,
+          cutoffOut + offset};
+      std::fill(rows[0], rows[0] + numRows, 0.0f);
+      std::fill(rows[1], rows[1] + numRows, 1.0f);
+      std::fill(rows[2], rows[2] + numRows, 0.0f);
+      std::fill(rows[3], rows[3] + numRows, 0.0f);
+
+      runVoiceOps(rows, numRows);
+
+      // Semitones to frequency ratios; gains never go negative
+      for (int v = 0; v < numRows; ++v) {
+        rows[0][v] = std::exp2(rows[0][v] * (1.0f / 12.0f));
+        rows[1][v] = juce::jmax(0.0f, rows[1][v]);
+        rows[3][v] = std::exp2(rows[3][v] * (1.0f / 12.0f));
+      }
+    }
+
+    voiceModulation.pitchRatio = pitchOut;
+    voiceModulation.gain = gainOut;
+    voiceModulation.pulseWidthOffset = widthOut;
+    voiceModulation.cutoffRatio = cutoffOut;
+    voiceModulation.numRows = numRows;
+    voiceModulation.tickLength = interval;
+    voiceModulation.numSamples = numSamples;
+    return &voiceModulation;
+  }
+
+  // ========================================================================
+  // Global destinations for the next numSamples (audio thread)
+  // ========================================================================
+  void processGlobal(int numSamples) {
+    if (globalResetPending.load(std::memory_order_relaxed) &&
+        globalResetPending.exchange(false, std::memory_order_acquire))
+      resetGlobal();
+
+    if (globalOutput.empty() || numSamples <= 0) {
+      globalTicks = 0;
+      return;
+    }
+
+    const int interval = getTickLength(numSamples);
+    globalTickLength = interval;
+    globalTicks = (numSamples + interval - 1) / interval;
+    globalSamples = numSamples;
+
+    for (int t = 0; t < globalTicks; ++t) {
+      const int length = juce::jmin(interval, numSamples - t * interval);
+
+      float sources[NUM_MOD_SOURCES] = {};
+      sources[static_cast<int>(ModSource::Constant)] = 1.0f;
+      sources[static_cast<int>(ModSource::PitchWheel)] = globalPitchWheel;
+      sources[static_cast<int>(ModSource::ModWheel)] = globalModWheel;
+      for (int k = 0; k < NUM_MOD_LFOS; ++k) {
+        sources[static_cast<int>(ModSource::GlobalLFO1) + k] =
+            advanceLFO(program->globalLFOs[k], globalLFOPhase[k],
+                       globalLFOHeld[k], globalRandom, length);
+      }
+
+      float masterGain = 1.0f;
+      float fxMix = 0.0f;
+      const auto *ops = program->getGlobalOps();
+      for (int i = 0; i < program->getNumGlobalOps(); ++i) {
+        const auto &op = ops[i];
+        const float x = sources[op.source] * sources[op.via];
+        if (op.kind == ModProgram::OpKind::Scale)
+          masterGain *= 1.0f + op.amount * (x - 1.0f);
+        else
+          fxMix += op.amount * x;
+      }
+
+      globalOutput[static_cast<size_t>(t)] = juce::jmax(0.0f, masterGain);
+      globalOutput[static_cast<size_t>(maxTicks + t)] =
+          juce::jlimit(0.0f, 1.0f, 1.0f + fxMix);
+    }
+  }
+
+  // Audio-rate values of a global destination across the last
+  // processGlobal() call, ramping linearly from tick to tick. The master
+  // gain is a multiplier; the FX mix is the wet share (1 = fully wet).
+  void fillGlobalRamp(ModDestination destination, float *output) {
+    const int d = static_cast<int>(destination) - NUM_VOICE_MOD_DESTINATIONS;
+    if (d < 0 || d >= NUM_GLOBAL_MOD_DESTINATIONS)
+      return;
+
+    const float *targets = globalOutput.data() + static_cast<size_t>(d) *
+                                                     maxTicks;
+    float value = globalRampStart[static_cast<size_t>(d)];
+    int i = 0;
+    for (int t = 0; t < globalTicks; ++t) {
+      const int end = juce::jmin((t + 1) * globalTickLength, globalSamples);
+      const float step = (targets[t] - value) / static_cast<float>(end - i);
+      for (; i < end; ++i) {
+        value += step;
+        output[i] = value;
+      }
+      value = targets[t];
+    }
+    globalRampStart[static_cast<size_t>(d)] = value;
+  }
+
+private:
+  static constexpr int MOD_WHEEL_CONTROLLER = 1;
+
+  void resetGlobal() {
+    globalLFOPhase.fill(0.0f);
+    globalLFOHeld.fill(0.0f);
+    globalRandom = 1u;
+    globalTicks = 0;
+    globalRampStart.fill(1.0f);
+  }
+
+  enum : int32_t {
+    idleStage,
+    attackStage,
+    decayStage,
+    sustainStage,
+    releaseStage
+  };
+
+  using RowArray = std::array<float, MAX_MOD_VOICES>;
+
+  bool isRowActive(int row) const {
+    return row >= 0 && row < MAX_MOD_VOICES && active[row] != 0;
+  }
+
+  static float pitchWheelToUnit(int position) {
+    return juce::jlimit(-1.0f, 1.0f,
+                        static_cast<float>(position - 8192) / 8191.0f);
+  }
+
+  int getTickLength(int numSamples) const {
+    const int perTick = (numSamples + maxTicks - 1) / juce::jmax(1, maxTicks);
+    return juce::jmax(program->controlInterval, perTick);
+  }
+
+  // Uniform in [-1, 1)
+  static float nextRandom(uint32_t &state) {
+    state = state * 1664525u + 1013904223u;
+    return static_cast<float>(state >> 8) * (2.0f / 16777216.0f) - 1.0f;
+  }
+
+  // Advances one LFO by a tick and returns its value at the tick's end
+  float advanceLFO(const LFOSettings &settings, float &phase, float &held,
+                   uint32_t &random, int length) const {
+    const float next =
+        phase + settings.rateHz * static_cast<float>(length / sampleRate);
+    if (next >= 1.0f)
+      held = nextRandom(random);
+    phase = FastMath::wrapPhaseFull(next);
+    return evaluateLFO(settings.shape, phase, held);
+  }
+
+  static float evaluateLFO(LFOShape shape, float phase, float held) {
+    switch (shape) {
+    case LFOShape::Triangle:
+      return 1.0f - 4.0f * std::abs(phase - 0.5f);
+    case LFOShape::Saw:
+      return 2.0f * phase - 1.0f;
+    case LFOShape::Square:
+      return phase < 0.5f ? 1.0f : -1.0f;
+    case LFOShape::SampleAndHold:
+      return held;
+    case LFOShape::Sine:
+    default:
+      return FastMath::sinCycle(phase);
+    }
+  }
+
+  void advanceVoiceSources(int numRows, int length) {
+    const float seconds = static_cast<float>(length / sampleRate);
+
+    for (int k = 0; k < NUM_MOD_LFOS; ++k) {
+      const auto &settings = program->voiceLFOs[k];
+      for (int v = 0; v < numRows; ++v)
+        lfoValue[k][v] = advanceLFO(settings, lfoPhase[k][v], lfoHeld[k][v],
+                                    randomState[v], length);
+    }
+
+    for (int k = 0; k < NUM_MOD_ENVELOPES; ++k) {
+      const auto &settings = program->envelopes[k];
+      const float attackStep =
+          settings.attack > 0.0f ? seconds / settings.attack : 1.0f;
+      const float sustain = juce::jlimit(0.0f, 1.0f, settings.sustain);
+      const float decayCoeff = settlingCoeff(settings.decay, seconds);
+      const float releaseCoeff = settlingCoeff(settings.release, seconds);
+
+      auto &level = envelopeLevel[k];
+      auto &stage = envelopeStage[k];
+      for (int v = 0; v < numRows; ++v) {
+        switch (stage[v]) {
+        case attackStage:
+          level[v] += attackStep;
+          if (level[v] >= 1.0f) {
+            level[v] = 1.0f;
+            stage[v] = decayStage;
+          }
+          break;
+        case decayStage:
+          level[v] = sustain + (level[v] - sustain) * decayCoeff;
+          if (std::abs(level[v] - sustain) < ENVELOPE_FLOOR) {
+            level[v] = sustain;
+            stage[v] = sustainStage;
+          }
+          break;
+        case releaseStage:
+          level[v] *= releaseCoeff;
+          if (level[v] < ENVELOPE_FLOOR) {
+            level[v] = 0.0f;
+            stage[v] = idleStage;
+          }
+          break;
+        default:
+          break;
+        }
+      }
+    }
+
+    for (int k = 0; k < NUM_MOD_LFOS; ++k) {
+      const float value =
+          advanceLFO(program->globalLFOs[k], voiceGlobalLFOPhase[k],
+                     voiceGlobalLFOHeld[k], voiceGlobalRandom, length);
+      std::fill(globalLFORow[k].begin(), globalLFORow[k].begin() + numRows,
+                value);
+    }
+  }
+
+  // Exponential segment reaching ENVELOPE_FLOOR of its distance in
+  // `time` seconds, as a per-tick multiplier
+  static float settlingCoeff(float time, float seconds) {
+    if (time <= 0.0f)
+      return 0.0f;
+    return std::exp(SETTLE_LOG * seconds / time);
+  }
+
+  // The flat program: one pass over the voices per route
+  void runVoiceOps(float *const *rows, int numRows) const {
+    const float *sources[NUM_MOD_SOURCES] = {
+        constantRow.data(),       lfoValue[0].data(),
+        lfoValue[1].data(),       envelopeLevel[0].data(),
+        envelopeLevel[1].data(),  velocity.data(),
+        keyTrack.data(),          pitchWheel.data(),
+        modWheel.data(),          globalLFORow[0].data(),
+        globalLFORow[1].data()};
+
+    const auto *ops = program->getVoiceOps();
+    for (int i = 0; i < program->getNumVoiceOps(); ++i) {
+      const auto &op = ops[i];
+      const float *x = sources[op.source];
+      const float *via = sources[op.via];
+      float *out = rows[op.destination];
+      const float amount = op.amount;
+
+      if (op.kind == ModProgram::OpKind::Scale) {
+        for (int v = 0; v < numRows; ++v)
+          out[v] *= 1.0f + amount * (x[v] * via[v] - 1.0f);
+      } else {
+        for (int v = 0; v < numRows; ++v)
+          out[v] += amount * x[v] * via[v];
+      }
+    }
+  }
+
+  void clearVoice(int row) {
+    active[row] = 0;
+    velocity[row] = 0.0f;
+    keyTrack[row] = 0.0f;
+    pitchWheel[row] = 0.0f;
+    modWheel[row] = 0.0f;
+    randomState[row] = 0x9e3779b9u * static_cast<uint32_t>(row + 1);
+    for (int k = 0; k < NUM_MOD_LFOS; ++k) {
+      lfoPhase[k][row] = 0.0f;
+      lfoHeld[k][row] = 0.0f;
+      lfoValue[k][row] = 0.0f;
+    }
+    for (int k = 0; k < NUM_MOD_ENVELOPES; ++k) {
+      envelopeLevel[k][row] = 0.0f;
+      envelopeStage[k][row] = idleStage;
+    }
+  }
+
+  static constexpr float ENVELOPE_FLOOR = 1.0e-4f;
+  static constexpr float SETTLE_LOG = -9.21034f; // ln(ENVELOPE_FLOOR)
+
+  ModProgram::Ptr defaultProgram; // held for good, see setProgram()
+  ModProgram::Ptr program;
+  double sampleRate = 44100.0;
+
+  // Per-voice state (one row per voice)
+  std::array<uint8_t, MAX_MOD_VOICES> active{};
+  RowArray velocity{};
+  RowArray keyTrack{};
+  RowArray pitchWheel{};
+  RowArray modWheel{};
+  RowArray constantRow{};
+  std::array<uint32_t, MAX_MOD_VOICES> randomState{};
+  std::array<RowArray, NUM_MOD_LFOS> lfoPhase{};
+  std::array<RowArray, NUM_MOD_LFOS> lfoHeld{};
+  std::array<RowArray, NUM_MOD_LFOS> lfoValue{};
+  std::array<RowArray, NUM_MOD_ENVELOPES> envelopeLevel{};
+  std::array<std::array<int32_t, MAX_MOD_VOICES>, NUM_MOD_ENVELOPES>
+      envelopeStage{};
+
+  // Global LFOs as seen by the voices (advanced with the voice ticks) and
+  // by the output stage (advanced with the global ticks)
+  std::array<RowArray, NUM_MOD_LFOS> globalLFORow{};
+  std::array<float, NUM_MOD_LFOS> voiceGlobalLFOPhase{};
+  std::array<float, NUM_MOD_LFOS> voiceGlobalLFOHeld{};
+  uint32_t voiceGlobalRandom = 1u;
+  std::array<float, NUM_MOD_LFOS> globalLFOPhase{};
+  std::array<float, NUM_MOD_LFOS> globalLFOHeld{};
+  uint32_t globalRandom = 1u;
+  float globalPitchWheel = 0.0f;
+  float globalModWheel = 0.0f;
+  std::atomic<bool> globalResetPending{false};
+
+  // Tick outputs (allocated in prepare)
+  std::vector<float> voiceOutput;  // [destination][tick][row]
+  std::vector<float> globalOutput; // [destination][tick]
+  int maxTicks = 1;
+  VoiceModulation voiceModulation;
+
+  int globalTicks = 0;
+  int globalTickLength = 1;
+  int globalSamples = 0;
+  std::array<float, NUM_GLOBAL_MOD_DESTINATIONS> globalRampStart{};
+};
+
+} // namespace Synth
+} // namespace Sphere
@@ -0,0 +1,801 @@
+/*
+  ==============================================================================
+    SphereOscillatorBank.h
+    Structure-of-arrays oscillator bank rendering all synth voices at once
+
+    Phase, increment, level, pan and release tail for every oscillator live
+    in contiguous lane arrays. Oscillators are processed VOICE_LANES at a
+    time; each lane group is folded to its own stereo buffer, and the group
+    buffers are summed in group order and added to the output with one
+    vector operation per channel. Oscillators whose tail has decayed below
+    the cutoff are culled automatically.
+
+    Slots are handed out on demand (lowest free slot first, so active slots
+    stay packed into few groups). A synth voice may own several of them -
+    a 16-voice unison stack is 16 lanes, i.e. the arithmetic of 16
+    oscillators rather than 16 separately dispatched voices.
+
+    Groups are independent, so with a RealtimeWorkerPool attached they are
+    rendered in parallel. Because every group has its own output buffer and
+    the final sum always runs in the same order, the result is bit-identical
+    for any number of worker threads.
+
+    Wavetable voices read band-limited mip levels from a WavetableSet; the
+    level is chosen from the voice's increment when the note starts.
+    Hard-synced voices run a second (master) phase per lane that resets the
+    audible phase, with a PolyBLEP correction sized to the actual jump.
+
+    Given the modulation matrix's per-voice ticks, each lane ramps its
+    pitch ratio, gain and pulse width offset linearly from tick to tick,
+    reading the row of the voice that owns it (detached lanes hold their
+    last values).
+
+    Each lane can run its output through a resonant state-variable filter
+    before its gain. Groups without a filtered lane skip it entirely; in
+    the others the filter coefficients follow the modulated cutoff once
+    per tick.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../Common/SphereWorkerPool.h"
+#include "SphereModMatrix.h"
+#include "SphereOscillatorKernels.h"
+#include "SphereVoiceFilter.h"
+#include <vector>
+
+namespace Sphere {
+namespace Synth {
+
+// ============================================================================
+// Oscillator Bank
+// ============================================================================
+class OscillatorBank {
+public:
+  OscillatorBank() { reset(); }
+
+  // ========================================================================
+  // Prepare scratch buffers (message thread, before playback)
+  // ========================================================================
+  void prepare(int maxBlockSize) {
+    this->maxBlockSize = juce::jmax(1, maxBlockSize);
+    const auto blockSize = static_cast<size_t>(this->maxBlockSize);
+
+    // One lane scratch per thread that can render a group
+    laneScratch.assign(blockSize * VOICE_LANES *
+                           RealtimeWorkerPool::getMaxThreads(),
+                       0.0f);
+    groupMix.assign(blockSize * 2 * MAX_VOICE_GROUPS, 0.0f);
+    stereoMix.assign(blockSize * 2, 0.0f);
+    reset();
+  }
+
+  // Optional; nullptr renders every group on the calling thread
+  void setWorkerPool(RealtimeWorkerPool *poolToUse) { workerPool = poolToUse; }
+
+  void reset() {
+    for (int i = 0; i < MAX_BANK_VOICES; ++i)
+      clearSlot(i);
+
+    groupActiveCount.fill(0);
+    activeBits.fill(0);
+    numActiveVoices = 0;
+  }
+
+  // ========================================================================
+  // Slot allocation (audio thread)
+  // ========================================================================
+
+  // Claims the lowest free slot for an owner (any id >= 0); the slot stays
+  // silent until started. Returns -1 if every slot is in use by an owner.
+  int allocateSlot(int owner) {
+    int slot = findFreeSlot();
+
+    // Out of slots: cut short a fading slot nobody owns any more
+    if (slot < 0)
+      slot = findDetachedSlot();
+    if (slot < 0)
+      return -1;
+
+    clearSlot(slot);
+    setActive(slot, true);
+    owners[slot] = owner;
+    return slot;
+  }
+
+  int getSlotOwner(int slot) const {
+    return isVoiceActive(slot) ? owners[slot] : -1;
+  }
+
+  // ========================================================================
+  // Voice control (audio thread)
+  // ========================================================================
+  void startVoice(int slot, WaveShape shape, double cyclesPerSample,
+                  float velocity, float width = 0.5f, float syncRatio = 1.0f) {
+    if (slot < 0 || slot >= MAX_BANK_VOICES)
+      return;
+
+    // With hard sync the master runs at the note pitch and the audible
+    // (slave) oscillator at syncRatio times that
+    const bool synced = syncRatio > 1.0001f;
+    const double slaveCycles =
+        cyclesPerSample * (synced ? static_cast<double>(syncRatio) : 1.0);
+
+    phase[slot] = 0.0f;
+    increment[slot] = static_cast<float>(slaveCycles);
+    invIncrement[slot] =
+        slaveCycles > 0.0 ? static_cast<float>(1.0 / slaveCycles) : 0.0f;
+    pulseWidth[slot] = juce::jlimit(0.01f, 0.99f, width);
+
+    syncEnabled[slot] = synced ? 1 : 0;
+    masterPhase[slot] = 0.0f;
+    masterIncrement[slot] = static_cast<float>(cyclesPerSample);
+    invMasterIncrement[slot] =
+        cyclesPerSample > 0.0 ? static_cast<float>(1.0 / cyclesPerSample)
+                              : 0.0f;
+    syncPending[slot] = 0.0f;
+
+    level[slot] = velocity * VOICE_LEVEL_SCALE;
+    panLeft[slot] = 1.0f;
+    panRight[slot] = 1.0f;
+    envelope[slot] = 1.0f;
+    envelopeCoeff[slot] = 1.0f;
+    shapes[slot] = static_cast<int32_t>(shape);
+    wavetables[slot] = nullptr;
+    setActive(slot, true);
+  }
+
+  // The table must outlive the voice (the playing sound holds a reference)
+  void startWavetableVoice(int slot, const WavetableSet &table,
+                           float tablePosition, double cyclesPerSample,
+                           float velocity, float syncRatio = 1.0f) {
+    startVoice(slot, WaveShape::Wavetable, cyclesPerSample, velocity, 0.5f,
+               syncRatio);
+    if (!isVoiceActive(slot))
+      return;
+
+    wavetables[slot] = &table;
+    mipLevels[slot] = WavetableSet::getMipLevelForIncrement(increment[slot]);
+    setWavetablePosition(slot, tablePosition);
+  }
+
+  // Morph position across the table's frames, 0..1
+  void setWavetablePosition(int slot, float position) {
+    if (!isVoiceActive(slot) || wavetables[slot] == nullptr)
+      return;
+
+    const auto &table = *wavetables[slot];
+    const float framePos =
+        juce::jlimit(0.0f, 1.0f, position) *
+        static_cast<float>(table.getNumFrames() - 1);
+    const int frame = static_cast<int>(framePos);
+
+    frameA[slot] = table.getFrame(mipLevels[slot], frame);
+    frameB[slot] = table.getFrame(mipLevels[slot], frame + 1);
+    morph[slot] = framePos - static_cast<float>(frame);
+  }
+
+  // Pulse width of a playing square voice (0.5 = square)
+  void setVoicePulseWidth(int slot, float width) {
+    if (isVoiceActive(slot))
+      pulseWidth[slot] = juce::jlimit(0.01f, 0.99f, width);
+  }
+
+  // Balance law: -1 = left only, 0 = both channels at unity, 1 = right only
+  void setVoicePan(int slot, float pan) {
+    if (!isVoiceActive(slot))
+      return;
+
+    const float p = juce::jlimit(-1.0f, 1.0f, pan);
+    panLeft[slot] = juce::jmin(1.0f, 1.0f - p);
+    panRight[slot] = juce::jmin(1.0f, 1.0f + p);
+  }
+
+  // Filter ahead of the voice's gain. Cutoff in cycles per sample (any key
+  // tracking already applied), resonance as Q.
+  void setVoiceFilter(int slot, FilterMode mode, double cutoffCyclesPerSample,
+                      float resonance = VoiceFilter::DEFAULT_RESONANCE) {
+    if (!isVoiceActive(slot))
+      return;
+
+    filterModes[slot] = static_cast<int32_t>(mode);
+    filterCutoff[slot] = static_cast<float>(cutoffCyclesPerSample);
+    filterDamping[slot] = VoiceFilter::getDamping(resonance);
+  }
+
+  // Start phase in cycles, e.g. to decorrelate unison oscillators
+  void setVoicePhase(int slot, float startPhase) {
+    if (isVoiceActive(slot))
+      phase[slot] = FastMath::wrapPhase(startPhase);
+  }
+
+  // Begin the release tail (no-op if the voice is already releasing)
+  void releaseVoice(int slot) {
+    if (isVoiceActive(slot) && envelopeCoeff[slot] == 1.0f)
+      envelopeCoeff[slot] = TAIL_OFF_COEFF;
+  }
+
+  // Short fade used when a voice is stolen; faster than the release tail.
+  // The slot no longer belongs to its owner and frees itself when silent.
+  void fadeOutVoice(int slot) {
+    if (isVoiceActive(slot)) {
+      envelopeCoeff[slot] = juce::jmin(envelopeCoeff[slot], STEAL_FADE_COEFF);
+      owners[slot] = -1;
+    }
+  }
+
+  // Hard stop without a tail
+  void killVoice(int slot) {
+    if (slot < 0 || slot >= MAX_BANK_VOICES)
+      return;
+
+    setActive(slot, false);
+    clearSlot(slot);
+  }
+
+  bool isVoiceActive(int slot) const {
+    return slot >= 0 && slot < MAX_BANK_VOICES && active[slot] != 0;
+  }
+
+  int getNumActiveVoices() const { return numActiveVoices; }
+
+  float getVoiceLevel(int slot) const {
+    return isVoiceActive(slot)
+               ? level[slot] * envelope[slot] * modGain[slot]
+               : 0.0f;
+  }
+
+  // ========================================================================
+  // Render all active voices and add them to the buffer: left to channel 0,
+  // right to the others, or their average to a mono buffer. The optional
+  // modulation covers exactly these numSamples.
+  // ========================================================================
+  void render(juce::AudioBuffer<float> &buffer, int startSample,
+              int numSamples, const VoiceModulation *modulation = nullptr) {
+    if (numActiveVoices == 0 || stereoMix.empty())
+      return;
+
+    chunkModulation = modulation;
+    chunkOffset = 0;
+    while (chunkOffset < numSamples) {
+      const int chunk = juce::jmin(numSamples - chunkOffset, maxBlockSize);
+      renderChunk(buffer, startSample + chunkOffset, chunk);
+      chunkOffset += chunk;
+    }
+    chunkModulation = nullptr;
+  }
+
+private:
+  void renderChunk(juce::AudioBuffer<float> &buffer, int startSample,
+                   int numSamples) {
+    numRenderGroups = 0;
+    for (int g = 0; g < MAX_VOICE_GROUPS; ++g) {
+      if (groupActiveCount[g] != 0)
+        renderGroups[numRenderGroups++] = g;
+    }
+
+    chunkSamples = numSamples;
+    if (workerPool != nullptr)
+      workerPool->run(numRenderGroups, &renderGroupTask, this);
+    else
+      for (int t = 0; t < numRenderGroups; ++t)
+        renderGroupTask(this, t, 0);
+
+    // Fixed-order mixdown; culling touches shared counters, so it runs
+    // here rather than in the (possibly parallel) group tasks
+    float *mixL = stereoMix.data();
+    float *mixR = mixL + maxBlockSize;
+    juce::FloatVectorOperations::clear(mixL, numSamples);
+    juce::FloatVectorOperations::clear(mixR, numSamples);
+    for (int t = 0; t < numRenderGroups; ++t) {
+      const int g = renderGroups[t];
+      juce::FloatVectorOperations::add(mixL, getGroupMix(g, 0), numSamples);
+      juce::FloatVectorOperations::add(mixR, getGroupMix(g, 1), numSamples);
+      cullGroup(g);
+    }
+
+    const int numChannels = buffer.getNumChannels();
+    if (numChannels == 1) {
+      juce::FloatVectorOperations::add(mixL, mixR, numSamples);
+      juce::FloatVectorOperations::addWithMultiply(
+          buffer.getWritePointer(0, startSample), mixL, 0.5f, numSamples);
+      return;
+    }
+
+    for (int ch = 0; ch < numChannels; ++ch)
+      juce::FloatVectorOperations::add(buffer.getWritePointer(ch, startSample),
+                                       ch == 0 ? mixL : mixR, numSamples);
+  }
+
+  static void renderGroupTask(void *context, int taskIndex, int workerIndex) {
+    auto &bank = *static_cast<OscillatorBank *>(context);
+    const int g = bank.renderGroups[taskIndex];
+    float *scratch = bank.laneScratch.data() +
+                     static_cast<size_t>(workerIndex) * bank.maxBlockSize *
+                         VOICE_LANES;
+
+    const bool filtered = bank.isGroupFiltered(g);
+    if (bank.isGroupSynced(g)) {
+      if (filtered)
+        bank.renderGroupForShape<true, true>(g, scratch, bank.chunkSamples);
+      else
+        bank.renderGroupForShape<true, false>(g, scratch, bank.chunkSamples);
+    } else {
+      if (filtered)
+        bank.renderGroupForShape<false, true>(g, scratch, bank.chunkSamples);
+      else
+        bank.renderGroupForShape<false, false>(g, scratch, bank.chunkSamples);
+    }
+
+    // Fold the group's lanes to its own stereo buffer
+    alignas(SIMD_ALIGNMENT) float gainL[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float gainR[VOICE_LANES];
+    const int base = g * VOICE_LANES;
+    for (int l = 0; l < VOICE_LANES; ++l) {
+      gainL[l] = bank.panLeft[base + l];
+      gainR[l] = bank.panRight[base + l];
+    }
+
+    float *outL = bank.getGroupMix(g, 0);
+    float *outR = bank.getGroupMix(g, 1);
+    const float *mix = scratch;
+    for (int i = 0; i < bank.chunkSamples; ++i) {
+      float sumL = 0.0f;
+      float sumR = 0.0f;
+      for (int l = 0; l < VOICE_LANES; ++l) {
+        sumL += mix[l] * gainL[l];
+        sumR += mix[l] * gainR[l];
+      }
+      outL[i] = sumL;
+      outR[i] = sumR;
+      mix += VOICE_LANES;
+    }
+  }
+
+  float *getGroupMix(int g, int channel) {
+    return groupMix.data() +
+           static_cast<size_t>(g * 2 + channel) * maxBlockSize;
+  }
+
+  template <bool HardSync, bool Filtered>
+  void renderGroupForShape(int g, float *mix, int numSamples) {
+    using namespace OscillatorKernels;
+    switch (getGroupShapeMask(g)) {
+    case 1 << static_cast<int>(WaveShape::Sine):
+      renderGroup<Sine, HardSync, Filtered>(g, mix, numSamples);
+      break;
+    case 1 << static_cast<int>(WaveShape::Saw):
+      renderGroup<Saw, HardSync, Filtered>(g, mix, numSamples);
+      break;
+    case 1 << static_cast<int>(WaveShape::Square):
+      renderGroup<Square, HardSync, Filtered>(g, mix, numSamples);
+      break;
+    case 1 << static_cast<int>(WaveShape::Triangle):
+      renderGroup<Triangle, HardSync, Filtered>(g, mix, numSamples);
+      break;
+    case 1 << static_cast<int>(WaveShape::Wavetable):
+      renderGroup<Wavetable, HardSync, Filtered>(g, mix, numSamples);
+      break;
+    default:
+      renderGroup<Mixed, HardSync, Filtered>(g, mix, numSamples);
+      break;
+    }
+  }
+
+  // Writes the group's lane outputs (interleaved, VOICE_LANES per sample)
+  template <typename Kernel, bool HardSync, bool Filtered>
+  void renderGroup(int g, float *mix, int numSamples) {
+    // Pull the group into locals so the lane loop stays in registers
+    alignas(SIMD_ALIGNMENT) float p[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float gain[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float env[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float coeff[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float master[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float pending[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) int32_t synced[VOICE_LANES];
+    ModulationLanes modLanes;
+    OscillatorLanes lanes;
+    FilterLanes filter;
+
+    const int base = g * VOICE_LANES;
+    for (int l = 0; l < VOICE_LANES; ++l) {
+      p[l] = phase[base + l];
+      gain[l] = level[base + l];
+      env[l] = envelope[base + l];
+      coeff[l] = envelopeCoeff[base + l];
+      master[l] = masterPhase[base + l];
+      pending[l] = syncPending[base + l];
+      synced[l] = syncEnabled[base + l];
+      lanes.shape[l] = shapes[base + l];
+      lanes.frameA[l] = frameA[base + l];
+      lanes.frameB[l] = frameB[base + l];
+      lanes.morph[l] = morph[base + l];
+      modLanes.ratio[l] = modPitch[base + l];
+      modLanes.gain[l] = modGain[base + l];
+      modLanes.width[l] = modWidth[base + l];
+      modLanes.cutoff[l] = modCutoff[base + l];
+      filter.state1[l] = filterState1[base + l];
+      filter.state2[l] = filterState2[base + l];
+    }
+
+    // Segments end at tick boundaries; without modulation there is one
+    const VoiceModulation *mod = chunkModulation;
+    for (int start = 0; start < numSamples;) {
+      int end = numSamples;
+      bool reachesTarget = false;
+      if (mod != nullptr) {
+        const int tick = (chunkOffset + start) / mod->tickLength;
+        const int tickEnd = mod->getTickEnd(tick) - chunkOffset;
+        end = juce::jmin(numSamples, tickEnd);
+        reachesTarget = end == tickEnd;
+        setModulationTargets(g, *mod, tick, tickEnd - start, modLanes);
+      } else {
+        modLanes.clearSteps();
+      }
+
+      // BLEP widths use the segment's starting pitch, close enough for
+      // control-rate pitch changes
+      for (int l = 0; l < VOICE_LANES; ++l) {
+        lanes.invIncrement[l] = invIncrement[base + l] / modLanes.ratio[l];
+        modLanes.invMasterIncrement[l] =
+            invMasterIncrement[base + l] / modLanes.ratio[l];
+        modLanes.baseIncrement[l] = increment[base + l];
+        modLanes.baseMasterIncrement[l] = masterIncrement[base + l];
+        modLanes.baseWidth[l] = pulseWidth[base + l];
+      }
+
+      // The cutoff steps straight to the tick's value
+      if constexpr (Filtered) {
+        for (int l = 0; l < VOICE_LANES; ++l)
+          VoiceFilter::setCoefficients(
+              filter, l, filterModes[base + l],
+              filterCutoff[base + l] * modLanes.targetCutoff[l],
+              filterDamping[base + l]);
+      }
+
+      renderSegment<Kernel, HardSync, Filtered>(
+          lanes, modLanes, filter, p, gain, env, coeff, master, pending,
+          synced, mix + start * VOICE_LANES, end - start);
+
+      if constexpr (Filtered) {
+        for (int l = 0; l < VOICE_LANES; ++l)
+          VoiceFilter::flushDenormals(filter, l);
+      }
+
+      // Land exactly on the tick's values rather than accumulate ramp error
+      if (reachesTarget) {
+        for (int l = 0; l < VOICE_LANES; ++l) {
+          modLanes.ratio[l] = modLanes.targetRatio[l];
+          modLanes.gain[l] = modLanes.targetGain[l];
+          modLanes.width[l] = modLanes.targetWidth[l];
+          modLanes.cutoff[l] = modLanes.targetCutoff[l];
+        }
+      }
+      start = end;
+    }
+
+    for (int l = 0; l < VOICE_LANES; ++l) {
+      phase[base + l] = p[l];
+      envelope[base + l] = env[l];
+      masterPhase[base + l] = master[l];
+      syncPending[base + l] = pending[l];
+      modPitch[base + l] = modLanes.ratio[l];
+      modGain[base + l] = modLanes.gain[l];
+      modWidth[base + l] = modLanes.width[l];
+      modCutoff[base + l] = modLanes.cutoff[l];
+      filterState1[base + l] = filter.state1[l];
+      filterState2[base + l] = filter.state2[l];
+    }
+  }
+
+  // A group's modulation: current values, per-sample steps and the targets
+  // of the tick being ramped towards (the cutoff ratio is not ramped)
+  struct ModulationLanes {
+    alignas(SIMD_ALIGNMENT) float ratio[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float gain[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float width[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float cutoff[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float ratioStep[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float gainStep[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float widthStep[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float targetRatio[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float targetGain[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float targetWidth[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float targetCutoff[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float baseIncrement[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float baseMasterIncrement[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float invMasterIncrement[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float baseWidth[VOICE_LANES];
+
+    void clearSteps() {
+      for (int l = 0; l < VOICE_LANES; ++l) {
+        ratioStep[l] = 0.0f;
+        gainStep[l] = 0.0f;
+        widthStep[l] = 0.0f;
+        targetCutoff[l] = cutoff[l];
+      }
+    }
+  };
+
+  template <typename Kernel, bool HardSync, bool Filtered>
+  static void renderSegment(OscillatorLanes &lanes, ModulationLanes &mod,
+                            FilterLanes &filter, float *p, const float *gain,
+                            float *env, const float *coeff, float *master,
+                            float *pending, const int32_t *synced, float *mix,
+                            int numSamples) {
+    for (int i = 0; i < numSamples; ++i) {
+      for (int l = 0; l < VOICE_LANES; ++l) {
+        const float inc = mod.baseIncrement[l] * mod.ratio[l];
+        const float masterInc = mod.baseMasterIncrement[l] * mod.ratio[l];
+        lanes.increment[l] = inc;
+        lanes.pulseWidth[l] =
+            juce::jlimit(0.01f, 0.99f, mod.baseWidth[l] + mod.width[l]);
+        float y = Kernel::evaluate(lanes, l, p[l]);
+
+        if constexpr (HardSync) {
+          // Master wrap between this sample and the next resets the slave.
+          // d = samples elapsed since the reset at the next sample.
+          const float nextMaster = master[l] + masterInc;
+          const bool reset = synced[l] != 0 && nextMaster >= 1.0f;
+          master[l] = FastMath::wrapPhase(nextMaster);
+
+          const float d = master[l] * mod.invMasterIncrement[l];
+          const float phaseAtReset =
+              FastMath::wrapPhase(p[l] + inc * (1.0f - d));
+          const float jump = Kernel::naive(lanes, l, 0.0f) -
+                             Kernel::naive(lanes, l, phaseAtReset);
+
+          // Before-half of the step lands on this sample, after-half on the
+          // next one (minus the part the kernel's own wrap BLEP supplies)
+          y += pending[l] + (reset ? 0.5f * d * d * jump : 0.0f);
+          pending[l] = reset ? -0.5f * (1.0f - d) * (1.0f - d) *
+                                   (jump - Kernel::wrapStep(lanes, l))
+                             : 0.0f;
+          p[l] = reset ? d * inc : FastMath::wrapPhase(p[l] + inc);
+        } else {
+          juce::ignoreUnused(masterInc);
+          p[l] = FastMath::wrapPhase(p[l] + inc);
+        }
+
+        if constexpr (Filtered)
+          y = VoiceFilter::process(filter, l, y);
+        else
+          juce::ignoreUnused(filter);
+
+        mix[l] = y * gain[l] * env[l] * mod.gain[l];
+
+        const float e = env[l] * coeff[l];
+        env[l] = e > TAIL_OFF_CUTOFF ? e : 0.0f;
+
+        mod.ratio[l] += mod.ratioStep[l];
+        mod.gain[l] += mod.gainStep[l];
+        mod.width[l] += mod.widthStep[l];
+      }
+      mix += VOICE_LANES;
+    }
+  }
+
+  // Steps reaching the tick's values after rampLength samples. Lanes
+  // without a modulated owner hold theirs; a lane's first tick starts on
+  // its values instead of ramping into them.
+  void setModulationTargets(int g, const VoiceModulation &mod, int tick,
+                            int rampLength, ModulationLanes &lanes) {
+    const int base = g * VOICE_LANES;
+    const float invLength = 1.0f / static_cast<float>(rampLength);
+    const size_t tickBase = static_cast<size_t>(tick) * mod.stride;
+
+    for (int l = 0; l < VOICE_LANES; ++l) {
+      const int slot = base + l;
+      const int row = owners[slot];
+      const bool modulated =
+          active[slot] != 0 && row >= 0 && row < mod.numRows;
+
+      lanes.targetRatio[l] =
+          modulated ? mod.pitchRatio[tickBase + row] : lanes.ratio[l];
+      lanes.targetGain[l] =
+          modulated ? mod.gain[tickBase + row] : lanes.gain[l];
+      lanes.targetWidth[l] =
+          modulated ? mod.pulseWidthOffset[tickBase + row] : lanes.width[l];
+      lanes.targetCutoff[l] =
+          modulated ? mod.cutoffRatio[tickBase + row] : lanes.cutoff[l];
+
+      if (modulated && modPrimed[slot] == 0) {
+        lanes.ratio[l] = lanes.targetRatio[l];
+        lanes.gain[l] = lanes.targetGain[l];
+        lanes.width[l] = lanes.targetWidth[l];
+        lanes.cutoff[l] = lanes.targetCutoff[l];
+        modPrimed[slot] = 1;
+      }
+
+      lanes.ratioStep[l] = (lanes.targetRatio[l] - lanes.ratio[l]) * invLength;
+      lanes.gainStep[l] = (lanes.targetGain[l] - lanes.gain[l]) * invLength;
+      lanes.widthStep[l] = (lanes.targetWidth[l] - lanes.width[l]) * invLength;
+    }
+  }
+
+  bool isGroupSynced(int g) const {
+    const int base = g * VOICE_LANES;
+    for (int l = 0; l < VOICE_LANES; ++l) {
+      if (active[base + l] != 0 && syncEnabled[base + l] != 0)
+        return true;
+    }
+    return false;
+  }
+
+  bool isGroupFiltered(int g) const {
+    const int base = g * VOICE_LANES;
+    for (int l = 0; l < VOICE_LANES; ++l) {
+      if (active[base + l] != 0 &&
+          filterModes[base + l] != static_cast<int32_t>(FilterMode::Off))
+        return true;
+    }
+    return false;
+  }
+
+  void cullGroup(int g) {
+    const int base = g * VOICE_LANES;
+    for (int l = 0; l < VOICE_LANES; ++l) {
+      const int slot = base + l;
+      if (active[slot] != 0 && envelope[slot] == 0.0f)
+        killVoice(slot);
+    }
+  }
+
+  int getGroupShapeMask(int g) const {
+    int mask = 0;
+    const int base = g * VOICE_LANES;
+    for (int l = 0; l < VOICE_LANES; ++l) {
+      if (active[base + l] != 0)
+        mask |= 1 << shapes[base + l];
+    }
+    return mask;
+  }
+
+  int findFreeSlot() const {
+    for (int w = 0; w < NUM_SLOT_WORDS; ++w) {
+      const uint64_t free = ~activeBits[w];
+      if (free == 0)
+        continue;
+
+      int bit = 0;
+      while (((free >> bit) & 1u) == 0)
+        ++bit;
+      return w * 64 + bit;
+    }
+    return -1;
+  }
+
+  int findDetachedSlot() {
+    for (int slot = 0; slot < MAX_BANK_VOICES; ++slot) {
+      if (active[slot] != 0 && owners[slot] < 0) {
+        killVoice(slot);
+        return slot;
+      }
+    }
+    return -1;
+  }
+
+  void setActive(int slot, bool shouldBeActive) {
+    const bool wasActive = active[slot] != 0;
+    if (wasActive == shouldBeActive)
+      return;
+
+    active[slot] = shouldBeActive ? 1 : 0;
+    activeBits[slot / 64] ^= uint64_t{1} << (slot % 64);
+    const int delta = shouldBeActive ? 1 : -1;
+    groupActiveCount[slot / VOICE_LANES] += delta;
+    numActiveVoices += delta;
+  }
+
+  // Silent lanes still run through the kernels, so keep them at zero gain
+  void clearSlot(int slot) {
+    phase[slot] = 0.0f;
+    increment[slot] = 0.0f;
+    invIncrement[slot] = 0.0f;
+    pulseWidth[slot] = 0.5f;
+    syncEnabled[slot] = 0;
+    masterPhase[slot] = 0.0f;
+    masterIncrement[slot] = 0.0f;
+    invMasterIncrement[slot] = 0.0f;
+    syncPending[slot] = 0.0f;
+    level[slot] = 0.0f;
+    panLeft[slot] = 1.0f;
+    panRight[slot] = 1.0f;
+    envelope[slot] = 0.0f;
+    envelopeCoeff[slot] = 1.0f;
+    shapes[slot] = static_cast<int32_t>(WaveShape::Sine);
+    active[slot] = 0;
+    owners[slot] = -1;
+
+    // Point idle wavetable lanes at silence so Mixed groups stay safe
+    wavetables[slot] = nullptr;
+    mipLevels[slot] = 0;
+    frameA[slot] = silentFrame.data();
+    frameB[slot] = silentFrame.data();
+    morph[slot] = 0.0f;
+
+    modPitch[slot] = 1.0f;
+    modGain[slot] = 1.0f;
+    modWidth[slot] = 0.0f;
+    modCutoff[slot] = 1.0f;
+    modPrimed[slot] = 0;
+
+    // Unfiltered lanes in a filtered group pass their input through
+    filterModes[slot] = static_cast<int32_t>(FilterMode::Off);
+    filterCutoff[slot] = 0.25f;
+    filterDamping[slot] =
+        VoiceFilter::getDamping(VoiceFilter::DEFAULT_RESONANCE);
+    filterState1[slot] = 0.0f;
+    filterState2[slot] = 0.0f;
+  }
+
+  // Voice state (structure of arrays)
+  VoiceLaneArray phase;
+  VoiceLaneArray increment;
+  VoiceLaneArray invIncrement;
+  VoiceLaneArray pulseWidth;
+  VoiceLaneArray level;
+  VoiceLaneArray panLeft;
+  VoiceLaneArray panRight;
+  VoiceLaneArray envelope;
+  VoiceLaneArray envelopeCoeff;
+  std::array<int32_t, MAX_BANK_VOICES> shapes{};
+  std::array<uint8_t, MAX_BANK_VOICES> active{};
+
+  // Hard sync state
+  VoiceLaneArray masterPhase;
+  VoiceLaneArray masterIncrement;
+  VoiceLaneArray invMasterIncrement;
+  VoiceLaneArray syncPending;
+  std::array<int32_t, MAX_BANK_VOICES> syncEnabled{};
+
+  // Wavetable voice state
+  std::array<const WavetableSet *, MAX_BANK_VOICES> wavetables{};
+  std::array<int, MAX_BANK_VOICES> mipLevels{};
+  std::array<const float *, MAX_BANK_VOICES> frameA{};
+  std::array<const float *, MAX_BANK_VOICES> frameB{};
+  VoiceLaneArray morph;
+  std::array<float, WavetableSet::FRAME_STRIDE> silentFrame{};
+
+  // Modulation state: pitch ratio, gain, pulse width offset and cutoff
+  // ratio reached so far, and whether the lane has had its first tick
+  VoiceLaneArray modPitch;
+  VoiceLaneArray modGain;
+  VoiceLaneArray modWidth;
+  VoiceLaneArray modCutoff;
+  std::array<uint8_t, MAX_BANK_VOICES> modPrimed{};
+
+  // Filter state: mode, unmodulated cutoff (cycles per sample), damping
+  // (1 / Q) and the two integrators
+  std::array<int32_t, MAX_BANK_VOICES> filterModes{};
+  VoiceLaneArray filterCutoff;
+  VoiceLaneArray filterDamping;
+  VoiceLaneArray filterState1;
+  VoiceLaneArray filterState2;
+
+  // Slot ownership
+  static constexpr int NUM_SLOT_WORDS = MAX_BANK_VOICES / 64;
+  std::array<int, MAX_BANK_VOICES> owners{};
+  std::array<uint64_t, NUM_SLOT_WORDS> activeBits{};
+
+  std::array<int, MAX_VOICE_GROUPS> groupActiveCount{};
+  int numActiveVoices = 0;
+
+  // Scratch (allocated in prepare)
+  std::vector<float> laneScratch; // [thread][sample][lane]
+  std::vector<float> groupMix;    // [group][channel][sample]
+  std::vector<float> stereoMix;   // [channel][sample]
+  int maxBlockSize = 0;
+
+  // Current chunk's work list, read by the group tasks
+  std::array<int, MAX_VOICE_GROUPS> renderGroups{};
+  int numRenderGroups = 0;
+  int chunkSamples = 0;
+  int chunkOffset = 0; // chunk start within the render call
+  const VoiceModulation *chunkModulation = nullptr;
+  RealtimeWorkerPool *workerPool = nullptr;
+};
+
+} // namespace Synth
+} // namespace Sphere
@@ -0,0 +1,193 @@
+/*
+  ==============================================================================
+    SphereOscillatorKernels.h
+    Per-lane waveform kernels for the oscillator bank
+
+    Saw and pulse use PolyBLEP step corrections, triangle uses PolyBLAMP
+    corner corrections. Every kernel is written with selects instead of
+    branches so a loop over VOICE_LANES compiles to straight vector code.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../Common/SphereFastMath.h"
+#include "SphereSynthTypes.h"
+#include "SphereWavetable.h"
+
+namespace Sphere {
+namespace Synth {
+
+// ============================================================================
+// Per-group lane state handed to the waveform kernels
+// ============================================================================
+struct OscillatorLanes {
+  alignas(SIMD_ALIGNMENT) int32_t shape[VOICE_LANES];
+
+  // Phase increment and its reciprocal (0 for idle lanes)
+  alignas(SIMD_ALIGNMENT) float increment[VOICE_LANES];
+  alignas(SIMD_ALIGNMENT) float invIncrement[VOICE_LANES];
+
+  // Pulse width for WaveShape::Square, 0..1
+  alignas(SIMD_ALIGNMENT) float pulseWidth[VOICE_LANES];
+
+  // Wavetable lanes: the two frames being morphed and the morph amount
+  const float *frameA[VOICE_LANES];
+  const float *frameB[VOICE_LANES];
+  alignas(SIMD_ALIGNMENT) float morph[VOICE_LANES];
+};
+
+// ============================================================================
+// Polynomial band-limited step/ramp residuals
+// t is the phase elapsed since the discontinuity, wrapped to [0, 1)
+// ============================================================================
+namespace PolyBlep {
+// Residual of a unit upward step
+inline float step(float t, float dt, float invDt) {
+  const float after = 1.0f - t * invDt;
+  const float before = 1.0f - (1.0f - t) * invDt;
+  return t < dt ? -0.5f * after * after
+                : (t > 1.0f - dt ? 0.5f * before * before : 0.0f);
+}
+
+// Residual of a unit slope increase (slope measured per sample)
+inline float ramp(float t, float dt, float invDt) {
+  const float after = 1.0f - t * invDt;
+  const float before = 1.0f - (1.0f - t) * invDt;
+  return t < dt ? after * after * after * (1.0f / 6.0f)
+                : (t > 1.0f - dt ? before * before * before * (1.0f / 6.0f)
+                                 : 0.0f);
+}
+} // namespace PolyBlep
+
+// ============================================================================
+// Waveform kernels
+//   evaluate() - band-limited output
+//   naive()    - uncorrected waveform, used to size hard-sync steps
+//   wrapStep() - jump at the natural phase wrap already corrected by
+//                evaluate()
+// ============================================================================
+namespace OscillatorKernels {
+struct Sine {
+  static inline float naive(const OscillatorLanes &, int, float phase) {
+    return FastMath::sinCycle(phase);
+  }
+  static inline float evaluate(const OscillatorLanes &lanes, int l,
+                               float phase) {
+    return naive(lanes, l, phase);
+  }
+  static inline float wrapStep(const OscillatorLanes &, int) { return 0.0f; }
+};
+
+// Falling ramp +1 .. -1 with a +2 step at the wrap
+struct Saw {
+  static inline float naive(const OscillatorLanes &, int, float phase) {
+    return 1.0f - 2.0f * phase;
+  }
+  static inline float evaluate(const OscillatorLanes &lanes, int l,
+                               float phase) {
+    return naive(lanes, l, phase) +
+           2.0f * PolyBlep::step(phase, lanes.increment[l],
+                                 lanes.invIncrement[l]);
+  }
+  static inline float wrapStep(const OscillatorLanes &, int) { return 2.0f; }
+};
+
+// Pulse +-0.5 with variable width (0.5 = square)
+struct Square {
+  static inline float naive(const OscillatorLanes &lanes, int l,
+                            float phase) {
+    return phase < lanes.pulseWidth[l] ? 0.5f : -0.5f;
+  }
+  static inline float evaluate(const OscillatorLanes &lanes, int l,
+                               float phase) {
+    const float dt = lanes.increment[l];
+    const float invDt = lanes.invIncrement[l];
+    const float fall = FastMath::wrapPhase(phase - lanes.pulseWidth[l] + 1.0f);
+    return naive(lanes, l, phase) + PolyBlep::step(phase, dt, invDt) -
+           PolyBlep::step(fall, dt, invDt);
+  }
+  static inline float wrapStep(const OscillatorLanes &, int) { return 1.0f; }
+};
+
+// Triangle -1 .. +1 .. -1 with slope changes of +-8*dt at phase 0 and 0.5
+struct Triangle {
+  static inline float naive(const OscillatorLanes &, int, float phase) {
+    return 1.0f - 4.0f * std::abs(phase - 0.5f);
+  }
+  static inline float evaluate(const OscillatorLanes &lanes, int l,
+                               float phase) {
+    const float dt = lanes.increment[l];
+    const float invDt = lanes.invIncrement[l];
+    const float peak = FastMath::wrapPhase(phase + 0.5f);
+    return naive(lanes, l, phase) +
+           8.0f * dt *
+               (PolyBlep::ramp(phase, dt, invDt) -
+                PolyBlep::ramp(peak, dt, invDt));
+  }
+  static inline float wrapStep(const OscillatorLanes &, int) { return 0.0f; }
+};
+
+// Linear interpolation within each frame, then between the two frames
+struct Wavetable {
+  static inline float naive(const OscillatorLanes &lanes, int l,
+                            float phase) {
+    const float pos = phase * static_cast<float>(WavetableSet::TABLE_SIZE);
+    const int i0 = static_cast<int>(pos);
+    const float frac = pos - static_cast<float>(i0);
+
+    const float *a = lanes.frameA[l];
+    const float *b = lanes.frameB[l];
+    const float sampleA = a[i0] + frac * (a[i0 + 1] - a[i0]);
+    const float sampleB = b[i0] + frac * (b[i0 + 1] - b[i0]);
+    return sampleA + lanes.morph[l] * (sampleB - sampleA);
+  }
+  static inline float evaluate(const OscillatorLanes &lanes, int l,
+                               float phase) {
+    return naive(lanes, l, phase);
+  }
+  static inline float wrapStep(const OscillatorLanes &, int) { return 0.0f; }
+};
+
+// Used when one lane group holds voices of different shapes
+struct Mixed {
+  template <typename Function>
+  static inline float dispatch(const OscillatorLanes &lanes, int l,
+                               Function &&function) {
+    switch (static_cast<WaveShape>(lanes.shape[l])) {
+    case WaveShape::Sine:
+      return function(Sine{});
+    case WaveShape::Saw:
+      return function(Saw{});
+    case WaveShape::Square:
+      return function(Square{});
+    case WaveShape::Triangle:
+      return function(Triangle{});
+    case WaveShape::Wavetable:
+      return function(Wavetable{});
+    }
+    return 0.0f;
+  }
+
+  static inline float naive(const OscillatorLanes &lanes, int l,
+                            float phase) {
+    return dispatch(lanes, l, [&](auto kernel) {
+      return decltype(kernel)::naive(lanes, l, phase);
+    });
+  }
+  static inline float evaluate(const OscillatorLanes &lanes, int l,
+                               float phase) {
+    return dispatch(lanes, l, [&](auto kernel) {
+      return decltype(kernel)::evaluate(lanes, l, phase);
+    });
+  }
+  static inline float wrapStep(const OscillatorLanes &lanes, int l) {
+    return dispatch(lanes, l, [&](auto kernel) {
+      return decltype(kernel)::wrapStep(lanes, l);
+    });
+  }
+};
+} // namespace OscillatorKernels
+
+} // namespace Synth
+} // namespace Sphere
@@ -0,0 +1,480 @@
+/*
+  ==============================================================================
+    SphereSampleCache.h
+    Decode-once cache of sample assets shared by all sampler sounds
+
+    Each asset is read and decoded on the cache's background thread into
+    SIMD-aligned buffers, stored as float or as packed 16/24-bit PCM and
+    optionally converted to the engine's sample rate.
+    Entries are keyed by path and decoded data by content hash, so the same
+    file is never decoded twice and identical files under different names
+    share one buffer; data no sound uses any more is released on request.
+    Renderers get a pointer to the decoded data through the entry's atomic
+    install slot - no copies, no locks. Voices playing packed samples
+    convert a small window at a time into their own scratch buffers.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../Common/SphereSincResampler.h"
+#include "SphereSynthTypes.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <map>
+#include <tuple>
+#include <vector>
+
+namespace Sphere {
+namespace Synth {
+
+// ============================================================================
+// Sample storage format
+// Int16/Int24 halve or quarter the resident size of 16/24-bit assets and are
+// lossless for them; Float32 is read in place without any conversion.
+// ============================================================================
+enum class SampleEncoding { Float32, Int16, Int24 };
+
+// ============================================================================
+// Decoded Sample (immutable once installed)
+// ============================================================================
+class DecodedSample final : public juce::ReferenceCountedObject {
+public:
+  using Ptr = juce::ReferenceCountedObjectPtr<DecodedSample>;
+
+  // Zeroed samples before the start and after the end of every channel, so
+  // interpolators can read around the sample without bounds checks
+  static constexpr int GUARD_SAMPLES = 64;
+
+  DecodedSample(int channels, int samples, double rate, uint64_t hash,
+                SampleEncoding storageEncoding = SampleEncoding::Float32)
+      : numChannels(juce::jmax(1, channels)), numSamples(samples),
+        sampleRate(rate), contentHash(hash), encoding(storageEncoding),
+        bytesPerSample(getBytesPerSample(storageEncoding)) {
+    // Channel starts stay SIMD aligned for every encoding (the leading guard
+    // is a multiple of SIMD_ALIGNMENT bytes too)
+    const int channelBytes =
+        (numSamples + 2 * GUARD_SAMPLES) * bytesPerSample;
+    channelStride = (channelBytes + SIMD_ALIGNMENT - 1) / SIMD_ALIGNMENT *
+                    SIMD_ALIGNMENT;
+
+    storage.assign(static_cast<size_t>(channelStride) * numChannels +
+                       SIMD_ALIGNMENT,
+                   0);
+
+    const auto address = reinterpret_cast<uintptr_t>(storage.data());
+    alignedData = storage.data() +
+                  (SIMD_ALIGNMENT - address % SIMD_ALIGNMENT) % SIMD_ALIGNMENT;
+  }
+
+  int getNumChannels() const { return numChannels; }
+  int getNumSamples() const { return numSamples; }
+  double getSampleRate() const { return sampleRate; }
+  uint64_t getContentHash() const { return contentHash; }
+  SampleEncoding getEncoding() const { return encoding; }
+
+  // Resident size of the sample data
+  size_t getStorageBytes() const { return storage.size(); }
+
+  static int getBytesPerSample(SampleEncoding e) {
+    return e == SampleEncoding::Int16 ? 2 : e == SampleEncoding::Int24 ? 3 : 4;
+  }
+
+  // Float32 storage only: the samples themselves, read in place
+  const float *getReadPointer(int channel) const {
+    jassert(encoding == SampleEncoding::Float32);
+    return reinterpret_cast<const float *>(getChannelData(channel));
+  }
+
+  // Float32 storage only; used while decoding, before the sample is installed
+  float *getWritePointer(int channel) {
+    jassert(encoding == SampleEncoding::Float32);
+    return reinterpret_cast<float *>(alignedData +
+                                     static_cast<size_t>(channel) *
+                                         channelStride +
+                                     GUARD_SAMPLES * sizeof(float));
+  }
+
+  // Converts frames [startFrame, startFrame + numFrames) of a channel to
+  // float; frames outside the sample read as silence. Audio thread safe.
+  void readFrames(int channel, int startFrame, int numFrames,
+                  float *dest) const {
+    const int first = juce::jlimit(0, numSamples, startFrame);
+    const int last = juce::jlimit(first, numSamples, startFrame + numFrames);
+
+    const int leading = juce::jmin(numFrames, first - startFrame);
+    if (leading > 0)
+      std::fill(dest, dest + leading, 0.0f);
+
+    float *body = dest + juce::jmax(0, leading);
+    const uint8_t *src = getChannelData(channel) +
+                         static_cast<size_t>(first) * bytesPerSample;
+    convertToFloat(src, body, last - first);
+
+    float *tail = body + (last - first);
+    std::fill(tail, dest + numFrames, 0.0f);
+  }
+
+  // Stores numFrames float samples at startFrame of a channel, quantising
+  // them to the storage format (loader thread, before installation)
+  void writeFrames(int channel, int startFrame, const float *src,
+                   int numFrames) {
+    uint8_t *dest =
+        alignedData + static_cast<size_t>(channel) * channelStride +
+        static_cast<size_t>(GUARD_SAMPLES + startFrame) * bytesPerSample;
+
+    switch (encoding) {
+    case SampleEncoding::Float32:
+      std::memcpy(dest, src, static_cast<size_t>(numFrames) * sizeof(float));
+      break;
+
+    case SampleEncoding::Int16: {
+      auto *out = reinterpret_cast<int16_t *>(dest);
+      for (int i = 0; i < numFrames; ++i)
+        out[i] = static_cast<int16_t>(quantise(src[i], 32768.0f));
+      break;
+    }
+
+    case SampleEncoding::Int24:
+      for (int i = 0; i < numFrames; ++i) {
+        const int32_t v = quantise(src[i], 8388608.0f);
+        dest[3 * i] = static_cast<uint8_t>(v);
+        dest[3 * i + 1] = static_cast<uint8_t>(v >> 8);
+        dest[3 * i + 2] = static_cast<uint8_t>(v >> 16);
+      }
+      break;
+    }
+  }
+
+private:
+  const uint8_t *getChannelData(int channel) const {
+    return alignedData +
+           static_cast<size_t>(juce::jmin(channel, numChannels - 1)) *
+               channelStride +
+           GUARD_SAMPLES * bytesPerSample;
+  }
+
+  // Full scale maps to the integer range exactly, so 16/24-bit sources
+  // survive the float round trip unchanged
+  static int32_t quantise(float x, float fullScale) {
+    const float scaled = std::round(x * fullScale);
+    return static_cast<int32_t>(
+        juce::jlimit(-fullScale, fullScale - 1.0f, scaled));
+  }
+
+  // Straight-line loops without cross-iteration dependencies, so the
+  // compiler vectorizes them
+  void convertToFloat(const uint8_t *src, float *dest, int count) const {
+    switch (encoding) {
+    case SampleEncoding::Float32:
+      std::memcpy(dest, src, static_cast<size_t>(count) * sizeof(float));
+      break;
+
+    case SampleEncoding::Int16: {
+      const auto *in = reinterpret_cast<const int16_t *>(src);
+      for (int i = 0; i < count; ++i)
+        dest[i] = static_cast<float>(in[i]) * (1.0f / 32768.0f);
+      break;
+    }
+
+    case SampleEncoding::Int24:
+      // Assemble each sample in the top 24 bits so the sign comes for free
+      for (int i = 0; i < count; ++i) {
+        const auto v = static_cast<int32_t>(
+            static_cast<uint32_t>(src[3 * i]) << 8 |
+            static_cast<uint32_t>(src[3 * i + 1]) << 16 |
+            static_cast<uint32_t>(src[3 * i + 2]) << 24);
+        dest[i] = static_cast<float>(v) * (1.0f / 2147483648.0f);
+      }
+      break;
+    }
+  }
+
+  int numChannels;
+  int numSamples;
+  double sampleRate;
+  uint64_t contentHash;
+  SampleEncoding encoding;
+  int bytesPerSample;
+  int channelStride = 0; // bytes
+  std::vector<uint8_t> storage;
+  uint8_t *alignedData = nullptr;
+};
+
+// ============================================================================
+// Sample Cache
+// ============================================================================
+class SampleCache final : private juce::Thread {
+public:
+  using StreamOpener =
+      std::function<std::unique_ptr<juce::InputStream>(const juce::String &)>;
+
+  // --------------------------------------------------------------------------
+  // One requested asset; the decoded sample appears once loading finishes
+  // --------------------------------------------------------------------------
+  class Entry final : public juce::ReferenceCountedObject {
+  public:
+    using Ptr = juce::ReferenceCountedObjectPtr<Entry>;
+
+    enum class State { Pending, Ready, Failed };
+
+    Entry(const juce::String &assetPath, SampleEncoding storageEncoding,
+          double targetSampleRate)
+        : path(assetPath), encoding(storageEncoding),
+          targetRate(targetSampleRate) {}
+
+    const juce::String &getPath() const { return path; }
+    SampleEncoding getEncoding() const { return encoding; }
+    double getTargetSampleRate() const { return targetRate; }
+    State getState() const { return state.load(std::memory_order_acquire); }
+
+    // Audio thread safe; nullptr until decoding has finished
+    const DecodedSample *getSample() const {
+      return installed.load(std::memory_order_acquire);
+    }
+
+  private:
+    friend class SampleCache;
+
+    void install(DecodedSample::Ptr decoded) {
+      owner = std::move(decoded);
+      installed.store(owner.get(), std::memory_order_release);
+      state.store(owner != nullptr ? State::Ready : State::Failed,
+                  std::memory_order_release);
+    }
+
+    const juce::String path;
+    const SampleEncoding encoding;
+    const double targetRate;
+    DecodedSample::Ptr owner; // written once by the loader thread
+    std::atomic<const DecodedSample *> installed{nullptr};
+    std::atomic<State> state{State::Pending};
+  };
+
+  // Opens assets by path; defaults to plain files
+  explicit SampleCache(StreamOpener opener = {})
+      : juce::Thread("Sphere Sample Cache"), openStream(std::move(opener)) {
+    if (!openStream)
+      openStream = [](const juce::String &path) {
+        return std::unique_ptr<juce::InputStream>(
+            juce::File(path).createInputStream());
+      };
+
+    formatManager.registerBasicFormats();
+    startThread(juce::Thread::Priority::low);
+  }
+
+  ~SampleCache() override { stopThread(4000); }
+
+  // Returns the entry for the path in the given storage format, queueing a
+  // decode the first time it is requested (message thread). With a target
+  // rate the asset is converted to it once, so voices playing at the root
+  // note don't have to resample.
+  Entry::Ptr request(const juce::String &path,
+                     SampleEncoding encoding = SampleEncoding::Float32,
+                     double targetSampleRate = 0.0) {
+    const juce::ScopedLock sl(cacheLock);
+
+    const EntryKey key{path, encoding, targetSampleRate};
+    auto existing = entries.find(key);
+    if (existing != entries.end())
+      return existing->second;
+
+    Entry::Ptr entry = new Entry(path, encoding, targetSampleRate);
+    entries[key] = entry;
+    pending.push_back(entry);
+    notify();
+    return entry;
+  }
+
+  // Drops entries nothing outside the cache holds any more, then the decoded
+  // data no remaining entry uses (message thread). Everything that reads an
+  // entry's sample holds the entry - sounds, and granular grains that play
+  // on after their voice - so nothing can still be rendering them.
+  void releaseUnused() {
+    std::vector<DecodedSample::Ptr> released;
+    {
+      const juce::ScopedLock sl(cacheLock);
+
+      for (auto it = entries.begin(); it != entries.end();) {
+        // Queued and loading entries are also held by the loader
+        if (it->second->getReferenceCount() == 1)
+          it = entries.erase(it);
+        else
+          ++it;
+      }
+
+      for (auto it = decodedByHash.begin(); it != decodedByHash.end();) {
+        if (it->second->getReferenceCount() == 1) {
+          released.push_back(std::move(it->second));
+          it = decodedByHash.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+    // The buffers are freed here, outside the lock the loader thread takes
+  }
+
+  // Resident size of the decoded sample data still in use
+  size_t getStorageBytes() const {
+    const juce::ScopedLock sl(cacheLock);
+
+    size_t total = 0;
+    for (const auto &decoded : decodedByHash)
+      if (decoded.second->getReferenceCount() > 1)
+        total += decoded.second->getStorageBytes();
+    return total;
+  }
+
+  // 64-bit FNV-1a over the encoded file bytes
+  static uint64_t hashContent(const void *data, size_t numBytes) {
+    uint64_t hash = 14695981039346656037ull;
+    const auto *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < numBytes; ++i) {
+      hash ^= bytes[i];
+      hash *= 1099511628211ull;
+    }
+    return hash;
+  }
+
+private:
+  void run() override {
+    while (!threadShouldExit()) {
+      Entry::Ptr next;
+      {
+        const juce::ScopedLock sl(cacheLock);
+        if (!pending.empty()) {
+          next = pending.front();
+          pending.erase(pending.begin());
+        }
+      }
+
+      if (next == nullptr) {
+        wait(-1);
+        continue;
+      }
+
+      next->install(load(next->getPath(), next->getEncoding(),
+                         next->getTargetSampleRate()));
+    }
+  }
+
+  DecodedSample::Ptr load(const juce::String &path, SampleEncoding encoding,
+                          double targetRate) {
+    auto stream = openStream(path);
+    if (stream == nullptr)
+      return nullptr;
+
+    juce::MemoryBlock encoded;
+    stream->readIntoMemoryBlock(encoded);
+    if (encoded.getSize() == 0)
+      return nullptr;
+
+    const uint64_t hash = hashContent(encoded.getData(), encoded.getSize());
+    const DecodedKey key{hash, encoding, targetRate};
+    {
+      const juce::ScopedLock sl(cacheLock);
+      auto shared = decodedByHash.find(key);
+      if (shared != decodedByHash.end())
+        return shared->second;
+    }
+
+    DecodedSample::Ptr decoded = decode(encoded, hash, encoding, targetRate);
+    if (decoded != nullptr) {
+      const juce::ScopedLock sl(cacheLock);
+      decodedByHash[key] = decoded;
+    }
+    return decoded;
+  }
+
+  DecodedSample::Ptr decode(const juce::MemoryBlock &encoded, uint64_t hash,
+                            SampleEncoding encoding, double targetRate) {
+    std::unique_ptr<juce::AudioFormatReader> reader(
+        formatManager.createReaderFor(
+            std::make_unique<juce::MemoryInputStream>(encoded, false)));
+
+    if (reader == nullptr || reader->lengthInSamples <= 0 ||
+        reader->lengthInSamples > std::numeric_limits<int>::max())
+      return nullptr;
+
+    const int numChannels =
+        juce::jmin(2, static_cast<int>(reader->numChannels));
+    const int numSamples = static_cast<int>(reader->lengthInSamples);
+
+    // Rate conversion reads from a float copy at the source rate
+    const bool convert = targetRate > 0.0 && reader->sampleRate > 0.0 &&
+                         std::abs(targetRate - reader->sampleRate) > 1.0e-6;
+
+    DecodedSample::Ptr decoded = new DecodedSample(
+        numChannels, numSamples, reader->sampleRate, hash,
+        convert ? SampleEncoding::Float32 : encoding);
+
+    // Decode through a small float buffer so packed formats never need a
+    // full-size float copy of the asset
+    constexpr int chunkFrames = 8192;
+    juce::AudioBuffer<float> chunk(numChannels, chunkFrames);
+
+    for (int start = 0; start < numSamples; start += chunkFrames) {
+      const int count = juce::jmin(chunkFrames, numSamples - start);
+      if (!reader->read(chunk.getArrayOfWritePointers(), numChannels, start,
+                        count))
+        return nullptr;
+
+      for (int ch = 0; ch < numChannels; ++ch)
+        decoded->writeFrames(ch, start, chunk.getReadPointer(ch), count);
+    }
+
+    return convert ? convertRate(*decoded, targetRate, encoding) : decoded;
+  }
+
+  // Highest quality sinc conversion; the guard samples pad the source
+  static DecodedSample::Ptr convertRate(const DecodedSample &source,
+                                        double targetRate,
+                                        SampleEncoding encoding) {
+    const double ratio = source.getSampleRate() / targetRate;
+    const double outputLength = std::ceil(source.getNumSamples() / ratio);
+    if (outputLength > std::numeric_limits<int>::max())
+      return nullptr;
+
+    const int numOutput = static_cast<int>(outputLength);
+    DecodedSample::Ptr converted =
+        new DecodedSample(source.getNumChannels(), numOutput, targetRate,
+                          source.getContentHash(), encoding);
+
+    const auto &resampler = SincResampler::getInstance();
+    constexpr int chunkFrames = 8192;
+    std::vector<float> chunk(chunkFrames);
+
+    for (int ch = 0; ch < source.getNumChannels(); ++ch) {
+      for (int start = 0; start < numOutput; start += chunkFrames) {
+        const int count = juce::jmin(chunkFrames, numOutput - start);
+        resampler.process(source.getReadPointer(ch), start * ratio, ratio,
+                          chunk.data(), count, SincQuality::High);
+        converted->writeFrames(ch, start, chunk.data(), count);
+      }
+    }
+
+    return converted;
+  }
+
+  // (path or content hash, storage format, target rate or 0)
+  using EntryKey = std::tuple<juce::String, SampleEncoding, double>;
+  using DecodedKey = std::tuple<uint64_t, SampleEncoding, double>;
+
+  StreamOpener openStream;
+  juce::AudioFormatManager formatManager;
+
+  // Shared between the message thread and the loader thread
+  juce::CriticalSection cacheLock;
+  std::map<EntryKey, Entry::Ptr> entries;
+  std::map<DecodedKey, DecodedSample::Ptr> decodedByHash;
+  std::vector<Entry::Ptr> pending;
+};
+
+} // namespace Synth
+} // namespace Sphere
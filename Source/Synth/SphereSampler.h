@@ -0,0 +1,219 @@
+/*
+  ==============================================================================
+    SphereSampler.h
+    Sampler sound and voice playing decoded samples from the SampleCache
+
+    Replaces juce::SamplerSound/SamplerVoice, which copy the whole sample out
+    of an AudioFormatReader for every sound. A SampleSound only references a
+    cache entry; voices read shared float buffers in place and convert
+    packed 16/24-bit buffers a small window at a time. Pitch shifting uses
+    the shared windowed-sinc interpolator.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../Common/SphereSincResampler.h"
+#include "SphereSampleCache.h"
+
+namespace Sphere {
+namespace Synth {
+
+// ============================================================================
+// Sample Sound
+// ============================================================================
+class SampleSound final : public juce::SynthesiserSound {
+public:
+  SampleSound(SampleCache::Entry::Ptr sampleEntry,
+              const juce::BigInteger &notes, int rootMidiNote,
+              double attackTimeSecs, double releaseTimeSecs,
+              SincQuality interpolationQuality = SincQuality::Low)
+      : entry(std::move(sampleEntry)), midiNotes(notes),
+        midiRootNote(rootMidiNote), quality(interpolationQuality) {
+    params.attack = static_cast<float>(attackTimeSecs);
+    params.release = static_cast<float>(releaseTimeSecs);
+  }
+
+  bool appliesToNote(int midiNoteNumber) override {
+    return midiNotes[midiNoteNumber];
+  }
+  bool appliesToChannel(int /*midiChannel*/) override { return true; }
+
+  // nullptr while the cache is still decoding
+  const DecodedSample *getSample() const { return entry->getSample(); }
+  int getRootNote() const { return midiRootNote; }
+  SincQuality getQuality() const { return quality; }
+  const juce::ADSR::Parameters &getEnvelopeParameters() const {
+    return params;
+  }
+
+private:
+  SampleCache::Entry::Ptr entry;
+  juce::BigInteger midiNotes;
+  int midiRootNote = 60;
+  SincQuality quality;
+  juce::ADSR::Parameters params;
+};
+
+// ============================================================================
+// Sample Voice
+// ============================================================================
+class SampleVoice final : public juce::SynthesiserVoice {
+public:
+  // Voices are built on the message thread, which also builds the tables
+  SampleVoice() : resampler(SincResampler::getInstance()) {}
+
+  bool canPlaySound(juce::SynthesiserSound *sound) override {
+    return dynamic_cast<const SampleSound *>(sound) != nullptr;
+  }
+
+  void startNote(int midiNoteNumber, float velocity,
+                 juce::SynthesiserSound *s,
+                 int /*currentPitchWheelPosition*/) override {
+    auto *sound = dynamic_cast<const SampleSound *>(s);
+    sample = sound != nullptr ? sound->getSample() : nullptr;
+
+    // Not decoded yet: stay silent rather than wait
+    if (sample == nullptr) {
+      clearCurrentNote();
+      return;
+    }
+
+    pitchRatio =
+        std::pow(2.0, (midiNoteNumber - sound->getRootNote()) / 12.0) *
+        sample->getSampleRate() / getSampleRate();
+    // At the sample's own rate every position is a whole frame
+    kernel = pitchRatio != 1.0
+                 ? &resampler.getKernel(sound->getQuality(), pitchRatio)
+                 : nullptr;
+
+    sourceSamplePosition = 0.0;
+    gain = velocity;
+    resetWindow();
+
+    adsr.setSampleRate(getSampleRate());
+    adsr.setParameters(sound->getEnvelopeParameters());
+    adsr.noteOn();
+  }
+
+  void stopNote(float /*velocity*/, bool allowTailOff) override {
+    if (allowTailOff) {
+      adsr.noteOff();
+    } else {
+      clearCurrentNote();
+      adsr.reset();
+      sample = nullptr;
+    }
+  }
+
+  void pitchWheelMoved(int /*newValue*/) override {}
+  void controllerMoved(int /*controllerNumber*/, int /*newValue*/) override {}
+
+  void renderNextBlock(juce::AudioBuffer<float> &outputBuffer, int startSample,
+                       int numSamples) override {
+    if (sample == nullptr)
+      return;
+
+    const bool stereoSource = sample->getNumChannels() > 1;
+    const double length = static_cast<double>(sample->getNumSamples());
+
+    float *outL = outputBuffer.getWritePointer(0, startSample);
+    float *outR = outputBuffer.getNumChannels() > 1
+                      ? outputBuffer.getWritePointer(1, startSample)
+                      : nullptr;
+
+    for (int i = 0; i < numSamples; ++i) {
+      const int pos = static_cast<int>(sourceSamplePosition);
+      const float frac = static_cast<float>(sourceSamplePosition - pos);
+
+      if (pos + WINDOW_AFTER >= windowStart + windowFrames)
+        fillWindow(pos);
+
+      const int offset = pos - windowStart;
+      const float envelope = adsr.getNextSample() * gain;
+      const float l = readSource(windowL + offset, frac) * envelope;
+      const float r =
+          stereoSource ? readSource(windowR + offset, frac) * envelope : l;
+
+      if (outR != nullptr) {
+        outL[i] += l;
+        outR[i] += r;
+      } else {
+        outL[i] += (l + r) * 0.5f;
+      }
+
+      sourceSamplePosition += pitchRatio;
+      if (sourceSamplePosition >= length || !adsr.isActive()) {
+        stopNote(0.0f, false);
+        break;
+      }
+    }
+  }
+
+  using SynthesiserVoice::renderNextBlock;
+
+private:
+  // Source frames converted per refill for packed samples, and the frames
+  // the widest kernel reads around a position
+  static constexpr int WINDOW_FRAMES = 256;
+  static constexpr int WINDOW_BEFORE =
+      SincResampler::getFramesBefore(SincResampler::MAX_TAPS);
+  static constexpr int WINDOW_AFTER =
+      SincResampler::getFramesAfter(SincResampler::MAX_TAPS);
+  static_assert(WINDOW_BEFORE <= DecodedSample::GUARD_SAMPLES &&
+                    WINDOW_AFTER <= DecodedSample::GUARD_SAMPLES,
+                "guard samples must cover the interpolation kernel");
+
+  // Float samples are read in place, guard samples included; packed ones
+  // go through the scratch window
+  void resetWindow() {
+    if (sample->getEncoding() == SampleEncoding::Float32) {
+      constexpr int guard = DecodedSample::GUARD_SAMPLES;
+      windowStart = -guard;
+      windowL = sample->getReadPointer(0) - guard;
+      windowR = sample->getReadPointer(1) - guard;
+      windowFrames = sample->getNumSamples() + 2 * guard;
+    } else {
+      windowStart = 0;
+      windowFrames = 0;
+    }
+  }
+
+  float readSource(const float *x, float frac) const {
+    return kernel != nullptr ? kernel->interpolate(x, frac) : x[0];
+  }
+
+  void fillWindow(int position) {
+    const int firstFrame = position - WINDOW_BEFORE;
+    windowStart = firstFrame;
+    windowFrames = WINDOW_FRAMES;
+
+    sample->readFrames(0, firstFrame, WINDOW_FRAMES, windowScratch[0].data());
+    windowL = windowScratch[0].data();
+    windowR = windowL;
+
+    if (sample->getNumChannels() > 1) {
+      sample->readFrames(1, firstFrame, WINDOW_FRAMES,
+                         windowScratch[1].data());
+      windowR = windowScratch[1].data();
+    }
+  }
+
+  const SincResampler &resampler;
+  const SincResampler::Kernel *kernel = nullptr;
+  const DecodedSample *sample = nullptr;
+  double pitchRatio = 0.0;
+  double sourceSamplePosition = 0.0;
+  float gain = 0.0f;
+  juce::ADSR adsr;
+
+  // Source frames [windowStart, windowStart + windowFrames) as floats
+  const float *windowL = nullptr;
+  const float *windowR = nullptr;
+  int windowStart = 0;
+  int windowFrames = 0;
+  alignas(SIMD_ALIGNMENT) std::array<float, WINDOW_FRAMES> windowScratch[2];
+};
+
+} // namespace Synth
+} // namespace Sphere
@@ -0,0 +1,46 @@
+/*
+  ==============================================================================
+    SphereSoundSet.h
+    Immutable set of synth sounds published to the audio thread
+
+    A sound set is built on the message thread and never modified after
+    that, so the audio thread can iterate it without taking a lock. A new
+    set replaces the old one with a single atomic pointer swap.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <initializer_list>
+#include <vector>
+
+namespace Sphere {
+namespace Synth {
+
+// ============================================================================
+// Sound Set
+// ============================================================================
+class SoundSet final : public juce::ReferenceCountedObject {
+public:
+  using Ptr = juce::ReferenceCountedObjectPtr<SoundSet>;
+
+  SoundSet() = default;
+
+  SoundSet(std::initializer_list<juce::SynthesiserSound::Ptr> soundsToUse) {
+    for (auto &sound : soundsToUse) {
+      if (sound != nullptr)
+        sounds.push_back(sound);
+    }
+  }
+
+  const std::vector<juce::SynthesiserSound::Ptr> &getSounds() const {
+    return sounds;
+  }
+
+private:
+  std::vector<juce::SynthesiserSound::Ptr> sounds;
+};
+
+} // namespace Synth
+} // namespace Sphere
@@ -0,0 +1,534 @@
+/*
+  ==============================================================================
+    SphereStreamingSampler.h
+    Disk-streaming sampler for sample libraries too large to keep in RAM
+
+    Only the first PRELOAD_FRAMES of each zone are decoded into memory when
+    a patch loads. A voice starts playing from that head immediately while
+    the engine's I/O thread streams the rest of the file - through a
+    memory-mapped reader where the format supports it - into the voice's
+    own lock-free ring buffer. If the I/O thread falls behind, the voice
+    plays silence for the missing frames and bumps an underrun counter
+    instead of blocking the audio thread.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../Common/SphereSincResampler.h"
+#include "SphereSampleCache.h"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace Sphere {
+namespace Synth {
+
+// ============================================================================
+// Streaming Zone (one sample file; the head stays in RAM)
+// ============================================================================
+class StreamingZone final : public juce::ReferenceCountedObject {
+public:
+  using Ptr = juce::ReferenceCountedObjectPtr<StreamingZone>;
+
+  static constexpr int PRELOAD_FRAMES = 1 << 15;
+
+  // Head data, with DecodedSample's zeroed guard samples after it
+  const DecodedSample &getHead() const { return *head; }
+  int getHeadLength() const { return head->getNumSamples(); }
+  juce::int64 getLengthInSamples() const { return lengthInSamples; }
+  int getNumChannels() const { return head->getNumChannels(); }
+  double getSampleRate() const { return head->getSampleRate(); }
+  bool isMemoryMapped() const { return memoryMapped; }
+
+private:
+  friend class StreamingEngine;
+
+  std::unique_ptr<juce::AudioFormatReader> reader; // I/O thread only
+  DecodedSample::Ptr head;
+  juce::int64 lengthInSamples = 0;
+  bool memoryMapped = false;
+};
+
+// ============================================================================
+// Streaming Engine (zones, per-voice stream slots and the I/O thread)
+// ============================================================================
+class StreamingEngine final : private juce::Thread {
+public:
+  static constexpr int RING_FRAMES = 1 << 15;
+  static constexpr int RING_MASK = RING_FRAMES - 1;
+  static constexpr int READ_CHUNK_FRAMES = 4096;
+  static constexpr int MAX_STREAMS = MAX_POOL_VOICES;
+
+  // --------------------------------------------------------------------------
+  // Ring buffer shared by one voice (consumer) and the I/O thread (producer)
+  // --------------------------------------------------------------------------
+  class StreamSlot {
+  public:
+    // Audio thread: begin streaming the zone past its head (nullptr stops)
+    void start(const StreamingZone *zone) {
+      readCount.store(0, std::memory_order_relaxed);
+      requestedZone.store(zone, std::memory_order_relaxed);
+      activeRequest =
+          requestedGeneration.fetch_add(1, std::memory_order_release) + 1;
+    }
+
+    void stop() { start(nullptr); }
+
+    // Audio thread: frames past the head that are ready to read
+    juce::int64 getNumFramesReady() const {
+      if (servedGeneration.load(std::memory_order_acquire) != activeRequest)
+        return 0;
+      return writeCount.load(std::memory_order_acquire);
+    }
+
+    // Frame index is relative to the end of the head
+    float getFrame(int channel, juce::int64 frame) const {
+      return ring[static_cast<size_t>(channel)]
+                 [static_cast<size_t>(frame & RING_MASK)];
+    }
+
+    // Audio thread: frames before this index will not be read again
+    void releaseFramesBefore(juce::int64 frame) {
+      if (frame > readCount.load(std::memory_order_relaxed))
+        readCount.store(frame, std::memory_order_release);
+    }
+
+    void reportUnderrun() {
+      underruns.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint32_t getUnderrunCount() const {
+      return underruns.load(std::memory_order_relaxed);
+    }
+
+  private:
+    friend class StreamingEngine;
+
+    StreamSlot() {
+      for (auto &channel : ring)
+        channel.assign(RING_FRAMES, 0.0f);
+    }
+
+    // Audio thread -> I/O thread
+    std::atomic<const StreamingZone *> requestedZone{nullptr};
+    std::atomic<uint32_t> requestedGeneration{0};
+    std::atomic<juce::int64> readCount{0};
+    uint32_t activeRequest = 0; // audio thread only
+
+    // I/O thread -> audio thread
+    std::atomic<uint32_t> servedGeneration{0};
+    std::atomic<juce::int64> writeCount{0};
+    std::atomic<uint32_t> underruns{0};
+
+    // I/O thread only
+    StreamingZone::Ptr streamingZone;
+    uint32_t streamingGeneration = 0;
+
+    std::array<std::vector<float>, 2> ring;
+  };
+
+  StreamingEngine() : juce::Thread("Sphere Streaming I/O") {
+    formatManager.registerBasicFormats();
+    for (auto &channel : readScratch)
+      channel.assign(READ_CHUNK_FRAMES, 0.0f);
+    startThread(juce::Thread::Priority::high);
+  }
+
+  ~StreamingEngine() override { stopThread(4000); }
+
+  // ========================================================================
+  // Setup (message thread)
+  // Slots are only ever added, so voices and the I/O thread can keep using
+  // theirs; the I/O thread picks the new count up on its next pass and
+  // drops the zones of slots past it.
+  // ========================================================================
+  void setNumStreams(int numStreams) {
+    numStreams = juce::jlimit(0, MAX_STREAMS, numStreams);
+    for (int i = numAllocatedSlots; i < numStreams; ++i)
+      slots[static_cast<size_t>(i)].reset(new StreamSlot());
+
+    numAllocatedSlots = juce::jmax(numAllocatedSlots, numStreams);
+    numActiveStreams.store(numStreams, std::memory_order_release);
+  }
+
+  // Valid for any index below the last setNumStreams() count
+  StreamSlot &getSlot(int index) { return *slots[static_cast<size_t>(index)]; }
+
+  // Opens the file and decodes only its head; the rest is streamed on demand
+  StreamingZone::Ptr loadZone(const juce::File &file) {
+    StreamingZone::Ptr zone = new StreamingZone();
+
+    // Memory-mapped reads avoid a copy through the file cache (WAV/AIFF)
+    if (auto *format = formatManager.findFormatForFileExtension(
+            file.getFileExtension())) {
+      std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped(
+          format->createMemoryMappedReader(file));
+      if (mapped != nullptr && mapped->mapEntireFile()) {
+        zone->reader = std::move(mapped);
+        zone->memoryMapped = true;
+      }
+    }
+
+    if (zone->reader == nullptr)
+      zone->reader.reset(formatManager.createReaderFor(file));
+
+    auto &reader = zone->reader;
+    if (reader == nullptr || reader->lengthInSamples <= 0)
+      return nullptr;
+
+    const int numChannels = juce::jlimit(1, 2, (int)reader->numChannels);
+    const int headLength = static_cast<int>(juce::jmin<juce::int64>(
+        reader->lengthInSamples, (juce::int64)StreamingZone::PRELOAD_FRAMES));
+
+    zone->lengthInSamples = reader->lengthInSamples;
+    zone->head =
+        new DecodedSample(numChannels, headLength, reader->sampleRate, 0);
+
+    float *destinations[2] = {zone->head->getWritePointer(0),
+                              zone->head->getWritePointer(numChannels - 1)};
+    if (!reader->read(destinations, numChannels, 0, headLength))
+      return nullptr;
+
+    const juce::ScopedLock sl(ioLock);
+    zones.push_back(zone);
+    return zone;
+  }
+
+  // Underruns across the streams currently in use
+  uint32_t getTotalUnderruns() const {
+    uint32_t total = 0;
+    const int numStreams = numActiveStreams.load(std::memory_order_acquire);
+    for (int i = 0; i < numStreams; ++i)
+      total += slots[static_cast<size_t>(i)]->getUnderrunCount();
+    return total;
+  }
+
+private:
+  void run() override {
+    while (!threadShouldExit()) {
+      bool didWork = false;
+      const int numStreams = numActiveStreams.load(std::memory_order_acquire);
+      for (int i = 0; i < numStreams; ++i)
+        didWork = serviceSlot(*slots[static_cast<size_t>(i)]) || didWork;
+
+      // Slots past the count belong to no voice; let go of their zones
+      for (int i = numStreams; i < numSeenSlots; ++i)
+        slots[static_cast<size_t>(i)]->streamingZone = nullptr;
+      numSeenSlots = juce::jmax(numSeenSlots, numStreams);
+
+      {
+        const juce::ScopedLock sl(ioLock);
+        purgeUnusedZones();
+      }
+
+      if (!didWork)
+        wait(IO_POLL_MS);
+    }
+  }
+
+  // Tops up one voice's ring; returns true if anything was read
+  bool serviceSlot(StreamSlot &slot) {
+    const uint32_t generation =
+        slot.requestedGeneration.load(std::memory_order_acquire);
+
+    if (generation != slot.streamingGeneration) {
+      slot.streamingZone = const_cast<StreamingZone *>(
+          slot.requestedZone.load(std::memory_order_relaxed));
+      slot.streamingGeneration = generation;
+      slot.writeCount.store(0, std::memory_order_relaxed);
+      slot.servedGeneration.store(generation, std::memory_order_release);
+    }
+
+    auto *zone = slot.streamingZone.get();
+    if (zone == nullptr)
+      return false;
+
+    // After an underrun the voice has moved past frames that were never
+    // written; skip them and continue from where the voice is now
+    const juce::int64 consumed =
+        slot.readCount.load(std::memory_order_acquire);
+    const juce::int64 written = juce::jmax(
+        consumed, slot.writeCount.load(std::memory_order_relaxed));
+    const juce::int64 remaining =
+        zone->lengthInSamples - zone->getHeadLength() - written;
+    const juce::int64 freeSpace = RING_FRAMES - (written - consumed);
+
+    const int numFrames = static_cast<int>(juce::jmin<juce::int64>(
+        remaining, juce::jmin<juce::int64>(freeSpace, READ_CHUNK_FRAMES)));
+    if (numFrames <= 0)
+      return false;
+
+    const int numChannels = zone->getNumChannels();
+    float *destinations[2] = {readScratch[0].data(), readScratch[1].data()};
+    if (!zone->reader->read(destinations, numChannels,
+                            zone->getHeadLength() + written, numFrames))
+      return false;
+
+    for (int ch = 0; ch < 2; ++ch) {
+      const float *source = readScratch[juce::jmin(ch, numChannels - 1)].data();
+      auto &ring = slot.ring[static_cast<size_t>(ch)];
+      const int start = static_cast<int>(written & RING_MASK);
+      const int firstPart = juce::jmin(numFrames, RING_FRAMES - start);
+
+      std::copy(source, source + firstPart, ring.begin() + start);
+      std::copy(source + firstPart, source + numFrames, ring.begin());
+    }
+
+    slot.writeCount.store(written + numFrames, std::memory_order_release);
+    return true;
+  }
+
+  // Zones only referenced by the engine belong to no sound and no stream.
+  // Requests are adopted before this runs on the same thread, so a zone a
+  // voice has just asked for always holds a reference here already.
+  void purgeUnusedZones() {
+    zones.erase(std::remove_if(zones.begin(), zones.end(),
+                               [](const StreamingZone::Ptr &zone) {
+                                 return zone->getReferenceCount() == 1;
+                               }),
+                zones.end());
+  }
+
+  static constexpr int IO_POLL_MS = 2;
+
+  juce::AudioFormatManager formatManager;
+
+  // Held by the I/O thread while purging and by the message thread while
+  // adding zones; never by the audio thread
+  juce::CriticalSection ioLock;
+  std::vector<StreamingZone::Ptr> zones;
+
+  // A slot is allocated before any count covering it is published and is
+  // never replaced, so readers below that count need no lock
+  std::array<std::unique_ptr<StreamSlot>, MAX_STREAMS> slots;
+  std::atomic<int> numActiveStreams{0};
+  int numAllocatedSlots = 0; // message thread only
+  int numSeenSlots = 0;      // I/O thread only
+  std::array<std::vector<float>, 2> readScratch;
+};
+
+// ============================================================================
+// Streaming Sample Sound
+// ============================================================================
+class StreamingSampleSound final : public juce::SynthesiserSound {
+public:
+  StreamingSampleSound(StreamingZone::Ptr zoneToPlay,
+                       const juce::BigInteger &notes, int rootMidiNote,
+                       double attackTimeSecs, double releaseTimeSecs,
+                       SincQuality interpolationQuality = SincQuality::Low)
+      : zone(std::move(zoneToPlay)), midiNotes(notes),
+        midiRootNote(rootMidiNote), quality(interpolationQuality) {
+    params.attack = static_cast<float>(attackTimeSecs);
+    params.release = static_cast<float>(releaseTimeSecs);
+  }
+
+  bool appliesToNote(int midiNoteNumber) override {
+    return midiNotes[midiNoteNumber];
+  }
+  bool appliesToChannel(int /*midiChannel*/) override { return true; }
+
+  const StreamingZone &getZone() const { return *zone; }
+  int getRootNote() const { return midiRootNote; }
+  SincQuality getQuality() const { return quality; }
+  const juce::ADSR::Parameters &getEnvelopeParameters() const {
+    return params;
+  }
+
+private:
+  StreamingZone::Ptr zone;
+  juce::BigInteger midiNotes;
+  int midiRootNote = 60;
+  SincQuality quality;
+  juce::ADSR::Parameters params;
+};
+
+// ============================================================================
+// Streaming Sample Voice
+// ============================================================================
+class StreamingSampleVoice final : public juce::SynthesiserVoice {
+public:
+  StreamingSampleVoice(StreamingEngine &engine, int streamIndex)
+      : stream(engine.getSlot(streamIndex)),
+        resampler(SincResampler::getInstance()) {}
+
+  bool canPlaySound(juce::SynthesiserSound *sound) override {
+    return dynamic_cast<const StreamingSampleSound *>(sound) != nullptr;
+  }
+
+  void startNote(int midiNoteNumber, float velocity,
+                 juce::SynthesiserSound *s,
+                 int /*currentPitchWheelPosition*/) override {
+    auto *sound = dynamic_cast<const StreamingSampleSound *>(s);
+    if (sound == nullptr) {
+      clearCurrentNote();
+      return;
+    }
+
+    zone = &sound->getZone();
+    stream.start(zone);
+
+    pitchRatio =
+        std::pow(2.0, (midiNoteNumber - sound->getRootNote()) / 12.0) *
+        zone->getSampleRate() / getSampleRate();
+    kernel = pitchRatio != 1.0
+                 ? &resampler.getKernel(sound->getQuality(), pitchRatio)
+                 : nullptr;
+
+    sourceSamplePosition = 0.0;
+    windowStart = 0;
+    windowFrames = 0;
+    gain = velocity;
+
+    adsr.setSampleRate(getSampleRate());
+    adsr.setParameters(sound->getEnvelopeParameters());
+    adsr.noteOn();
+  }
+
+  void stopNote(float /*velocity*/, bool allowTailOff) override {
+    if (allowTailOff) {
+      adsr.noteOff();
+    } else {
+      clearCurrentNote();
+      adsr.reset();
+      stream.stop();
+      zone = nullptr;
+    }
+  }
+
+  void pitchWheelMoved(int /*newValue*/) override {}
+  void controllerMoved(int /*controllerNumber*/, int /*newValue*/) override {}
+
+  void renderNextBlock(juce::AudioBuffer<float> &outputBuffer, int startSample,
+                       int numSamples) override {
+    if (zone == nullptr)
+      return;
+
+    const int headLength = zone->getHeadLength();
+    const bool stereoSource = zone->getNumChannels() > 1;
+    const double length = static_cast<double>(zone->getLengthInSamples());
+
+    // Frames before readableEnd can be read this block; once the I/O thread
+    // has reached the end of the file everything can
+    const juce::int64 framesReady = stream.getNumFramesReady();
+    const juce::int64 readableEnd =
+        headLength + framesReady >= zone->getLengthInSamples()
+            ? std::numeric_limits<juce::int64>::max()
+            : headLength + framesReady;
+    bool underrun = false;
+
+    float *outL = outputBuffer.getWritePointer(0, startSample);
+    float *outR = outputBuffer.getNumChannels() > 1
+                      ? outputBuffer.getWritePointer(1, startSample)
+                      : nullptr;
+
+    for (int i = 0; i < numSamples; ++i) {
+      const auto pos = static_cast<juce::int64>(sourceSamplePosition);
+      const float frac = static_cast<float>(sourceSamplePosition - pos);
+
+      // A failed refill can't succeed again before the next block
+      const bool available =
+          pos + WINDOW_AFTER < windowStart + windowFrames ||
+          (!underrun && fillWindow(pos, readableEnd, headLength));
+
+      const float envelope = adsr.getNextSample() * gain;
+      float l = 0.0f;
+      float r = 0.0f;
+
+      if (available) {
+        const auto offset = static_cast<int>(pos - windowStart);
+        l = readSource(windowScratch[0].data() + offset, frac) * envelope;
+        r = stereoSource
+                ? readSource(windowScratch[1].data() + offset, frac) * envelope
+                : l;
+      } else {
+        // I/O thread is behind: play silence but keep time
+        underrun = true;
+      }
+
+      if (outR != nullptr) {
+        outL[i] += l;
+        outR[i] += r;
+      } else {
+        outL[i] += (l + r) * 0.5f;
+      }
+
+      sourceSamplePosition += pitchRatio;
+      if (sourceSamplePosition >= length || !adsr.isActive()) {
+        stopNote(0.0f, false);
+        break;
+      }
+    }
+
+    if (underrun)
+      stream.reportUnderrun();
+
+    // Keep the frames the kernel reads before the current position
+    if (zone != nullptr)
+      stream.releaseFramesBefore(
+          static_cast<juce::int64>(sourceSamplePosition) - WINDOW_BEFORE -
+          headLength);
+  }
+
+  using SynthesiserVoice::renderNextBlock;
+
+  uint32_t getUnderrunCount() const { return stream.getUnderrunCount(); }
+
+private:
+  // Source frames copied per refill, and the frames the widest kernel reads
+  // around a position
+  static constexpr int WINDOW_FRAMES = 256;
+  static constexpr int WINDOW_BEFORE =
+      SincResampler::getFramesBefore(SincResampler::MAX_TAPS);
+  static constexpr int WINDOW_AFTER =
+      SincResampler::getFramesAfter(SincResampler::MAX_TAPS);
+
+  float readSource(const float *x, float frac) const {
+    return kernel != nullptr ? kernel->interpolate(x, frac) : x[0];
+  }
+
+  // Copies the frames around position that are readable into the window;
+  // returns false if the kernel's frames aren't all there yet
+  bool fillWindow(juce::int64 position, juce::int64 readableEnd,
+                  int headLength) {
+    windowStart = position - WINDOW_BEFORE;
+    windowFrames = static_cast<int>(juce::jlimit<juce::int64>(
+        0, WINDOW_FRAMES, readableEnd - windowStart));
+
+    for (int ch = 0; ch < zone->getNumChannels(); ++ch)
+      for (int f = 0; f < windowFrames; ++f)
+        windowScratch[static_cast<size_t>(ch)][static_cast<size_t>(f)] =
+            readFrame(ch, windowStart + f, headLength);
+
+    return position + WINDOW_AFTER < windowStart + windowFrames;
+  }
+
+  // Frame from the head (whose leading guard covers frames just before 0)
+  // or, past it, from the ring; zero beyond the end
+  float readFrame(int channel, juce::int64 frame, int headLength) const {
+    if (frame < headLength)
+      return zone->getHead().getReadPointer(channel)[frame];
+    if (frame >= zone->getLengthInSamples())
+      return 0.0f;
+    return stream.getFrame(channel, frame - headLength);
+  }
+
+  StreamingEngine::StreamSlot &stream;
+  const SincResampler &resampler;
+  const SincResampler::Kernel *kernel = nullptr;
+  const StreamingZone *zone = nullptr;
+  double pitchRatio = 0.0;
+  double sourceSamplePosition = 0.0;
+  float gain = 0.0f;
+  juce::ADSR adsr;
+
+  // Source frames [windowStart, windowStart + windowFrames)
+  juce::int64 windowStart = 0;
+  int windowFrames = 0;
+  alignas(SIMD_ALIGNMENT) std::array<float, WINDOW_FRAMES> windowScratch[2];
+};
+
+} // namespace Synth
+} // namespace Sphere
@@ -0,0 +1,91 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <cstdint>
+
+namespace Sphere {
+namespace Synth {
+
+// ============================================================================
+// Oscillator Wave Shapes
+// ============================================================================
+enum class WaveShape : int32_t { Sine, Saw, Square, Triangle, Wavetable };
+
+// ============================================================================
+// Per-Voice Filter Modes
+// ============================================================================
+enum class FilterMode : int32_t { Off, LowPass, BandPass, HighPass, Notch };
+
+// ============================================================================
+// Voice Stealing
+// ============================================================================
+enum class VoiceStealingMode {
+  Oldest,   // Longest-running voice
+  Quietest, // Lowest current output level
+  SameNote  // Voice already playing the incoming note, else oldest
+};
+
+// ============================================================================
+// Voice Pool Layout
+// ============================================================================
+// Voices preallocated per family; the total is capped at MAX_POOL_VOICES
+struct VoiceCounts {
+  int oscillator = 0;
+  int sampler = 0;
+  int streaming = 0;
+  int fm = 0;
+  int granular = 0;
+  int additive = 0;
+  int waveguide = 0;
+};
+
+// ============================================================================
+// Constants
+// ============================================================================
+// Bank slots are single oscillators; a unison voice uses several of them
+constexpr int MAX_BANK_VOICES = 1024;
+constexpr int MAX_POOL_VOICES = 256;
+constexpr int MAX_UNISON_VOICES = 16;
+
+// Voices rendered per SIMD register. Loops over VOICE_LANES are written so
+// the compiler maps one iteration to one vector instruction.
+#if defined(__AVX512F__)
+constexpr int VOICE_LANES = 16;
+#elif defined(__AVX__)
+constexpr int VOICE_LANES = 8;
+#else
+constexpr int VOICE_LANES = 4; // SSE2 / NEON
+#endif
+
+constexpr int MAX_VOICE_GROUPS = MAX_BANK_VOICES / VOICE_LANES;
+constexpr int SIMD_ALIGNMENT = 64;
+
+// Original per-voice behaviour: gain = velocity * 0.15, release multiplies
+// the tail by 0.99 every sample and the voice is freed below 0.005
+constexpr float VOICE_LEVEL_SCALE = 0.15f;
+constexpr float TAIL_OFF_COEFF = 0.99f;
+constexpr float TAIL_OFF_CUTOFF = 0.005f;
+
+// Fade applied to a stolen voice while its replacement starts (~5 ms at
+// 48 kHz from full level to the cutoff)
+constexpr float STEAL_FADE_COEFF = 0.98f;
+
+// ============================================================================
+// Structure-of-arrays storage for one float per bank voice
+// ============================================================================
+struct alignas(SIMD_ALIGNMENT) VoiceLaneArray {
+  std::array<float, MAX_BANK_VOICES> data{};
+
+  float &operator[](int index) { return data[index]; }
+  float operator[](int index) const { return data[index]; }
+
+  float *group(int groupIndex) {
+    return data.data() + groupIndex * VOICE_LANES;
+  }
+  const float *group(int groupIndex) const {
+    return data.data() + groupIndex * VOICE_LANES;
+  }
+};
+
+} // namespace Synth
+} // namespace Sphere
@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+    SphereVoiceFilter.h
+    Resonant state-variable filter evaluated per lane across a voice group
+
+    Topology-preserving (trapezoidal) SVF: two integrator states per lane,
+    stable under any coefficient change, so the cutoff can jump once per
+    modulation tick without zipper-induced blow-ups. All four responses
+    come from the same update as a mix of input, band and low outputs, so
+    lanes with different modes (or no filter) share one branch-free loop.
+
+    Coefficients cost a tan and a divide, so they are recomputed at
+    control rate (per tick or per render chunk), not per sample.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../Common/SphereFastMath.h"
+#include "SphereSynthTypes.h"
+
+namespace Sphere {
+namespace Synth {
+
+// ============================================================================
+// Per-group filter state and coefficients
+// ============================================================================
+struct FilterLanes {
+  // Integrator states (trapezoidal equivalent currents)
+  alignas(SIMD_ALIGNMENT) float state1[VOICE_LANES];
+  alignas(SIMD_ALIGNMENT) float state2[VOICE_LANES];
+
+  // Update coefficients from g = tan(pi * fc) and the damping k = 1 / Q
+  alignas(SIMD_ALIGNMENT) float a1[VOICE_LANES];
+  alignas(SIMD_ALIGNMENT) float a2[VOICE_LANES];
+  alignas(SIMD_ALIGNMENT) float a3[VOICE_LANES];
+
+  // Output = input * mixInput + band * mixBand + low * mixLow; the band
+  // pass is scaled to unity gain at its peak
+  alignas(SIMD_ALIGNMENT) float mixInput[VOICE_LANES];
+  alignas(SIMD_ALIGNMENT) float mixBand[VOICE_LANES];
+  alignas(SIMD_ALIGNMENT) float mixLow[VOICE_LANES];
+};
+
+namespace VoiceFilter {
+// Cutoff in cycles per sample; the top stays clear of tan's pole
+constexpr float MIN_CUTOFF = 1.0e-4f;
+constexpr float MAX_CUTOFF = 0.49f;
+
+// Q; 0.707 is maximally flat, the top end rings without self-oscillating
+constexpr float MIN_RESONANCE = 0.5f;
+constexpr float MAX_RESONANCE = 25.0f;
+constexpr float DEFAULT_RESONANCE = 0.7071f;
+
+// States below this are flushed once per tick, so a silent lane never
+// decays into denormals
+constexpr float STATE_FLOOR = 1.0e-15f;
+
+inline void setCoefficients(FilterLanes &lanes, int l, int32_t mode,
+                            float cutoff, float damping) {
+  const float g =
+      FastMath::tanPi(juce::jlimit(MIN_CUTOFF, MAX_CUTOFF, cutoff));
+  const float a1 = 1.0f / (1.0f + g * (g + damping));
+  lanes.a1[l] = a1;
+  lanes.a2[l] = g * a1;
+  lanes.a3[l] = g * g * a1;
+
+  const auto m = static_cast<FilterMode>(mode);
+  const bool lowPass = m == FilterMode::LowPass;
+  const bool bandPass = m == FilterMode::BandPass;
+  const bool highPass = m == FilterMode::HighPass;
+  const bool notch = m == FilterMode::Notch;
+  lanes.mixInput[l] = (lowPass || bandPass) ? 0.0f : 1.0f;
+  lanes.mixBand[l] =
+      bandPass ? damping : ((highPass || notch) ? -damping : 0.0f);
+  lanes.mixLow[l] = lowPass ? 1.0f : (highPass ? -1.0f : 0.0f);
+}
+
+inline float process(FilterLanes &lanes, int l, float x) {
+  const float v3 = x - lanes.state2[l];
+  const float band = lanes.a1[l] * lanes.state1[l] + lanes.a2[l] * v3;
+  const float low =
+      lanes.state2[l] + lanes.a2[l] * lanes.state1[l] + lanes.a3[l] * v3;
+  lanes.state1[l] = 2.0f * band - lanes.state1[l];
+  lanes.state2[l] = 2.0f * low - lanes.state2[l];
+  return x * lanes.mixInput[l] + band * lanes.mixBand[l] +
+         low * lanes.mixLow[l];
+}
+
+inline void flushDenormals(FilterLanes &lanes, int l) {
+  lanes.state1[l] =
+      std::abs(lanes.state1[l]) < STATE_FLOOR ? 0.0f : lanes.state1[l];
+  lanes.state2[l] =
+      std::abs(lanes.state2[l]) < STATE_FLOOR ? 0.0f : lanes.state2[l];
+}
+
+// Q to the damping term
+inline float getDamping(float resonance) {
+  return 1.0f / juce::jlimit(MIN_RESONANCE, MAX_RESONANCE, resonance);
+}
+} // namespace VoiceFilter
+
+} // namespace Synth
+} // namespace Sphere
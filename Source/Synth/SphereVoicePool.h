@@ -0,0 +1,251 @@
+/*
+  ==============================================================================
+    SphereVoicePool.h
+    Preallocated voice bookkeeping with O(1) allocation and note lookup
+
+    The pool only deals in voice indices. Free voices sit on an intrusive
+    free list per voice family (one family per kind of voice, e.g.
+    oscillator or sampler), allocated voices on a per-family list ordered
+    by start time, and every allocated voice is linked into a chain hanging
+    off a [channel][note] table, so note-on, note-off and stealing never
+    scan the whole voice array.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "SphereSynthTypes.h"
+
+namespace Sphere {
+namespace Synth {
+
+// ============================================================================
+// Voice Pool
+// ============================================================================
+class VoicePool {
+public:
+  static constexpr int MAX_FAMILIES = 8;
+  static constexpr int NUM_CHANNELS = 16;
+  static constexpr int NUM_NOTES = 128;
+
+  VoicePool() { clear(); }
+
+  // ========================================================================
+  // Setup (message thread, with the synth lock held)
+  // ========================================================================
+  void clear() {
+    numVoices = 0;
+    freeHead.fill(-1);
+    activeHead.fill(-1);
+    activeTail.fill(-1);
+    noteHead.fill(-1);
+  }
+
+  // Returns the new voice's index, or -1 if the pool is full
+  int addVoice(int family) {
+    if (numVoices >= MAX_POOL_VOICES || family < 0 || family >= MAX_FAMILIES)
+      return -1;
+
+    const int v = numVoices++;
+    families[v] = family;
+    allocated[v] = 0;
+    noteKeys[v] = -1;
+    prevActive[v] = nextActive[v] = -1;
+    prevForNote[v] = nextForNote[v] = -1;
+
+    nextFree[v] = freeHead[family];
+    freeHead[family] = v;
+    return v;
+  }
+
+  int getNumVoices() const { return numVoices; }
+  int getFamily(int v) const { return families[v]; }
+  bool isAllocated(int v) const { return allocated[v] != 0; }
+
+  // ========================================================================
+  // Allocation (audio thread)
+  // ========================================================================
+
+  // Pops a free voice and makes it the youngest allocated one; -1 if the
+  // family has no free voices left
+  int allocate(int family) {
+    const int v = freeHead[family];
+    if (v < 0)
+      return -1;
+
+    freeHead[family] = nextFree[v];
+    allocated[v] = 1;
+    appendActive(v);
+    return v;
+  }
+
+  // A stolen voice keeps its allocation but becomes the youngest again
+  void recycle(int v) {
+    unlinkNote(v);
+    unlinkActive(v);
+    appendActive(v);
+  }
+
+  // Returns a finished voice to its family's free list
+  void release(int v) {
+    if (!isAllocated(v))
+      return;
+
+    unlinkNote(v);
+    unlinkActive(v);
+    allocated[v] = 0;
+    nextFree[v] = freeHead[families[v]];
+    freeHead[families[v]] = v;
+  }
+
+  // ========================================================================
+  // Note table
+  // ========================================================================
+  void assignNote(int v, int midiChannel, int midiNoteNumber) {
+    unlinkNote(v);
+
+    const int key = getNoteKey(midiChannel, midiNoteNumber);
+    if (key < 0)
+      return;
+
+    noteKeys[v] = key;
+    prevForNote[v] = -1;
+    nextForNote[v] = noteHead[key];
+    if (noteHead[key] >= 0)
+      prevForNote[noteHead[key]] = v;
+    noteHead[key] = v;
+  }
+
+  int getFirstVoiceForNote(int midiChannel, int midiNoteNumber) const {
+    const int key = getNoteKey(midiChannel, midiNoteNumber);
+    return key >= 0 ? noteHead[key] : -1;
+  }
+
+  int getNextVoiceForNote(int v) const { return nextForNote[v]; }
+
+  // ========================================================================
+  // Allocated voices, oldest first
+  // ========================================================================
+  int getOldestVoice(int family) const { return activeHead[family]; }
+  int getNextYoungerVoice(int v) const { return nextActive[v]; }
+
+  // ========================================================================
+  // Stealing
+  // isReleased(v) - voice's key is up and not held by a pedal
+  // getLevel(v)   - current output level, used by VoiceStealingMode::Quietest
+  // Released voices are always preferred over held ones.
+  // ========================================================================
+  template <typename IsReleased, typename GetLevel>
+  int findVoiceToSteal(int family, VoiceStealingMode mode, int midiChannel,
+                       int midiNoteNumber, IsReleased &&isReleased,
+                       GetLevel &&getLevel) const {
+    if (mode == VoiceStealingMode::SameNote) {
+      for (int v = getFirstVoiceForNote(midiChannel, midiNoteNumber); v >= 0;
+           v = nextForNote[v]) {
+        if (families[v] == family)
+          return v;
+      }
+    }
+
+    int bestReleased = -1;
+    int bestHeld = -1;
+    float bestReleasedLevel = 0.0f;
+    float bestHeldLevel = 0.0f;
+
+    for (int v = activeHead[family]; v >= 0; v = nextActive[v]) {
+      if (mode != VoiceStealingMode::Quietest) {
+        // Oldest (and same-note fallback): list is already in age order
+        if (isReleased(v))
+          return v;
+        if (bestHeld < 0)
+          bestHeld = v;
+        continue;
+      }
+
+      const float voiceLevel = getLevel(v);
+      if (isReleased(v)) {
+        if (bestReleased < 0 || voiceLevel < bestReleasedLevel) {
+          bestReleased = v;
+          bestReleasedLevel = voiceLevel;
+        }
+      } else if (bestHeld < 0 || voiceLevel < bestHeldLevel) {
+        bestHeld = v;
+        bestHeldLevel = voiceLevel;
+      }
+    }
+
+    return bestReleased >= 0 ? bestReleased : bestHeld;
+  }
+
+private:
+  static int getNoteKey(int midiChannel, int midiNoteNumber) {
+    if (midiChannel < 1 || midiChannel > NUM_CHANNELS ||
+        midiNoteNumber < 0 || midiNoteNumber >= NUM_NOTES)
+      return -1;
+    return (midiChannel - 1) * NUM_NOTES + midiNoteNumber;
+  }
+
+  void appendActive(int v) {
+    const int family = families[v];
+    prevActive[v] = activeTail[family];
+    nextActive[v] = -1;
+    if (activeTail[family] >= 0)
+      nextActive[activeTail[family]] = v;
+    else
+      activeHead[family] = v;
+    activeTail[family] = v;
+  }
+
+  void unlinkActive(int v) {
+    const int family = families[v];
+    if (prevActive[v] >= 0)
+      nextActive[prevActive[v]] = nextActive[v];
+    else
+      activeHead[family] = nextActive[v];
+
+    if (nextActive[v] >= 0)
+      prevActive[nextActive[v]] = prevActive[v];
+    else
+      activeTail[family] = prevActive[v];
+
+    prevActive[v] = nextActive[v] = -1;
+  }
+
+  void unlinkNote(int v) {
+    const int key = noteKeys[v];
+    if (key < 0)
+      return;
+
+    if (prevForNote[v] >= 0)
+      nextForNote[prevForNote[v]] = nextForNote[v];
+    else
+      noteHead[key] = nextForNote[v];
+
+    if (nextForNote[v] >= 0)
+      prevForNote[nextForNote[v]] = prevForNote[v];
+
+    prevForNote[v] = nextForNote[v] = -1;
+    noteKeys[v] = -1;
+  }
+
+  int numVoices = 0;
+
+  // Per-voice intrusive links
+  std::array<int, MAX_POOL_VOICES> families{};
+  std::array<uint8_t, MAX_POOL_VOICES> allocated{};
+  std::array<int, MAX_POOL_VOICES> nextFree{};
+  std::array<int, MAX_POOL_VOICES> prevActive{};
+  std::array<int, MAX_POOL_VOICES> nextActive{};
+  std::array<int, MAX_POOL_VOICES> noteKeys{};
+  std::array<int, MAX_POOL_VOICES> prevForNote{};
+  std::array<int, MAX_POOL_VOICES> nextForNote{};
+
+  // List heads
+  std::array<int, MAX_FAMILIES> freeHead{};
+  std::array<int, MAX_FAMILIES> activeHead{};
+  std::array<int, MAX_FAMILIES> activeTail{};
+  std::array<int, NUM_CHANNELS * NUM_NOTES> noteHead{};
+};
+
+} // namespace Synth
+} // namespace Sphere
@@ -0,0 +1,635 @@
+/*
+  ==============================================================================
+    SphereWaveguide.h
+    Plucked and bowed string voices on single-loop digital waveguides
+
+    Each string is a delay loop (Karplus-Strong): a ring buffer tuned to the
+    note's period by an integer delay plus a first-order allpass for the
+    fraction, with a one-zero lowpass and a loop gain setting brightness and
+    decay time. Plucks load the loop with a filtered noise burst; bowed
+    notes drive it through a friction (bow table) nonlinearity instead.
+
+    Rings are power-of-two sized and carved from one arena allocated in
+    prepare(). Within a lane group the rings are interleaved by lane, so
+    the per-sample write of all VOICE_LANES strings is one contiguous store
+    at a write index shared by the whole bank; only the tuned taps differ
+    per lane. Allpass, loop filter and bow run across the lanes, and groups
+    render on the optional worker pool like the other banks.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../Common/SphereWorkerPool.h"
+#include "SphereSynthTypes.h"
+#include <cmath>
+#include <vector>
+
+namespace Sphere {
+namespace Synth {
+
+constexpr int MAX_WAVEGUIDE_VOICES = MAX_POOL_VOICES;
+constexpr int MAX_WAVEGUIDE_GROUPS = MAX_WAVEGUIDE_VOICES / VOICE_LANES;
+
+enum class StringExcitation { Pluck, Bow };
+
+struct WaveguidePatch {
+  StringExcitation excitation = StringExcitation::Pluck;
+  float decay = 4.0f;         // seconds to -60 dB at middle C
+  float brightness = 0.6f;    // 0 = dark and short-lived highs, 1 = bright
+  float position = 0.2f;      // pluck or bow point along the string, 0..0.5
+  float bowPressure = 0.5f;   // 0..1
+  float release = 0.15f;      // damped decay after note-off, seconds
+};
+
+// ============================================================================
+// Waveguide Bank
+// ============================================================================
+class WaveguideBank {
+public:
+  // Lowest fundamental a ring can hold at the prepared sample rate
+  static constexpr double LOWEST_FREQUENCY = 20.0;
+
+  WaveguideBank() { reset(); }
+
+  // ========================================================================
+  // Setup (message thread, before playback)
+  // ========================================================================
+  void prepare(double sampleRate, int maxBlockSize) {
+    this->sampleRate = sampleRate;
+    this->maxBlockSize = juce::jmax(1, maxBlockSize);
+
+    ringSize = juce::nextPowerOfTwo(
+        static_cast<int>(std::ceil(sampleRate / LOWEST_FREQUENCY)) + 4);
+    ringMask = ringSize - 1;
+    arena.assign(static_cast<size_t>(ringSize) * MAX_WAVEGUIDE_VOICES, 0.0f);
+    excitationScratch.assign(static_cast<size_t>(ringSize), 0.0f);
+
+    groupMix.assign(static_cast<size_t>(this->maxBlockSize) *
+                        MAX_WAVEGUIDE_GROUPS,
+                    0.0f);
+    monoMix.assign(static_cast<size_t>(this->maxBlockSize), 0.0f);
+    reset();
+  }
+
+  // Optional; nullptr renders every group on the calling thread
+  void setWorkerPool(RealtimeWorkerPool *poolToUse) { workerPool = poolToUse; }
+
+  void reset() {
+    for (int slot = 0; slot < MAX_WAVEGUIDE_VOICES; ++slot)
+      clearSlot(slot);
+
+    std::fill(arena.begin(), arena.end(), 0.0f);
+    groupActiveCount.fill(0);
+    numActiveVoices = 0;
+    writeIndex = 0;
+  }
+
+  // ========================================================================
+  // Slot allocation (audio thread)
+  // ========================================================================
+
+  // Claims the lowest free slot for an owner (any id >= 0), or cuts short a
+  // fading slot nobody owns any more; -1 if every slot is owned
+  int allocateSlot(int owner) {
+    int slot = -1;
+    for (int s = 0; s < MAX_WAVEGUIDE_VOICES && slot < 0; ++s)
+      if (active[s] == 0)
+        slot = s;
+
+    for (int s = 0; s < MAX_WAVEGUIDE_VOICES && slot < 0; ++s) {
+      if (owners[s] < 0) {
+        killVoice(s);
+        slot = s;
+      }
+    }
+
+    if (slot < 0)
+      return -1;
+
+    setActive(slot, true);
+    owners[slot] = owner;
+    return slot;
+  }
+
+  int getSlotOwner(int slot) const {
+    return isVoiceActive(slot) ? owners[slot] : -1;
+  }
+
+  // ========================================================================
+  // Voice control (audio thread)
+  // ========================================================================
+  void startVoice(int slot, const WaveguidePatch &patch, double frequency,
+                  float velocity) {
+    if (!isVoiceActive(slot) || arena.empty())
+      return;
+
+    // Loop delay = ring delay + allpass fraction + the lowpass's phase
+    // delay at the fundamental
+    const double period = juce::jlimit(
+        4.0, static_cast<double>(ringSize - 4), sampleRate / frequency);
+    const double omega = juce::MathConstants<double>::twoPi / period;
+    const float b = 0.5f * (1.0f - juce::jlimit(0.0f, 1.0f, patch.brightness));
+    const double lowpassDelay =
+        std::atan2(b * std::sin(omega), (1.0 - b) + b * std::cos(omega)) /
+        omega;
+
+    const double loopDelay = period - lowpassDelay;
+    const int integerDelay = static_cast<int>(loopDelay - 0.1);
+    const double fraction = loopDelay - integerDelay; // [0.1, 1.1)
+
+    delay[slot] = integerDelay;
+    allpassCoeff[slot] =
+        static_cast<float>((1.0 - fraction) / (1.0 + fraction));
+    lowpassCurrent[slot] = 1.0f - b;
+    lowpassPrevious[slot] = b;
+
+    // Higher strings ring shorter: T60 scales with sqrt(C4 / f)
+    const double t60 =
+        juce::jmax(0.01, patch.decay * std::sqrt(261.63 / frequency));
+    loopGain[slot] = gainForDecay(t60, frequency);
+    releaseGain[slot] = gainForDecay(
+        juce::jmax(0.005, static_cast<double>(patch.release)), frequency);
+
+    allpassIn[slot] = 0.0f;
+    allpassOut[slot] = 0.0f;
+    lowpassIn[slot] = 0.0f;
+    blockerIn[slot] = 0.0f;
+    blockerOut[slot] = 0.0f;
+    peak[slot] = 0.0f;
+    outputGain[slot] = VOICE_LEVEL_SCALE;
+
+    // The bow sits this far (round trip) from the bridge end of the loop
+    bowDelay[slot] = juce::jlimit(
+        1, juce::jmax(1, integerDelay - 1),
+        static_cast<int>(juce::jlimit(0.02f, 0.5f, patch.position) *
+                         static_cast<float>(integerDelay)));
+
+    clearRing(slot);
+    if (patch.excitation == StringExcitation::Pluck) {
+      pluck(slot, integerDelay, patch, velocity);
+      bowing[slot] = 0.0f;
+      bowTarget[slot] = 0.0f;
+    } else {
+      bowing[slot] = 1.0f;
+      bowTarget[slot] = 0.03f + 0.2f * velocity;
+      bowVelocity[slot] = 0.0f;
+      bowSlope[slot] =
+          5.0f - 4.0f * juce::jlimit(0.0f, 1.0f, patch.bowPressure);
+    }
+  }
+
+  // Dampers on and the bow lifted: the string rings out at the release
+  // decay
+  void releaseVoice(int slot) {
+    if (!isVoiceActive(slot))
+      return;
+    loopGain[slot] = releaseGain[slot];
+    liftBow(slot);
+  }
+
+  // Fast damp for a stolen voice; detaches the owner, the slot frees itself
+  void fadeOutVoice(int slot) {
+    if (!isVoiceActive(slot))
+      return;
+    loopGain[slot] = juce::jmin(loopGain[slot], STEAL_LOOP_GAIN);
+    liftBow(slot);
+    owners[slot] = -1;
+  }
+
+  void killVoice(int slot) {
+    if (!isVoiceActive(slot))
+      return;
+    setActive(slot, false);
+    clearSlot(slot);
+  }
+
+  bool isVoiceActive(int slot) const {
+    return slot >= 0 && slot < MAX_WAVEGUIDE_VOICES && active[slot] != 0;
+  }
+
+  int getNumActiveVoices() const { return numActiveVoices; }
+
+  // Peak output of the last rendered chunk
+  float getVoiceLevel(int slot) const {
+    return isVoiceActive(slot) ? peak[slot] : 0.0f;
+  }
+
+  // ========================================================================
+  // Render all active strings and add them to every channel of the buffer
+  // ========================================================================
+  void render(juce::AudioBuffer<float> &buffer, int startSample,
+              int numSamples) {
+    if (numActiveVoices == 0 || monoMix.empty())
+      return;
+
+    while (numSamples > 0) {
+      const int chunk = juce::jmin(numSamples, maxBlockSize);
+      renderChunk(buffer, startSample, chunk);
+      startSample += chunk;
+      numSamples -= chunk;
+    }
+  }
+
+private:
+  void renderChunk(juce::AudioBuffer<float> &buffer, int startSample,
+                   int numSamples) {
+    numRenderGroups = 0;
+    for (int g = 0; g < MAX_WAVEGUIDE_GROUPS; ++g)
+      if (groupActiveCount[g] != 0)
+        renderGroups[numRenderGroups++] = g;
+
+    chunkSamples = numSamples;
+    if (workerPool != nullptr)
+      workerPool->run(numRenderGroups, &renderGroupTask, this);
+    else
+      for (int t = 0; t < numRenderGroups; ++t)
+        renderGroupTask(this, t, 0);
+
+    // Every ring advanced by the chunk, rendered or not
+    writeIndex = (writeIndex + numSamples) & ringMask;
+
+    // Fixed-order mixdown, then culling (touches shared counters)
+    juce::FloatVectorOperations::clear(monoMix.data(), numSamples);
+    for (int t = 0; t < numRenderGroups; ++t) {
+      const int g = renderGroups[t];
+      juce::FloatVectorOperations::add(monoMix.data(), getGroupMix(g),
+                                       numSamples);
+      cullGroup(g);
+    }
+
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+      juce::FloatVectorOperations::add(buffer.getWritePointer(ch, startSample),
+                                       monoMix.data(), numSamples);
+  }
+
+  static void renderGroupTask(void *context, int taskIndex,
+                              int /*workerIndex*/) {
+    auto &bank = *static_cast<WaveguideBank *>(context);
+    const int g = bank.renderGroups[taskIndex];
+    bank.renderGroup(g, bank.getGroupMix(g), bank.chunkSamples);
+  }
+
+  float *getGroupMix(int g) {
+    return groupMix.data() + static_cast<size_t>(g) * maxBlockSize;
+  }
+
+  float *getGroupRings(int g) {
+    return arena.data() + static_cast<size_t>(g) * ringSize * VOICE_LANES;
+  }
+
+  void renderGroup(int g, float *out, int numSamples) {
+    alignas(SIMD_ALIGNMENT) int32_t d[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) int32_t bowTap[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float apCoeff[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float apIn[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float apOut[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float lpCurrent[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float lpPrevious[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float lpIn[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float gain[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float bowOn[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float bowVel[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float bowTo[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float slope[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float outGain[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float lanePeak[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float dcIn[VOICE_LANES];
+    alignas(SIMD_ALIGNMENT) float dcOut[VOICE_LANES];
+
+    const int base = g * VOICE_LANES;
+    for (int l = 0; l < VOICE_LANES; ++l) {
+      d[l] = delay[base + l];
+      bowTap[l] = bowDelay[base + l];
+      apCoeff[l] = allpassCoeff[base + l];
+      apIn[l] = allpassIn[base + l];
+      apOut[l] = allpassOut[base + l];
+      lpCurrent[l] = lowpassCurrent[base + l];
+      lpPrevious[l] = lowpassPrevious[base + l];
+      lpIn[l] = lowpassIn[base + l];
+      gain[l] = loopGain[base + l];
+      bowOn[l] = bowing[base + l];
+      bowVel[l] = bowVelocity[base + l];
+      bowTo[l] = bowTarget[base + l];
+      slope[l] = bowSlope[base + l];
+      outGain[l] = outputGain[base + l];
+      lanePeak[l] = 0.0f;
+      dcIn[l] = blockerIn[base + l];
+      dcOut[l] = blockerOut[base + l];
+    }
+
+    float *rings = getGroupRings(g);
+    const int mask = ringMask;
+    int w = writeIndex;
+
+    for (int i = 0; i < numSamples; ++i) {
+      float *writeFrame = rings + static_cast<size_t>(w) * VOICE_LANES;
+      alignas(SIMD_ALIGNMENT) float mix[VOICE_LANES];
+
+      for (int l = 0; l < VOICE_LANES; ++l) {
+        const float x = rings[((w - d[l]) & mask) * VOICE_LANES + l];
+
+        // Fractional delay
+        const float ap = apCoeff[l] * (x - apOut[l]) + apIn[l];
+        apIn[l] = x;
+        apOut[l] = ap;
+
+        // Loop filter: one-zero lowpass and decay
+        const float lp =
+            gain[l] * (lpCurrent[l] * ap + lpPrevious[l] * lpIn[l]);
+        lpIn[l] = ap;
+
+        // Bow junction. The wave heading for the nut passed the bow
+        // bowTap samples ago, after one (inverting) bridge reflection, and
+        // is still in the ring; the bow adds its velocity to it in place
+        // and to the wave leaving for the bridge.
+        float *bridgeWave =
+            rings + ((w - bowTap[l]) & mask) * VOICE_LANES + l;
+        bowVel[l] += (bowTo[l] - bowVel[l]) * BOW_SMOOTHING;
+        const float dv = bowVel[l] - (lp - *bridgeWave);
+        const float t = std::abs(dv * slope[l]) + 0.75f;
+        const float t2 = t * t;
+        const float friction = juce::jmin(1.0f, 1.0f / (t2 * t2));
+        const float injected = dv * friction * bowOn[l];
+        const float y = lp + injected;
+
+        *bridgeWave -= injected;
+        writeFrame[l] = y;
+
+        // The bow pushes the loop off centre; keep that out of the mix
+        const float heard = y - dcIn[l] + DC_BLOCKER_POLE * dcOut[l];
+        dcIn[l] = y;
+        dcOut[l] = heard;
+        mix[l] = heard * outGain[l];
+        lanePeak[l] = juce::jmax(lanePeak[l], std::abs(y));
+      }
+
+      float total = 0.0f;
+      for (int l = 0; l < VOICE_LANES; ++l)
+        total += mix[l];
+      out[i] = total;
+
+      w = (w + 1) & mask;
+    }
+
+    for (int l = 0; l < VOICE_LANES; ++l) {
+      allpassIn[base + l] = apIn[l];
+      allpassOut[base + l] = apOut[l];
+      lowpassIn[base + l] = lpIn[l];
+      bowVelocity[base + l] = bowVel[l];
+      blockerIn[base + l] = dcIn[l];
+      blockerOut[base + l] = dcOut[l];
+      peak[base + l] = lanePeak[l] * outGain[l];
+    }
+  }
+
+  // A string is finished once it has rung down and nothing drives it
+  void cullGroup(int g) {
+    const int base = g * VOICE_LANES;
+    for (int l = 0; l < VOICE_LANES; ++l) {
+      const int slot = base + l;
+      if (active[slot] != 0 && bowTarget[slot] <= 0.0f &&
+          bowVelocity[slot] < STRING_TAIL_CUTOFF &&
+          peak[slot] < STRING_TAIL_CUTOFF * VOICE_LEVEL_SCALE)
+        killVoice(slot);
+    }
+  }
+
+  // Filtered noise burst with a comb notch at the pluck position, one
+  // period long, placed so the next reads start at its first sample
+  void pluck(int slot, int period, const WaveguidePatch &patch,
+             float velocity) {
+    float *e = excitationScratch.data();
+
+    // Softer plucks are darker
+    const float cutoff =
+        juce::jlimit(0.05f, 1.0f, 0.2f + 0.8f * patch.brightness * velocity);
+    float state = 0.0f;
+    double mean = 0.0;
+    for (int i = 0; i < period; ++i) {
+      state += cutoff * ((2.0f * random.nextFloat() - 1.0f) - state);
+      e[i] = state;
+    }
+
+    const int notch = juce::jlimit(
+        1, juce::jmax(1, period - 1),
+        static_cast<int>(patch.position * static_cast<float>(period)));
+    for (int i = period - 1; i >= notch; --i)
+      e[i] -= e[i - notch];
+
+    for (int i = 0; i < period; ++i)
+      mean += e[i];
+    mean /= period;
+
+    float loudest = 1.0e-6f;
+    for (int i = 0; i < period; ++i) {
+      e[i] -= static_cast<float>(mean);
+      loudest = juce::jmax(loudest, std::abs(e[i]));
+    }
+
+    float *rings = getGroupRings(slot / VOICE_LANES);
+    const int lane = slot % VOICE_LANES;
+    const float scale = velocity / loudest;
+    for (int i = 0; i < period; ++i) {
+      const int index = (writeIndex - period + i) & ringMask;
+      rings[static_cast<size_t>(index) * VOICE_LANES + lane] = e[i] * scale;
+    }
+  }
+
+  void clearRing(int slot) {
+    float *rings = getGroupRings(slot / VOICE_LANES);
+    const int lane = slot % VOICE_LANES;
+    for (int i = 0; i < ringSize; ++i)
+      rings[static_cast<size_t>(i) * VOICE_LANES + lane] = 0.0f;
+  }
+
+  void liftBow(int slot) {
+    bowing[slot] = 0.0f;
+    bowTarget[slot] = 0.0f;
+    bowVelocity[slot] = 0.0f;
+  }
+
+  // Loop gain that decays 60 dB in t60 seconds, applied once per period
+  float gainForDecay(double t60, double frequency) const {
+    return static_cast<float>(std::pow(10.0, -3.0 / (frequency * t60)));
+  }
+
+  void setActive(int slot, bool shouldBeActive) {
+    const bool wasActive = active[slot] != 0;
+    if (wasActive == shouldBeActive)
+      return;
+
+    active[slot] = shouldBeActive ? 1 : 0;
+    const int delta = shouldBeActive ? 1 : -1;
+    groupActiveCount[slot / VOICE_LANES] += delta;
+    numActiveVoices += delta;
+  }
+
+  // Idle lanes still run through the kernel: zero loop gain and no bow
+  void clearSlot(int slot) {
+    delay[slot] = 1;
+    bowDelay[slot] = 1;
+    allpassCoeff[slot] = 0.0f;
+    allpassIn[slot] = 0.0f;
+    allpassOut[slot] = 0.0f;
+    lowpassCurrent[slot] = 0.0f;
+    lowpassPrevious[slot] = 0.0f;
+    lowpassIn[slot] = 0.0f;
+    loopGain[slot] = 0.0f;
+    releaseGain[slot] = 0.0f;
+    bowing[slot] = 0.0f;
+    bowVelocity[slot] = 0.0f;
+    bowTarget[slot] = 0.0f;
+    bowSlope[slot] = 5.0f;
+    blockerIn[slot] = 0.0f;
+    blockerOut[slot] = 0.0f;
+    outputGain[slot] = 0.0f;
+    peak[slot] = 0.0f;
+    active[slot] = 0;
+    owners[slot] = -1;
+  }
+
+  // Loop gain for a stolen string: -12 dB per period, so -60 dB after five
+  // periods (50 ms at 100 Hz, 5 ms at 1 kHz)
+  static constexpr float STEAL_LOOP_GAIN = 0.25f;
+  static constexpr float BOW_SMOOTHING = 0.002f;
+  static constexpr float STRING_TAIL_CUTOFF = 1.0e-4f;
+  static constexpr float DC_BLOCKER_POLE = 0.995f;
+
+  // Per-string state
+  alignas(SIMD_ALIGNMENT) std::array<int32_t, MAX_WAVEGUIDE_VOICES> delay{};
+  alignas(SIMD_ALIGNMENT) std::array<int32_t, MAX_WAVEGUIDE_VOICES> bowDelay{};
+  VoiceLaneArray allpassCoeff;
+  VoiceLaneArray allpassIn;
+  VoiceLaneArray allpassOut;
+  VoiceLaneArray lowpassCurrent;
+  VoiceLaneArray lowpassPrevious;
+  VoiceLaneArray lowpassIn;
+  VoiceLaneArray loopGain;
+  VoiceLaneArray releaseGain;
+  VoiceLaneArray bowing; // 1 for bowed strings, 0 for plucked ones
+  VoiceLaneArray bowVelocity;
+  VoiceLaneArray bowTarget;
+  VoiceLaneArray bowSlope;
+  VoiceLaneArray blockerIn;
+  VoiceLaneArray blockerOut;
+  VoiceLaneArray outputGain;
+  VoiceLaneArray peak;
+  std::array<uint8_t, MAX_WAVEGUIDE_VOICES> active{};
+  std::array<int, MAX_WAVEGUIDE_VOICES> owners{};
+
+  std::array<int, MAX_WAVEGUIDE_GROUPS> groupActiveCount{};
+  int numActiveVoices = 0;
+  juce::Random random;
+
+  // Ring arena: [group][ring index][lane], allocated in prepare
+  std::vector<float> arena;
+  std::vector<float> excitationScratch;
+  int ringSize = 0;
+  int ringMask = 0;
+  int writeIndex = 0; // shared by every ring
+  double sampleRate = 44100.0;
+
+  std::vector<float> groupMix; // [group][sample]
+  std::vector<float> monoMix;
+  int maxBlockSize = 0;
+
+  // Current chunk's work list, read by the group tasks
+  std::array<int, MAX_WAVEGUIDE_GROUPS> renderGroups{};
+  int numRenderGroups = 0;
+  int chunkSamples = 0;
+  RealtimeWorkerPool *workerPool = nullptr;
+};
+
+// ============================================================================
+// String Sound (immutable patch)
+// ============================================================================
+class WaveguideSound final : public juce::SynthesiserSound {
+public:
+  explicit WaveguideSound(const WaveguidePatch &patchToPlay)
+      : patch(patchToPlay) {}
+
+  bool appliesToNote(int /*midiNoteNumber*/) override { return true; }
+  bool appliesToChannel(int /*midiChannel*/) override { return true; }
+
+  const WaveguidePatch &getPatch() const { return patch; }
+
+private:
+  WaveguidePatch patch;
+};
+
+// ============================================================================
+// String Voice
+// ============================================================================
+class WaveguideVoice final : public juce::SynthesiserVoice {
+public:
+  WaveguideVoice(WaveguideBank &bankToUse, int voiceIndex)
+      : bank(bankToUse), ownerId(voiceIndex) {}
+
+  bool canPlaySound(juce::SynthesiserSound *sound) override {
+    return dynamic_cast<const WaveguideSound *>(sound) != nullptr;
+  }
+
+  void startNote(int midiNoteNumber, float velocity,
+                 juce::SynthesiserSound *s,
+                 int /*currentPitchWheelPosition*/) override {
+    detachSlot();
+
+    auto *sound = dynamic_cast<const WaveguideSound *>(s);
+    slot = sound != nullptr ? bank.allocateSlot(ownerId) : -1;
+    if (slot < 0) {
+      clearCurrentNote();
+      return;
+    }
+
+    bank.startVoice(slot, sound->getPatch(),
+                    juce::MidiMessage::getMidiNoteInHertz(midiNoteNumber),
+                    velocity);
+  }
+
+  void stopNote(float /*velocity*/, bool allowTailOff) override {
+    if (allowTailOff) {
+      if (ownsSlot())
+        bank.releaseVoice(slot);
+    } else {
+      detachSlot();
+      clearCurrentNote();
+    }
+  }
+
+  float getCurrentLevel() const {
+    return ownsSlot() ? bank.getVoiceLevel(slot) : 0.0f;
+  }
+
+  void pitchWheelMoved(int /*newValue*/) override {}
+  void controllerMoved(int /*controllerNumber*/, int /*newValue*/) override {}
+
+  // Audio was already rendered by the bank; only notice a culled slot here
+  void renderNextBlock(juce::AudioBuffer<float> & /*outputBuffer*/,
+                       int /*startSample*/, int /*numSamples*/) override {
+    if (isVoiceActive() && !ownsSlot()) {
+      slot = -1;
+      clearCurrentNote();
+    }
+  }
+
+  using SynthesiserVoice::renderNextBlock;
+
+private:
+  bool ownsSlot() const {
+    return slot >= 0 && bank.getSlotOwner(slot) == ownerId;
+  }
+
+  void detachSlot() {
+    if (ownsSlot())
+      bank.fadeOutVoice(slot);
+    slot = -1;
+  }
+
+  WaveguideBank &bank;
+  const int ownerId;
+  int slot = -1;
+};
+
+} // namespace Synth
+} // namespace Sphere
@@ -0,0 +1,216 @@
+/*
+  ==============================================================================
+    SphereWavetable.h
+    Band-limited mipmapped wavetables for the oscillator bank
+
+    A wavetable set holds one or more single-cycle frames. At load time each
+    frame is transformed with an FFT and resynthesized once per octave with
+    all partials above that octave's limit removed, so playback can pick a
+    mip level whose highest partial stays below Nyquist and never aliases.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../Common/SphereFFT.h"
+#include "SphereSynthTypes.h"
+#include <complex>
+#include <vector>
+
+namespace Sphere {
+namespace Synth {
+
+// ============================================================================
+// Wavetable Set (immutable after construction, shared by sounds and voices)
+// ============================================================================
+class WavetableSet final : public juce::ReferenceCountedObject {
+public:
+  using Ptr = juce::ReferenceCountedObjectPtr<WavetableSet>;
+
+  static constexpr int TABLE_ORDER = 11;
+  static constexpr int TABLE_SIZE = 1 << TABLE_ORDER; // 2048 samples / cycle
+  static constexpr int FRAME_STRIDE = TABLE_SIZE + 1; // + wrap guard point
+  static constexpr int NUM_MIP_LEVELS = TABLE_ORDER;  // 1024 .. 1 partials
+  static constexpr int MAX_FRAMES = 256;
+
+  // ========================================================================
+  // Factories (message/background thread only - these allocate and FFT)
+  // ========================================================================
+
+  // Build from frames of frameLength samples laid end to end. Frames of any
+  // length are resampled to TABLE_SIZE before band-limiting.
+  static Ptr createFromCycles(const float *samples, int numSamples,
+                              int frameLength) {
+    if (samples == nullptr || numSamples <= 0 || frameLength <= 1)
+      return nullptr;
+
+    const int numFrames =
+        juce::jlimit(1, MAX_FRAMES, numSamples / frameLength);
+
+    std::vector<std::vector<double>> cycles(static_cast<size_t>(numFrames));
+    for (int f = 0; f < numFrames; ++f)
+      cycles[f] = resampleCycle(samples + f * frameLength, frameLength);
+
+    return new WavetableSet(cycles);
+  }
+
+  // Single-cycle WAV: files whose length is a multiple of TABLE_SIZE are
+  // read as a multi-frame morph table, anything else as one cycle.
+  static Ptr createFromStream(std::unique_ptr<juce::InputStream> stream) {
+    if (stream == nullptr)
+      return nullptr;
+
+    juce::WavAudioFormat wavFormat;
+    std::unique_ptr<juce::AudioFormatReader> reader(
+        wavFormat.createReaderFor(stream.release(), true));
+
+    if (reader == nullptr || reader->lengthInSamples <= 1)
+      return nullptr;
+
+    const int numSamples = static_cast<int>(juce::jmin<juce::int64>(
+        reader->lengthInSamples, (juce::int64)TABLE_SIZE * MAX_FRAMES));
+
+    juce::AudioBuffer<float> cycleData(1, numSamples);
+    reader->read(&cycleData, 0, numSamples, 0, true, false);
+
+    const int frameLength =
+        (numSamples % TABLE_SIZE == 0) ? TABLE_SIZE : numSamples;
+    return createFromCycles(cycleData.getReadPointer(0), numSamples,
+                            frameLength);
+  }
+
+  // Built-in morph table: sine -> triangle -> saw -> square
+  static Ptr createDefault() {
+    constexpr int numFrames = 4;
+    constexpr int numHarmonics = TABLE_SIZE / 2;
+
+    std::vector<std::vector<double>> cycles(numFrames);
+    for (auto &cycle : cycles)
+      cycle.assign(TABLE_SIZE, 0.0);
+
+    for (int h = 1; h <= numHarmonics; ++h) {
+      const double sign = ((h - 1) / 2) % 2 == 0 ? 1.0 : -1.0;
+      const double amps[numFrames] = {
+          h == 1 ? 1.0 : 0.0,                                  // sine
+          (h % 2 == 1) ? sign * 8.0 / (juce::MathConstants<double>::pi *
+                                       juce::MathConstants<double>::pi *
+                                       h * h)
+                       : 0.0,                                  // triangle
+          2.0 / (juce::MathConstants<double>::pi * h),         // saw
+          (h % 2 == 1) ? 4.0 / (juce::MathConstants<double>::pi * h)
+                       : 0.0};                                 // square
+
+      for (int i = 0; i < TABLE_SIZE; ++i) {
+        const double s = std::sin(juce::MathConstants<double>::twoPi * h *
+                                  i / TABLE_SIZE);
+        for (int f = 0; f < numFrames; ++f)
+          cycles[f][i] += amps[f] * s;
+      }
+    }
+
+    return new WavetableSet(cycles);
+  }
+
+  // ========================================================================
+  // Playback accessors (audio thread)
+  // ========================================================================
+  int getNumFrames() const { return numFrames; }
+
+  // Frame data has FRAME_STRIDE samples: TABLE_SIZE plus a copy of sample 0
+  const float *getFrame(int mipLevel, int frame) const {
+    mipLevel = juce::jlimit(0, NUM_MIP_LEVELS - 1, mipLevel);
+    frame = juce::jlimit(0, numFrames - 1, frame);
+    return tables.data() +
+           (static_cast<size_t>(mipLevel) * numFrames + frame) * FRAME_STRIDE;
+  }
+
+  // Lowest mip level whose highest partial stays below Nyquist
+  static int getMipLevelForIncrement(double cyclesPerSample) {
+    int level = 0;
+    int partials = TABLE_SIZE / 2;
+    while (level < NUM_MIP_LEVELS - 1 && partials * cyclesPerSample > 0.5) {
+      partials >>= 1;
+      ++level;
+    }
+    return level;
+  }
+
+private:
+  explicit WavetableSet(const std::vector<std::vector<double>> &cycles)
+      : numFrames(static_cast<int>(cycles.size())) {
+    tables.assign(static_cast<size_t>(NUM_MIP_LEVELS) * numFrames *
+                      FRAME_STRIDE,
+                  0.0f);
+    buildMipLevels(cycles);
+  }
+
+  // Linear resample of one periodic cycle to TABLE_SIZE points
+  static std::vector<double> resampleCycle(const float *cycle, int length) {
+    std::vector<double> out(TABLE_SIZE);
+    for (int i = 0; i < TABLE_SIZE; ++i) {
+      const double pos = static_cast<double>(i) * length / TABLE_SIZE;
+      const int i0 = static_cast<int>(pos);
+      const int i1 = (i0 + 1) % length;
+      const double frac = pos - i0;
+      out[i] = cycle[i0] + frac * (cycle[i1] - cycle[i0]);
+    }
+    return out;
+  }
+
+  void buildMipLevels(const std::vector<std::vector<double>> &cycles) {
+    FFT<double> fft(TABLE_ORDER);
+    std::vector<std::vector<std::complex<double>>> spectra(cycles.size());
+
+    // Forward transforms; remove DC so voices don't click on start/stop
+    for (size_t f = 0; f < cycles.size(); ++f) {
+      auto &spectrum = spectra[f];
+      spectrum.resize(TABLE_SIZE);
+      for (int i = 0; i < TABLE_SIZE; ++i)
+        spectrum[i] = std::complex<double>(cycles[f][i], 0.0);
+
+      fft.forward(spectrum.data());
+      spectrum[0] = 0.0;
+    }
+
+    // Resynthesize each octave with partials above its limit removed
+    std::vector<std::complex<double>> work(TABLE_SIZE);
+    double peak = 0.0;
+
+    for (int level = 0; level < NUM_MIP_LEVELS; ++level) {
+      const int maxPartial = (TABLE_SIZE / 2) >> level;
+
+      for (int f = 0; f < numFrames; ++f) {
+        std::fill(work.begin(), work.end(), std::complex<double>());
+        for (int h = 1; h <= maxPartial; ++h) {
+          work[h] = spectra[f][h];
+          if (h < TABLE_SIZE / 2)
+            work[TABLE_SIZE - h] = spectra[f][TABLE_SIZE - h];
+        }
+
+        fft.inverse(work.data());
+
+        float *dest = tables.data() + (static_cast<size_t>(level) * numFrames +
+                                       f) * FRAME_STRIDE;
+        for (int i = 0; i < TABLE_SIZE; ++i) {
+          dest[i] = static_cast<float>(work[i].real());
+          if (level == 0)
+            peak = juce::jmax(peak, std::abs(work[i].real()));
+        }
+        dest[TABLE_SIZE] = dest[0];
+      }
+    }
+
+    // Normalize the whole set by the full-band peak so frames keep their
+    // relative levels and octaves don't jump in loudness
+    if (peak > 1.0e-9)
+      juce::FloatVectorOperations::multiply(
+          tables.data(), static_cast<float>(1.0 / peak),
+          static_cast<int>(tables.size()));
+  }
+
+  int numFrames = 0;
+  std::vector<float> tables; // [mipLevel][frame][FRAME_STRIDE]
+};
+
+} // namespace Synth
+} // namespace Sphere